@@ -49,6 +49,7 @@ if [ -f "/usr/bin/yum" ]; then
 	yum install -y wget which gettext unzip
 	yum install -y python3-pip
 	yum install -y zlib-devel #for libcurl
+	yum install -y libzstd-devel
 	yum install -y readline-devel patchelf
 	#yum install -y boost169-devel boost169-static
 	#export BOOST_LIBRARYDIR=/usr/lib64/boost169
@@ -67,6 +68,7 @@ elif [ -f "/usr/bin/apt" ]; then
 	apt install -y wget alien gettext unzip
 	apt install -y python3-pip
 	apt install -y zlib1g-dev #for libcurl
+	apt install -y libzstd-dev
 	apt install -y libreadline-dev patchelf
 	#apt install -y libboost-all-dev libace-dev libace
 	#apt install -y liblog4cpp5-dev
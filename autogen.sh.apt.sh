@@ -31,6 +31,9 @@ apt install -y g++ cmake make
 apt install -y libldap-dev liboath-dev
 apt install -y alien gettext unzip
 
+# compression
+apt install -y libzstd-dev
+
 # cpplint tools
 # apt install -y clang
 # apt install -y cppcheck
@@ -0,0 +1,130 @@
+#include "BufferPool.h"
+
+BufferPool::BufferPool()
+	: m_pooledBytes(0), m_heapAllocations(0), m_poolReuses(0)
+{
+}
+
+BufferPool::~BufferPool()
+{
+	for (auto &sizeClass : m_classes)
+	{
+		std::lock_guard<std::mutex> guard(sizeClass.m_mutex);
+		for (auto buffer : sizeClass.m_free)
+			delete[] buffer;
+		sizeClass.m_free.clear();
+	}
+	std::lock_guard<std::mutex> guard(m_controlMutex);
+	for (auto block : m_controlFree)
+		::operator delete(block);
+	m_controlFree.clear();
+}
+
+BufferPool &BufferPool::instance()
+{
+	static BufferPool singleton;
+	return singleton;
+}
+
+std::shared_ptr<char> BufferPool::allocate(size_t size)
+{
+	// find size class
+	size_t classIndex = 0;
+	while (classIndex < CLASS_NUM && ((size_t)1 << (classIndex + MIN_CLASS_SHIFT)) < size)
+		classIndex++;
+
+	if (classIndex == CLASS_NUM)
+	{
+		// too large to be pooled
+		m_heapAllocations++;
+		return std::shared_ptr<char>(new char[size], std::default_delete<char[]>());
+	}
+
+	const size_t classSize = (size_t)1 << (classIndex + MIN_CLASS_SHIFT);
+	char *buffer = nullptr;
+	{
+		auto &sizeClass = m_classes[classIndex];
+		std::lock_guard<std::mutex> guard(sizeClass.m_mutex);
+		if (!sizeClass.m_free.empty())
+		{
+			buffer = sizeClass.m_free.back();
+			sizeClass.m_free.pop_back();
+			m_pooledBytes -= classSize;
+		}
+	}
+	if (buffer)
+	{
+		m_poolReuses++;
+	}
+	else
+	{
+		m_heapAllocations++;
+		buffer = new char[classSize];
+	}
+	return std::shared_ptr<char>(
+		buffer, [this, classIndex](char *p)
+		{ this->release(p, classIndex); },
+		ControlAllocator<char>(this));
+}
+
+void BufferPool::release(char *buffer, size_t classIndex)
+{
+	const size_t classSize = (size_t)1 << (classIndex + MIN_CLASS_SHIFT);
+	{
+		auto &sizeClass = m_classes[classIndex];
+		std::lock_guard<std::mutex> guard(sizeClass.m_mutex);
+		// free list is bounded per class and by total bytes over all classes
+		if (sizeClass.m_free.size() < MAX_FREE_PER_CLASS && m_pooledBytes + classSize <= MAX_POOLED_BYTES)
+		{
+			sizeClass.m_free.push_back(buffer);
+			m_pooledBytes += classSize;
+			return;
+		}
+	}
+	delete[] buffer;
+}
+
+void *BufferPool::allocateControl(size_t size)
+{
+	if (size > CONTROL_SLOT_SIZE)
+		return ::operator new(size);
+	{
+		std::lock_guard<std::mutex> guard(m_controlMutex);
+		if (!m_controlFree.empty())
+		{
+			auto block = m_controlFree.back();
+			m_controlFree.pop_back();
+			return block;
+		}
+	}
+	return ::operator new(CONTROL_SLOT_SIZE);
+}
+
+void BufferPool::releaseControl(void *block, size_t size)
+{
+	if (size <= CONTROL_SLOT_SIZE)
+	{
+		std::lock_guard<std::mutex> guard(m_controlMutex);
+		if (m_controlFree.size() < MAX_FREE_CONTROL)
+		{
+			m_controlFree.push_back(block);
+			return;
+		}
+	}
+	::operator delete(block);
+}
+
+uint64_t BufferPool::heapAllocations() const
+{
+	return m_heapAllocations;
+}
+
+uint64_t BufferPool::poolReuses() const
+{
+	return m_poolReuses;
+}
+
+uint64_t BufferPool::pooledBytes() const
+{
+	return m_pooledBytes;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/// <summary>
+/// Recycled buffer pool for network frames.
+/// Buffers are grouped by power-of-two size classes, a released buffer is
+/// kept in its class free list and reused by the next allocation of the same
+/// class instead of going back to the heap. Buffers larger than the largest
+/// class are allocated and freed directly. Total bytes kept in free lists are
+/// capped, and shared_ptr control blocks are recycled as well so that a pool
+/// hit does not touch the heap.
+/// </summary>
+class BufferPool
+{
+public:
+	BufferPool();
+	virtual ~BufferPool();
+
+	static BufferPool &instance();
+
+	/// <summary>
+	/// Get a buffer with at least the given size, the buffer is returned to the pool when released
+	/// </summary>
+	std::shared_ptr<char> allocate(size_t size);
+
+	/// <summary>
+	/// Number of buffers allocated from heap
+	/// </summary>
+	uint64_t heapAllocations() const;
+	/// <summary>
+	/// Number of buffers reused from pool
+	/// </summary>
+	uint64_t poolReuses() const;
+	/// <summary>
+	/// Bytes currently kept in free lists
+	/// </summary>
+	uint64_t pooledBytes() const;
+
+private:
+	void release(char *buffer, size_t classIndex);
+	void *allocateControl(size_t size);
+	void releaseControl(void *block, size_t size);
+
+	/// <summary>
+	/// Allocator for shared_ptr control block, take storage from recycled control slots
+	/// </summary>
+	template <typename T>
+	struct ControlAllocator
+	{
+		typedef T value_type;
+		explicit ControlAllocator(BufferPool *pool) : m_pool(pool) {}
+		template <typename U>
+		ControlAllocator(const ControlAllocator<U> &other) : m_pool(other.m_pool) {}
+		T *allocate(size_t n) { return static_cast<T *>(m_pool->allocateControl(n * sizeof(T))); }
+		void deallocate(T *p, size_t n) { m_pool->releaseControl(p, n * sizeof(T)); }
+		template <typename U>
+		bool operator==(const ControlAllocator<U> &other) const { return m_pool == other.m_pool; }
+		template <typename U>
+		bool operator!=(const ControlAllocator<U> &other) const { return m_pool != other.m_pool; }
+		BufferPool *m_pool;
+	};
+
+private:
+	static constexpr size_t MIN_CLASS_SHIFT = 8;  // 256 bytes
+	static constexpr size_t MAX_CLASS_SHIFT = 20; // 1 MB
+	static constexpr size_t CLASS_NUM = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+	static constexpr size_t MAX_FREE_PER_CLASS = 64;
+	static constexpr size_t MAX_POOLED_BYTES = 32 * 1024 * 1024;
+	// shared_ptr control block with deleter and allocator fit in one slot
+	static constexpr size_t CONTROL_SLOT_SIZE = 64;
+	static constexpr size_t MAX_FREE_CONTROL = 1024;
+
+	struct SizeClass
+	{
+		std::mutex m_mutex;
+		std::vector<char *> m_free;
+	};
+	std::array<SizeClass, CLASS_NUM> m_classes;
+	std::atomic<uint64_t> m_pooledBytes;
+
+	std::mutex m_controlMutex;
+	std::vector<void *> m_controlFree;
+
+	std::atomic<uint64_t> m_heapAllocations;
+	std::atomic<uint64_t> m_poolReuses;
+};
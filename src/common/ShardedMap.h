@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+//////////////////////////////////////////////////////////////////////////
+/// Hash map split into independently locked shards
+/// Each operation only holds the lock of one shard for the duration of a
+/// hash lookup, so concurrent access to different keys seldom contend and
+/// no caller can hold a global lock while doing slow work on a value.
+//////////////////////////////////////////////////////////////////////////
+template <typename Key, typename Value, std::size_t ShardCount = 16, typename Hash = std::hash<Key>>
+class ShardedMap
+{
+public:
+	/// <summary>
+	/// Insert or replace a value
+	/// </summary>
+	void insert(const Key &key, const Value &value)
+	{
+		auto &shard = getShard(key);
+		std::lock_guard<std::mutex> guard(shard.m_mutex);
+		shard.m_map[key] = value;
+	}
+
+	/// <summary>
+	/// Remove a value
+	/// </summary>
+	/// <returns>true if key existed</returns>
+	bool erase(const Key &key)
+	{
+		auto &shard = getShard(key);
+		std::lock_guard<std::mutex> guard(shard.m_mutex);
+		return shard.m_map.erase(key) > 0;
+	}
+
+	/// <summary>
+	/// Lookup a value and invoke visitor while the shard lock is held,
+	/// visitor should be short (e.g. copy value or increase reference count)
+	/// </summary>
+	/// <returns>true if key found and visitor invoked</returns>
+	bool find(const Key &key, const std::function<void(Value &)> &visitor)
+	{
+		auto &shard = getShard(key);
+		std::lock_guard<std::mutex> guard(shard.m_mutex);
+		auto iter = shard.m_map.find(key);
+		if (iter == shard.m_map.end())
+			return false;
+		visitor(iter->second);
+		return true;
+	}
+
+	std::size_t size() const
+	{
+		std::size_t total = 0;
+		for (auto &shard : m_shards)
+		{
+			std::lock_guard<std::mutex> guard(shard.m_mutex);
+			total += shard.m_map.size();
+		}
+		return total;
+	}
+
+private:
+	struct Shard
+	{
+		mutable std::mutex m_mutex;
+		std::unordered_map<Key, Value, Hash> m_map;
+	};
+
+	Shard &getShard(const Key &key)
+	{
+		return m_shards[Hash()(key) % ShardCount];
+	}
+
+	std::array<Shard, ShardCount> m_shards;
+};
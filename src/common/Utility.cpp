@@ -492,12 +492,14 @@ std::string Utility::readFileCpp(const std::string &path, long *position, long m
 			if (readLine)
 			{
 				stdoutReadStream.getline(temp.get(), maxSize);
+				buffer << temp.get();
 			}
 			else
 			{
-				stdoutReadStream.readsome(temp.get(), maxSize);
+				// a full read is not null terminated, use read count
+				const auto readSize = stdoutReadStream.readsome(temp.get(), maxSize);
+				buffer.write(temp.get(), readSize);
 			}
-			buffer << temp.get();
 		}
 		else if (maxSize == 0)
 		{
@@ -110,9 +110,12 @@ std::shared_ptr<T> make_shared_array(size_t size)
 #define DEFAULT_PROM_LISTEN_PORT 0
 #define DEFAULT_REST_LISTEN_PORT 6060
 #define DEFAULT_TCP_REST_LISTEN_PORT 6059
+#define REST_UNIX_SOCKET_PERMISSION 0600
 #define DEFAULT_SCHEDULE_INTERVAL 2
 #define DEFAULT_HTTP_THREAD_POOL_SIZE 6
+#define DEFAULT_TCP_REACTOR_THREAD_POOL_SIZE 2
 #define REST_REQUEST_TIMEOUT_SECONDS 60
+#define REST_QUEUE_RETRY_AFTER_SECONDS 1
 
 #define JWT_USER_KEY "mesh123"
 #define JWT_USER_NAME "mesh"
@@ -122,15 +125,41 @@ std::shared_ptr<T> make_shared_array(size_t size)
 #define MAX_COMMAND_LINE_LENGTH 2048
 // The first 4 bytes of the protocol buffer data contains the size of the following body data.
 constexpr size_t PROTOBUF_HEADER_LENGTH = 4;
-constexpr size_t BLOCK_CHUNK_SIZE = 1024 * 4;
+// File download chunk size, large chunk reduce syscalls, each chunk is sent in one reactor notification.
+constexpr size_t DEFAULT_TCP_FILE_CHUNK_SIZE = 1024 * 1024;
+constexpr size_t MIN_TCP_FILE_CHUNK_SIZE = 1024 * 4;
+// File upload: received chunks are coalesced to buffer and written behind by background thread.
+constexpr size_t TCP_UPLOAD_BUFFER_SIZE = 1024 * 1024;
+constexpr size_t TCP_UPLOAD_PENDING_BUFFERS = 8;
+constexpr uint64_t TCP_UPLOAD_PROGRESS_BYTES = 1024 * 1024 * 64;
+// Max bytes coalesced into one socket write for queued TCP responses.
+constexpr size_t TCP_SEND_BATCH_SIZE = 1024 * 64;
+// Body chunk size of streamed response, each chunk is sent as one frame.
+constexpr size_t RESPONSE_STREAM_CHUNK_SIZE = 1024 * 64;
+// Streamed response writer waits while connection send queue hold more bytes than this, and stops after timeout.
+constexpr size_t RESPONSE_STREAM_HIGH_WATER = 1024 * 1024;
+constexpr int RESPONSE_STREAM_SEND_TIMEOUT_SECONDS = 30;
 constexpr size_t MAX_TCP_BLOCK_SIZE = 10 * 1024 * 1024 * 8;
+// Highest bit of the frame length header marks a zstd compressed body, MAX_TCP_BLOCK_SIZE never reach it.
+constexpr uint32_t TCP_FRAME_COMPRESSED_FLAG = 0x80000000;
+// Response frame smaller than this is not worth compress.
+constexpr size_t TCP_FRAME_COMPRESS_THRESHOLD = 1024 * 16;
+constexpr int TCP_FRAME_COMPRESS_LEVEL = 1;
 constexpr auto TCP_SSL_VERSION_LIST = "tlsv1.2,tlsv1.3";
+// TLS session resumption: server session cache entries and default session / ticket lifetime in seconds.
+constexpr auto TCP_SSL_SESSION_ID_CONTEXT = "appmesh";
+constexpr long TCP_SSL_SESSION_CACHE_SIZE = 1024;
+constexpr int DEFAULT_SSL_SESSION_TIMEOUT = 7200;
+// verified JWT claims cache entries
+constexpr size_t MAX_JWT_CLAIMS_CACHE_SIZE = 1024;
 
 #define DEFAULT_LABEL_HOST_NAME "HOST_NAME"
 #define SNAPSHOT_FILE_NAME ".snapshot"
 #define APPMESH_LOCAL_HOST_URL "https://localhost:6060"
 #define HTTP_USER_AGENT_APPMESH_GO "appmeshsdk"
 #define TCP_JSON_MSG_FILE "file"
+#define TCP_JSON_MSG_FILE_OFFSET "offset"
+#define TCP_JSON_MSG_FILE_LENGTH "length"
 
 const char *GET_STATUS_STR(unsigned int status);
 const nlohmann::json EMPTY_STR_JSON(nullptr);
@@ -247,6 +276,7 @@ public:
 #define JSON_KEY_RestListenPort "RestListenPort"
 #define JSON_KEY_RestListenAddress "RestListenAddress"
 #define JSON_KEY_RestTcpPort "RestTcpPort"
+#define JSON_KEY_RestUnixSocket "RestUnixSocket"
 #define JSON_KEY_DockerProxyListenAddr "DockerProxyListenAddr"
 #define JSON_KEY_PrometheusExporterListenPort "PrometheusExporterListenPort"
 
@@ -262,6 +292,8 @@ public:
 #define JSON_KEY_SSLClientCertificateFile "SSLClientCertificateFile"
 #define JSON_KEY_SSLClientCertificateKeyFile "SSLClientCertificateKeyFile"
 #define JSON_KEY_SSLCaPath "SSLCaPath"
+#define JSON_KEY_SSLSessionTimeout "SSLSessionTimeout"
+#define JSON_KEY_SSLKernelOffload "SSLKernelOffload"
 
 #define JSON_KEY_JWT "JWT"
 #define JSON_KEY_JWTSalt "JWTSalt"
@@ -269,6 +301,9 @@ public:
 #define JSON_KEY_SECURITY_Interface "SecurityInterface"
 
 #define JSON_KEY_HttpThreadPoolSize "HttpThreadPoolSize"
+#define JSON_KEY_TcpReactorThreadPoolSize "TcpReactorThreadPoolSize"
+#define JSON_KEY_TcpFileChunkSize "TcpFileChunkSize"
+#define JSON_KEY_TcpUploadSync "TcpUploadSync"
 #define JSON_KEY_Roles "Roles"
 #define JSON_KEY_Groups "Groups"
 #define JSON_KEY_Labels "Labels"
@@ -310,6 +345,11 @@ public:
 #define JSON_KEY_APP_from_recover "from_recover"
 #define JSON_KEY_APP_starts "starts"
 
+#define JSON_KEY_WATCH_revision "revision"
+#define JSON_KEY_WATCH_reset "reset"
+#define JSON_KEY_WATCH_applications "applications"
+#define JSON_KEY_WATCH_removed "removed"
+
 #define JSON_KEY_APP_behavior "behavior"
 #define JSON_KEY_APP_behavior_exit "exit"
 #define JSON_KEY_APP_behavior_control "control"
@@ -390,6 +430,12 @@ public:
 #define HTTP_HEADER_KEY_file_user "File-User"
 #define HTTP_HEADER_KEY_file_group "File-Group"
 #define HTTP_HEADER_KEY_delegate_host "X-Target-Host"
+#define HTTP_HEADER_KEY_request_timeout "X-Request-Timeout"
+#define HTTP_HEADER_KEY_frame_compression "X-Frame-Compression"
+#define HTTP_HEADER_VALUE_frame_compression_zstd "zstd"
+#define HTTP_HEADER_KEY_wire_schema "X-Wire-Schema"
+#define HTTP_HEADER_KEY_response_stream "X-Response-Stream"
+#define HTTP_HEADER_KEY_next_cursor "Next-Cursor"
 #define HTTP_BODY_KEY_MFA_URI "Mfa-Uri"
 
 #define HTTP_QUERY_KEY_stdout_position "stdout_position"
@@ -405,6 +451,14 @@ public:
 #define HTTP_QUERY_KEY_action_stop "disable"
 #define HTTP_QUERY_KEY_loglevel "level"
 #define HTTP_QUERY_KEY_label_value "value"
+#define HTTP_QUERY_KEY_revision "revision"
+#define HTTP_QUERY_KEY_status "status"
+#define HTTP_QUERY_KEY_owner "owner"
+#define HTTP_QUERY_KEY_label "label"
+#define HTTP_QUERY_KEY_name_prefix "name_prefix"
+#define HTTP_QUERY_KEY_cursor "cursor"
+#define HTTP_QUERY_KEY_limit "limit"
+#define HTTP_QUERY_KEY_fields "fields"
 
 #define PERMISSION_KEY_view_app "app-view"
 #define PERMISSION_KEY_view_app_output "app-output-view"
@@ -9,10 +9,12 @@
 #include "Configuration.h"
 #include "Label.h"
 #include "ResourceCollection.h"
+#include "application/AppSupervisor.h"
 #include "application/Application.h"
 #include "consul/ConsulConnection.h"
 #include "rest/PrometheusRest.h"
 #include "rest/RestHandler.h"
+#include "security/JwtClaimsCache.h"
 #include "security/Security.h"
 #include "security/User.h"
 
@@ -166,23 +168,16 @@ nlohmann::json Configuration::AsJson()
 	return result;
 }
 
-std::vector<std::shared_ptr<Application>> Configuration::getApps() const
+std::shared_ptr<const AppSnapshot> Configuration::getApps() const
 {
-	std::vector<std::shared_ptr<Application>> apps;
-	apps.reserve(m_apps.current_size());
-
-	ACE_Guard<ACE_Recursive_Thread_Mutex> guard(m_apps.mutex());
-	for (const auto &entry : m_apps)
-	{
-		apps.push_back(entry.int_id_);
-	}
-	return apps;
+	return m_apps.snapshot();
 }
 
-void Configuration::addApp2Map(std::shared_ptr<Application> app)
+void Configuration::addApp2Map(const std::vector<std::shared_ptr<Application>> &apps)
 {
 	const static char fname[] = "Configuration::addApp2Map() ";
-	if (m_apps.bind(app->getName(), app) == 1)
+	// one registry copy for all loaded applications
+	for (const auto &app : m_apps.add(apps))
 	{
 		LOG_ERR << fname << "Application <" << app->getName() << "> already exist.";
 	}
@@ -230,53 +225,102 @@ int Configuration::getRestTcpPort()
 	return m_rest->m_restTcpPort;
 }
 
+std::string Configuration::getRestUnixSocket()
+{
+	std::lock_guard<std::recursive_mutex> guard(m_hotupdateMutex);
+	return m_rest->m_restUnixSocket;
+}
+
 nlohmann::json Configuration::serializeApplication(bool returnRuntimeInfo, const std::string &user, bool returnUnPersistApp) const
 {
-	auto allApp = getApps();
+	return serializeApplication(getUserApps(user, returnUnPersistApp), returnRuntimeInfo);
+}
+
+std::vector<std::shared_ptr<Application>> Configuration::getUserApps(const std::string &user, bool returnUnPersistApp) const
+{
+	const auto allApp = getApps();
 	std::vector<std::shared_ptr<Application>> apps;
-	std::copy_if(allApp.begin(), allApp.end(), std::back_inserter(apps),
+	std::copy_if(allApp->begin(), allApp->end(), std::back_inserter(apps),
 				 [this, &user, returnUnPersistApp](std::shared_ptr<Application> app)
 				 {
 					 return (checkOwnerPermission(user, app->getOwner(), app->getOwnerPermission(), false) &&			 // access permission check
 							 ((returnUnPersistApp) || (!returnUnPersistApp && app->isPersistAble())) &&					 // status filter
 							 (app->getName() != SEPARATE_REST_APP_NAME) && (app->getName() != SEPARATE_AGENT_APP_NAME)); // not expose rest process
 				 });
+	return apps;
+}
 
+nlohmann::json Configuration::serializeApplication(const std::vector<std::shared_ptr<Application>> &apps, bool returnRuntimeInfo)
+{
 	auto result = nlohmann::json::array();
 	// Build Json
 	if (returnRuntimeInfo)
 	{
-		std::list<os::Process> ptree = os::processes();
-		for (std::size_t i = 0; i < apps.size(); ++i)
+		for (const auto &app : apps)
 		{
-			result.push_back(apps[i]->AsJson(returnRuntimeInfo, (void *)(&ptree)));
+			result.push_back(*app->AsRuntimeJson());
 		}
 	}
 	else
 	{
-		for (std::size_t i = 0; i < apps.size(); ++i)
+		for (const auto &app : apps)
 		{
-			result[i] = apps[i]->AsJson(returnRuntimeInfo);
+			result.push_back(app->AsJson(returnRuntimeInfo));
 		}
 	}
 
 	return result;
 }
 
+std::string Configuration::runtimeETag(const std::vector<std::shared_ptr<Application>> &apps, bool sampleUsage, const std::string &variant)
+{
+	// one process tree scan for all applications with expired resource usage
+	std::list<os::Process> ptree;
+	for (const auto &app : apps)
+	{
+		if (sampleUsage && app->usageExpired())
+		{
+			if (ptree.empty())
+				ptree = os::processes();
+			app->sampleUsage((void *)(&ptree));
+		}
+	}
+
+	// FNV-1a over name and revision of each application
+	uint64_t hash = 14695981039346656037ULL;
+	const auto fnv = [&hash](const void *data, size_t size)
+	{
+		const auto bytes = static_cast<const unsigned char *>(data);
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+	};
+	fnv(variant.data(), variant.length());
+	for (const auto &app : apps)
+	{
+		const auto revision = app->getRevision();
+		fnv(app->getName().data(), app->getName().length() + 1);
+		fnv(&revision, sizeof(revision));
+	}
+	return Utility::stringFormat("\"%016llx\"", static_cast<unsigned long long>(hash));
+}
+
 void Configuration::loadApps(const boost::filesystem::path &appDir)
 {
 	const static char fname[] = "Configuration::loadApps() ";
 
 	if (fs::exists(appDir) && fs::is_directory(appDir))
 	{
+		std::vector<std::shared_ptr<Application>> apps;
 		// parse YAML format
 		for (const auto &jsonFile : fs::directory_iterator(appDir))
 		{
 			if (Utility::endWith(jsonFile.path().filename().string(), ".yml") || Utility::endWith(jsonFile.path().filename().string(), ".yaml"))
 			{
 				LOG_INF << fname << "loading <" << jsonFile.path().filename() << ">.";
-				auto app = this->parseApp(Utility::yamlToJson(YAML::LoadFile(jsonFile.path().string())));
-				this->addApp2Map(app);
+				apps.push_back(this->parseApp(Utility::yamlToJson(YAML::LoadFile(jsonFile.path().string()))));
 			}
 		}
 		// parse JSON format
@@ -285,10 +329,10 @@ void Configuration::loadApps(const boost::filesystem::path &appDir)
 			if (Utility::endWith(jsonFile.path().filename().string(), ".json"))
 			{
 				LOG_INF << fname << "loading <" << jsonFile.path().filename() << ">.";
-				auto app = this->parseApp(nlohmann::json::parse(std::ifstream(jsonFile.path().string())));
-				this->addApp2Map(app);
+				apps.push_back(this->parseApp(nlohmann::json::parse(std::ifstream(jsonFile.path().string()))));
 			}
 		}
+		this->addApp2Map(apps);
 	}
 	else
 	{
@@ -356,6 +400,18 @@ std::string Configuration::getSSLCaPath() const
 	return m_rest->m_ssl->m_sslCaPath;
 }
 
+int Configuration::getSSLSessionTimeout() const
+{
+	std::lock_guard<std::recursive_mutex> guard(m_hotupdateMutex);
+	return m_rest->m_ssl->m_sessionTimeout;
+}
+
+bool Configuration::getSSLKernelOffload() const
+{
+	std::lock_guard<std::recursive_mutex> guard(m_hotupdateMutex);
+	return m_rest->m_ssl->m_kernelOffload;
+}
+
 bool Configuration::getRestEnabled() const
 {
 	std::lock_guard<std::recursive_mutex> guard(m_hotupdateMutex);
@@ -368,6 +424,24 @@ std::size_t Configuration::getThreadPoolSize() const
 	return m_rest->m_httpThreadPoolSize;
 }
 
+std::size_t Configuration::getReactorThreadPoolSize() const
+{
+	std::lock_guard<std::recursive_mutex> guard(m_hotupdateMutex);
+	return m_rest->m_tcpReactorThreadPoolSize;
+}
+
+std::size_t Configuration::getTcpFileChunkSize() const
+{
+	std::lock_guard<std::recursive_mutex> guard(m_hotupdateMutex);
+	return m_rest->m_tcpFileChunkSize;
+}
+
+std::string Configuration::getTcpUploadSync() const
+{
+	std::lock_guard<std::recursive_mutex> guard(m_hotupdateMutex);
+	return m_rest->m_tcpUploadSync;
+}
+
 const std::string Configuration::getDescription() const
 {
 	std::lock_guard<std::recursive_mutex> guard(m_hotupdateMutex);
@@ -443,8 +517,8 @@ void Configuration::dump()
 	LOG_DBG << fname << '\n'
 			<< Utility::prettyJson(this->AsJson().dump());
 
-	auto apps = getApps();
-	for (auto &app : apps)
+	const auto apps = getApps();
+	for (const auto &app : *apps)
 	{
 		app->dump();
 	}
@@ -459,7 +533,9 @@ std::shared_ptr<Application> Configuration::addApp(const nlohmann::json &jsonApp
 		oldApp->disable();
 		oldApp.reset();
 	}
-	m_apps.rebind(app->getName(), app, oldApp);
+	m_apps.replace(app);
+	// notify watchers after application is visible
+	app->bumpRevision();
 
 	// Write to disk
 	if (!persistable)
@@ -475,8 +551,10 @@ std::shared_ptr<Application> Configuration::addApp(const nlohmann::json &jsonApp
 		app->initMetrics();
 	}
 
-	// invoke immediately
+	// invoke immediately, then supervisor keeps its schedule
 	app->execute();
+	if (const auto &supervisor = AppSupervisor::instance())
+		supervisor->schedule(app->getName(), app->nextEvaluation());
 	app->dump();
 	return app;
 }
@@ -486,13 +564,14 @@ void Configuration::removeApp(const std::string &appName)
 	const static char fname[] = "Configuration::removeApp() ";
 
 	LOG_DBG << fname << appName;
-	std::shared_ptr<Application> app;
-	m_apps.unbind(appName, app);
+	auto app = m_apps.remove(appName);
 	if (app)
 	{
 		// Write to disk
 		app->destroy();
 		app->remove();
+		// notify watchers after application is unbound
+		app->bumpRevision();
 		LOG_DBG << fname << "removed " << appName;
 	}
 }
@@ -579,12 +658,20 @@ void Configuration::hotUpdate(nlohmann::json &jsonValue)
 				SET_COMPARE(this->m_rest->m_restListenPort, newConfig->m_rest->m_restListenPort);
 			if (HAS_JSON_FIELD(rest, JSON_KEY_RestTcpPort))
 				SET_COMPARE(this->m_rest->m_restTcpPort, newConfig->m_rest->m_restTcpPort);
+			if (HAS_JSON_FIELD(rest, JSON_KEY_RestUnixSocket))
+				SET_COMPARE(this->m_rest->m_restUnixSocket, newConfig->m_rest->m_restUnixSocket);
 			if (HAS_JSON_FIELD(rest, JSON_KEY_DockerProxyListenAddr))
 				SET_COMPARE(this->m_rest->m_dockerProxyListenAddr, newConfig->m_rest->m_dockerProxyListenAddr);
 			if (HAS_JSON_FIELD(rest, JSON_KEY_RestListenAddress))
 				SET_COMPARE(this->m_rest->m_restListenAddress, newConfig->m_rest->m_restListenAddress);
 			if (HAS_JSON_FIELD(rest, JSON_KEY_HttpThreadPoolSize))
 				SET_COMPARE(this->m_rest->m_httpThreadPoolSize, newConfig->m_rest->m_httpThreadPoolSize);
+			if (HAS_JSON_FIELD(rest, JSON_KEY_TcpReactorThreadPoolSize))
+				SET_COMPARE(this->m_rest->m_tcpReactorThreadPoolSize, newConfig->m_rest->m_tcpReactorThreadPoolSize);
+			if (HAS_JSON_FIELD(rest, JSON_KEY_TcpFileChunkSize))
+				SET_COMPARE(this->m_rest->m_tcpFileChunkSize, newConfig->m_rest->m_tcpFileChunkSize);
+			if (HAS_JSON_FIELD(rest, JSON_KEY_TcpUploadSync))
+				SET_COMPARE(this->m_rest->m_tcpUploadSync, newConfig->m_rest->m_tcpUploadSync);
 			if (HAS_JSON_FIELD(rest, JSON_KEY_PrometheusExporterListenPort) && (this->m_rest->m_promListenPort != newConfig->m_rest->m_promListenPort))
 			{
 				SET_COMPARE(this->m_rest->m_promListenPort, newConfig->m_rest->m_promListenPort);
@@ -607,14 +694,22 @@ void Configuration::hotUpdate(nlohmann::json &jsonValue)
 					SET_COMPARE(this->m_rest->m_ssl->m_sslVerifyServer, newConfig->m_rest->m_ssl->m_sslVerifyServer);
 				if (HAS_JSON_FIELD(ssl, JSON_KEY_SSLVerifyClient))
 					SET_COMPARE(this->m_rest->m_ssl->m_sslVerifyClient, newConfig->m_rest->m_ssl->m_sslVerifyClient);
+				if (HAS_JSON_FIELD(ssl, JSON_KEY_SSLSessionTimeout))
+					SET_COMPARE(this->m_rest->m_ssl->m_sessionTimeout, newConfig->m_rest->m_ssl->m_sessionTimeout);
+				if (HAS_JSON_FIELD(ssl, JSON_KEY_SSLKernelOffload))
+					SET_COMPARE(this->m_rest->m_ssl->m_kernelOffload, newConfig->m_rest->m_ssl->m_kernelOffload);
 			}
 
 			// JWT
 			if (HAS_JSON_FIELD(rest, JSON_KEY_JWT))
 			{
 				auto sec = rest.at(JSON_KEY_JWT);
-				if (HAS_JSON_FIELD(sec, JSON_KEY_JWTSalt))
+				if (HAS_JSON_FIELD(sec, JSON_KEY_JWTSalt) && this->m_rest->m_jwt->m_jwtSalt != newConfig->m_rest->m_jwt->m_jwtSalt)
+				{
 					SET_COMPARE(this->m_rest->m_jwt->m_jwtSalt, newConfig->m_rest->m_jwt->m_jwtSalt);
+					// tokens signed with old salt are no longer valid
+					JWT_CLAIMS_CACHE::instance()->clear();
+				}
 				if (HAS_JSON_FIELD(sec, JSON_KEY_JWTIssuer))
 					SET_COMPARE(this->m_rest->m_jwt->m_jwtIssuer, newConfig->m_rest->m_jwt->m_jwtIssuer);
 				if (HAS_JSON_FIELD(sec, JSON_KEY_SECURITY_Interface))
@@ -727,8 +822,8 @@ bool Configuration::applyEnvConfig(nlohmann::json &jsonValue, std::string envVal
 
 void Configuration::registerPrometheus()
 {
-	auto allApp = getApps();
-	for (const auto &app : allApp)
+	const auto allApp = getApps();
+	for (const auto &app : *allApp)
 		app->initMetrics();
 }
 
@@ -747,8 +842,8 @@ std::shared_ptr<Application> Configuration::parseApp(const nlohmann::json &jsonA
 std::shared_ptr<Application> Configuration::getApp(const std::string &appName, bool throwOnNotFound) const
 {
 	const static char fname[] = "Configuration::getApp() ";
-	std::shared_ptr<Application> app;
-	if (m_apps.find(appName, app) == 0 && app)
+	const auto apps = getApps();
+	if (const auto &app = apps->find(appName))
 		return app;
 
 	if (throwOnNotFound)
@@ -761,18 +856,12 @@ std::shared_ptr<Application> Configuration::getApp(const std::string &appName, b
 
 std::shared_ptr<Application> Configuration::getApp(const void *app) const
 {
-	ACE_Guard<ACE_Recursive_Thread_Mutex> guard(m_apps.mutex());
-	for (const auto &entry : m_apps)
-	{
-		if (app == entry.int_id_.get())
-			return entry.int_id_;
-	}
-	return nullptr;
+	return getApps()->find(app);
 }
 
 bool Configuration::isAppExist(const std::string &appName)
 {
-	return (m_apps.find(appName) == 0);
+	return getApps()->find(appName) != nullptr;
 }
 
 const nlohmann::json Configuration::getAgentAppJson() const
@@ -814,6 +903,7 @@ std::shared_ptr<Configuration::JsonRest> Configuration::JsonRest::FromJson(const
 	rest->m_restListenPort = GET_JSON_INT_VALUE(jsonValue, JSON_KEY_RestListenPort);
 	rest->m_restListenAddress = GET_JSON_STR_VALUE(jsonValue, JSON_KEY_RestListenAddress);
 	rest->m_restTcpPort = GET_JSON_INT_VALUE(jsonValue, JSON_KEY_RestTcpPort);
+	rest->m_restUnixSocket = GET_JSON_STR_VALUE(jsonValue, JSON_KEY_RestUnixSocket);
 	rest->m_dockerProxyListenAddr = GET_JSON_STR_VALUE(jsonValue, JSON_KEY_DockerProxyListenAddr);
 	rest->m_dockerProxyListenAddr = Utility::stringReplace(rest->m_dockerProxyListenAddr, "https", "http");
 	SET_JSON_BOOL_VALUE(jsonValue, JSON_KEY_RestEnabled, rest->m_restEnabled);
@@ -823,6 +913,17 @@ std::shared_ptr<Configuration::JsonRest> Configuration::JsonRest::FromJson(const
 	{
 		rest->m_httpThreadPoolSize = threadpool;
 	}
+	auto reactorPool = GET_JSON_INT_VALUE(jsonValue, JSON_KEY_TcpReactorThreadPoolSize);
+	if (reactorPool > 0 && reactorPool < 40)
+	{
+		rest->m_tcpReactorThreadPoolSize = reactorPool;
+	}
+	auto chunkSize = GET_JSON_INT_VALUE(jsonValue, JSON_KEY_TcpFileChunkSize);
+	if (chunkSize >= (int)MIN_TCP_FILE_CHUNK_SIZE && chunkSize <= (int)MAX_TCP_BLOCK_SIZE)
+	{
+		rest->m_tcpFileChunkSize = chunkSize;
+	}
+	rest->m_tcpUploadSync = GET_JSON_STR_VALUE(jsonValue, JSON_KEY_TcpUploadSync);
 	if (rest->m_restListenPort < 1000 || rest->m_restListenPort > 65534)
 	{
 		rest->m_restListenPort = DEFAULT_REST_LISTEN_PORT;
@@ -895,10 +996,14 @@ nlohmann::json Configuration::JsonRest::AsJson() const
 	auto result = nlohmann::json::object();
 	result[JSON_KEY_RestEnabled] = (m_restEnabled);
 	result[JSON_KEY_HttpThreadPoolSize] = ((uint32_t)m_httpThreadPoolSize);
+	result[JSON_KEY_TcpReactorThreadPoolSize] = ((uint32_t)m_tcpReactorThreadPoolSize);
+	result[JSON_KEY_TcpFileChunkSize] = ((uint32_t)m_tcpFileChunkSize);
+	result[JSON_KEY_TcpUploadSync] = std::string(m_tcpUploadSync);
 	result[JSON_KEY_RestListenPort] = (m_restListenPort);
 	result[JSON_KEY_PrometheusExporterListenPort] = (m_promListenPort);
 	result[JSON_KEY_RestListenAddress] = std::string(m_restListenAddress);
 	result[JSON_KEY_RestTcpPort] = (m_restTcpPort);
+	result[JSON_KEY_RestUnixSocket] = std::string(m_restUnixSocket);
 	result[JSON_KEY_DockerProxyListenAddr] = std::string(m_dockerProxyListenAddr);
 	// SSL
 	result[JSON_KEY_SSL] = m_ssl->AsJson();
@@ -909,7 +1014,8 @@ nlohmann::json Configuration::JsonRest::AsJson() const
 }
 
 Configuration::JsonRest::JsonRest()
-	: m_restEnabled(false), m_httpThreadPoolSize(DEFAULT_HTTP_THREAD_POOL_SIZE),
+	: m_restEnabled(false), m_httpThreadPoolSize(DEFAULT_HTTP_THREAD_POOL_SIZE), m_tcpReactorThreadPoolSize(DEFAULT_TCP_REACTOR_THREAD_POOL_SIZE),
+	  m_tcpFileChunkSize(DEFAULT_TCP_FILE_CHUNK_SIZE),
 	  m_restListenPort(DEFAULT_REST_LISTEN_PORT), m_promListenPort(DEFAULT_PROM_LISTEN_PORT),
 	  m_restTcpPort(DEFAULT_TCP_REST_LISTEN_PORT)
 {
@@ -928,6 +1034,8 @@ std::shared_ptr<Configuration::JsonSsl> Configuration::JsonSsl::FromJson(const n
 	ssl->m_clientCertFile = GET_JSON_STR_VALUE(jsonValue, JSON_KEY_SSLClientCertificateFile);
 	ssl->m_clientCertKeyFile = GET_JSON_STR_VALUE(jsonValue, JSON_KEY_SSLClientCertificateKeyFile);
 	ssl->m_sslCaPath = GET_JSON_STR_VALUE(jsonValue, JSON_KEY_SSLCaPath);
+	SET_JSON_INT_VALUE(jsonValue, JSON_KEY_SSLSessionTimeout, ssl->m_sessionTimeout);
+	SET_JSON_BOOL_VALUE(jsonValue, JSON_KEY_SSLKernelOffload, ssl->m_kernelOffload);
 	if (!Utility::isFileExist(ssl->m_certFile) && jsonValue.contains(JSON_KEY_SSLCertificateFile))
 	{
 		LOG_WAR << fname << "SSLCertificateFile not exist: " << ssl->m_certFile;
@@ -956,11 +1064,13 @@ nlohmann::json Configuration::JsonSsl::AsJson() const
 	result[JSON_KEY_SSLClientCertificateFile] = std::string(m_clientCertFile);
 	result[JSON_KEY_SSLClientCertificateKeyFile] = std::string(m_clientCertKeyFile);
 	result[JSON_KEY_SSLCaPath] = std::string(m_sslCaPath);
+	result[JSON_KEY_SSLSessionTimeout] = (m_sessionTimeout);
+	result[JSON_KEY_SSLKernelOffload] = (m_kernelOffload);
 	return result;
 }
 
 Configuration::JsonSsl::JsonSsl()
-	: m_sslVerifyServer(false), m_sslVerifyClient(false)
+	: m_sslVerifyServer(false), m_sslVerifyClient(false), m_sessionTimeout(DEFAULT_SSL_SESSION_TIMEOUT), m_kernelOffload(false)
 {
 }
 
@@ -6,10 +6,11 @@
 #include <string>
 #include <vector>
 
-#include <ace/Map_Manager.h>
 #include <ace/Recursive_Thread_Mutex.h>
 #include <nlohmann/json.hpp>
 
+#include "application/AppRegistry.h"
+
 class RestHandler;
 class User;
 class Label;
@@ -46,6 +47,8 @@ public:
 		std::string m_clientCertFile;
 		std::string m_clientCertKeyFile;
 		std::string m_sslCaPath;
+		int m_sessionTimeout;
+		bool m_kernelOffload;
 		JsonSsl();
 	};
 
@@ -69,10 +72,14 @@ public:
 
 		bool m_restEnabled;
 		int m_httpThreadPoolSize;
+		int m_tcpReactorThreadPoolSize;
+		int m_tcpFileChunkSize;
+		std::string m_tcpUploadSync;
 		int m_restListenPort;
 		int m_promListenPort;
 		std::string m_restListenAddress;
 		int m_restTcpPort;
+		std::string m_restUnixSocket;
 		std::string m_dockerProxyListenAddr;
 		std::shared_ptr<JsonSsl> m_ssl;
 		std::shared_ptr<JsonJwt> m_jwt;
@@ -120,7 +127,10 @@ public:
 	void registerPrometheus();
 	bool prometheusEnabled() const;
 
-	std::vector<std::shared_ptr<Application>> getApps() const;
+	/// <summary>
+	/// Registered applications, an immutable snapshot iterated without copy or lock
+	/// </summary>
+	std::shared_ptr<const AppSnapshot> getApps() const;
 	std::shared_ptr<Application> addApp(const nlohmann::json &jsonApp, std::shared_ptr<Application> fromApp = nullptr, bool persistable = true);
 	void removeApp(const std::string &appName);
 	std::shared_ptr<Application> parseApp(const nlohmann::json &jsonApp);
@@ -132,7 +142,20 @@ public:
 	std::string getRestJwtIssuer();
 	std::string getDockerProxyAddress() const;
 	int getRestTcpPort();
+	std::string getRestUnixSocket();
 	nlohmann::json serializeApplication(bool returnRuntimeInfo, const std::string &user, bool returnUnPersistApp) const;
+	std::vector<std::shared_ptr<Application>> getUserApps(const std::string &user, bool returnUnPersistApp) const;
+	/// <summary>
+	/// Serialize applications, runtime JSON of each application is served from its revision cache
+	/// </summary>
+	static nlohmann::json serializeApplication(const std::vector<std::shared_ptr<Application>> &apps, bool returnRuntimeInfo);
+	/// <summary>
+	/// Entity tag of applications runtime view, computed from name and revision of each application.
+	/// Expired resource usage is sampled first with one process scan, so usage change is reflected.
+	/// </summary>
+	/// <param name="sampleUsage">false when resource usage is not part of the view</param>
+	/// <param name="variant">request options that change the representation of the same applications</param>
+	static std::string runtimeETag(const std::vector<std::shared_ptr<Application>> &apps, bool sampleUsage = true, const std::string &variant = std::string());
 	std::shared_ptr<Application> getApp(const std::string &appName, bool throwOnNotFound = true) const noexcept(false);
 	std::shared_ptr<Application> getApp(const void *app) const;
 	bool isAppExist(const std::string &appName);
@@ -150,8 +173,13 @@ public:
 	std::string getSSLCertificateFile() const;
 	std::string getSSLCertificateKeyFile() const;
 	std::string getSSLCaPath() const;
+	int getSSLSessionTimeout() const;
+	bool getSSLKernelOffload() const;
 	bool getRestEnabled() const;
 	std::size_t getThreadPoolSize() const;
+	std::size_t getReactorThreadPoolSize() const;
+	std::size_t getTcpFileChunkSize() const;
+	std::string getTcpUploadSync() const;
 	const std::string getDescription() const;
 	const std::string getPosixTimezone() const;
 
@@ -162,10 +190,10 @@ public:
 	void dump();
 
 private:
-	void addApp2Map(std::shared_ptr<Application> app);
+	void addApp2Map(const std::vector<std::shared_ptr<Application>> &apps);
 
 private:
-	mutable ACE_Map_Manager<std::string, std::shared_ptr<Application>, ACE_Recursive_Thread_Mutex> m_apps;
+	AppRegistry m_apps;
 	std::shared_ptr<BaseConfig> m_baseConfig;
 	std::shared_ptr<JsonRest> m_rest;
 	std::shared_ptr<JsonConsul> m_consul;
@@ -15,8 +15,8 @@ HealthCheckTask::~HealthCheckTask()
 void HealthCheckTask::doHealthCheck()
 {
 	const static char fname[] = "HealthCheckTask::doHealthCheck() ";
-	auto apps = Configuration::instance()->getApps();
-	for (auto &app : apps)
+	const auto apps = Configuration::instance()->getApps();
+	for (const auto &app : *apps)
 	{
 		if (app->healthCheckCmd().empty())
 			continue;
@@ -26,8 +26,8 @@ PersistManager::~PersistManager()
 std::shared_ptr<Snapshot> PersistManager::captureSnapshot()
 {
 	auto snap = std::make_shared<Snapshot>();
-	auto apps = Configuration::instance()->getApps();
-	for (auto &app : apps)
+	const auto apps = Configuration::instance()->getApps();
+	for (const auto &app : *apps)
 	{
 		if (!app->isEnabled() || app->getName() == SEPARATE_AGENT_APP_NAME || app->getName() == SEPARATE_REST_APP_NAME)
 			continue;
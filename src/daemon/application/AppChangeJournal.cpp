@@ -0,0 +1,95 @@
+#include "AppChangeJournal.h"
+
+constexpr size_t APP_CHANGE_JOURNAL_CAPACITY = 4096;
+
+AppChangeJournal::AppChangeJournal()
+	: m_sequence(0), m_floor(0), m_capacity(APP_CHANGE_JOURNAL_CAPACITY), m_watcherSequence(0)
+{
+}
+
+AppChangeJournal::~AppChangeJournal()
+{
+}
+
+uint64_t AppChangeJournal::nextRevision()
+{
+	return ++m_sequence;
+}
+
+uint64_t AppChangeJournal::record(const std::string &appName, const std::shared_ptr<User> &owner, int ownerPermission)
+{
+	uint64_t revision = 0;
+	std::map<uint64_t, Watcher> watchers;
+	{
+		// allocate under lock so entries are appended in revision order
+		std::lock_guard<std::mutex> guard(m_mutex);
+		revision = ++m_sequence;
+		m_entries.push_back(AppChange{revision, appName, owner, ownerPermission});
+		while (m_entries.size() > m_capacity)
+		{
+			m_floor = m_entries.front().m_revision;
+			m_entries.pop_front();
+		}
+		// every registered watcher waits for a revision lower than this one
+		watchers.swap(m_watchers);
+	}
+	for (const auto &watcher : watchers)
+	{
+		watcher.second();
+	}
+	return revision;
+}
+
+uint64_t AppChangeJournal::revision() const
+{
+	return m_sequence.load();
+}
+
+bool AppChangeJournal::changes(uint64_t revision, std::map<std::string, AppChange> &appChanges) const
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	if (revision < m_floor)
+	{
+		return false;
+	}
+	// newest first, the latest change of an application wins
+	for (auto it = m_entries.rbegin(); it != m_entries.rend() && it->m_revision > revision; ++it)
+	{
+		appChanges.emplace(it->m_appName, *it);
+	}
+	return true;
+}
+
+uint64_t AppChangeJournal::watch(uint64_t revision, Watcher watcher)
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	if (revision < m_floor || (!m_entries.empty() && m_entries.back().m_revision > revision))
+	{
+		return 0;
+	}
+	const auto watcherId = ++m_watcherSequence;
+	m_watchers.emplace(watcherId, std::move(watcher));
+	return watcherId;
+}
+
+void AppChangeJournal::unwatch(uint64_t watcherId)
+{
+	Watcher watcher;
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		const auto iter = m_watchers.find(watcherId);
+		if (iter == m_watchers.end())
+		{
+			return;
+		}
+		watcher = std::move(iter->second);
+		m_watchers.erase(iter);
+	}
+	// captured state is released outside lock
+}
+
+size_t AppChangeJournal::watcherCount() const
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return m_watchers.size();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <ace/Null_Mutex.h>
+#include <ace/Singleton.h>
+
+class User;
+
+/// <summary>
+/// One application change, owner and permission are kept so a removed application
+/// is only reported to users who could view it
+/// </summary>
+struct AppChange
+{
+	uint64_t m_revision;
+	std::string m_appName;
+	std::shared_ptr<User> m_owner;
+	int m_ownerPermission;
+};
+
+/// <summary>
+/// Bounded in-memory journal of application changes, each entry is a global revision and an application name.
+/// Revisions come from one sequence shared by all applications, so a client can remember the last
+/// revision it has seen and ask for names changed (added, updated or removed) after it.
+/// Oldest entries are dropped when full, a client older than the dropped range needs a full resync.
+/// </summary>
+class AppChangeJournal
+{
+public:
+	typedef std::function<void()> Watcher;
+
+	AppChangeJournal();
+	virtual ~AppChangeJournal();
+
+	/// <summary>
+	/// Allocate a revision without journal entry, used for changes not notified to watchers
+	/// </summary>
+	uint64_t nextRevision();
+	/// <summary>
+	/// Allocate a revision, record application change and call watchers
+	/// </summary>
+	uint64_t record(const std::string &appName, const std::shared_ptr<User> &owner, int ownerPermission);
+	/// <summary>
+	/// Latest revision
+	/// </summary>
+	uint64_t revision() const;
+
+	/// <summary>
+	/// Latest change of each application changed after given revision
+	/// </summary>
+	/// <param name="appChanges">changes keyed by application name</param>
+	/// <returns>false when changes after revision are no longer retained</returns>
+	bool changes(uint64_t revision, std::map<std::string, AppChange> &appChanges) const;
+	/// <summary>
+	/// Register a one-shot watcher called on the next recorded change,
+	/// watcher is called on the recording thread and must not block
+	/// </summary>
+	/// <returns>watcher id, 0 when there is already change after revision and watcher is not registered</returns>
+	uint64_t watch(uint64_t revision, Watcher watcher);
+	void unwatch(uint64_t watcherId);
+	size_t watcherCount() const;
+
+private:
+	mutable std::mutex m_mutex;
+	std::atomic<uint64_t> m_sequence;
+	// ascending by revision
+	std::deque<AppChange> m_entries;
+	// highest revision dropped from journal
+	uint64_t m_floor;
+	const size_t m_capacity;
+	std::map<uint64_t, Watcher> m_watchers;
+	uint64_t m_watcherSequence;
+};
+
+typedef ACE_Singleton<AppChangeJournal, ACE_Null_Mutex> APP_CHANGE_JOURNAL;
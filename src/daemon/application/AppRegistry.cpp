@@ -0,0 +1,169 @@
+#include <unordered_set>
+
+#include "AppRegistry.h"
+#include "Application.h"
+
+// returned by reference for not found
+static const std::shared_ptr<Application> NULL_APP;
+
+AppSnapshot::AppSnapshot()
+	: m_version(0)
+{
+}
+
+AppSnapshot::~AppSnapshot()
+{
+}
+
+uint64_t AppSnapshot::version() const
+{
+	return m_version;
+}
+
+size_t AppSnapshot::size() const
+{
+	return m_apps.size();
+}
+
+bool AppSnapshot::empty() const
+{
+	return m_apps.empty();
+}
+
+AppSnapshot::const_iterator AppSnapshot::begin() const
+{
+	return m_apps.begin();
+}
+
+AppSnapshot::const_iterator AppSnapshot::end() const
+{
+	return m_apps.end();
+}
+
+const std::shared_ptr<Application> &AppSnapshot::find(const std::string &appName) const
+{
+	const auto iter = m_nameIndex.find(appName);
+	return iter == m_nameIndex.end() ? NULL_APP : m_apps[iter->second];
+}
+
+const std::shared_ptr<Application> &AppSnapshot::find(const void *app) const
+{
+	const auto iter = m_addressIndex.find(app);
+	return iter == m_addressIndex.end() ? NULL_APP : m_apps[iter->second];
+}
+
+void AppSnapshot::index()
+{
+	m_nameIndex.clear();
+	m_addressIndex.clear();
+	m_nameIndex.reserve(m_apps.size());
+	m_addressIndex.reserve(m_apps.size());
+	for (size_t i = 0; i < m_apps.size(); i++)
+	{
+		m_nameIndex[m_apps[i]->getName()] = i;
+		m_addressIndex[m_apps[i].get()] = i;
+	}
+}
+
+AppRegistry::AppRegistry()
+	: m_snapshot(std::make_shared<AppSnapshot>())
+{
+}
+
+AppRegistry::~AppRegistry()
+{
+}
+
+std::shared_ptr<const AppSnapshot> AppRegistry::snapshot() const
+{
+	return std::atomic_load(&m_snapshot);
+}
+
+bool AppRegistry::add(const std::shared_ptr<Application> &app)
+{
+	std::lock_guard<std::mutex> guard(m_writeMutex);
+	const auto current = snapshot();
+	if (current->find(app->getName()))
+	{
+		return false;
+	}
+	auto next = clone(*current);
+	next->m_apps.push_back(app);
+	publish(std::move(next));
+	return true;
+}
+
+std::vector<std::shared_ptr<Application>> AppRegistry::add(const std::vector<std::shared_ptr<Application>> &apps)
+{
+	std::lock_guard<std::mutex> guard(m_writeMutex);
+	const auto current = snapshot();
+	auto next = clone(*current);
+	std::unordered_set<std::string> names;
+	std::vector<std::shared_ptr<Application>> rejected;
+	for (const auto &app : apps)
+	{
+		if (current->find(app->getName()) || !names.insert(app->getName()).second)
+		{
+			rejected.push_back(app);
+			continue;
+		}
+		next->m_apps.push_back(app);
+	}
+	if (rejected.size() < apps.size())
+	{
+		publish(std::move(next));
+	}
+	return rejected;
+}
+
+std::shared_ptr<Application> AppRegistry::replace(const std::shared_ptr<Application> &app)
+{
+	std::lock_guard<std::mutex> guard(m_writeMutex);
+	const auto current = snapshot();
+	auto next = clone(*current);
+	std::shared_ptr<Application> replaced;
+	const auto iter = current->m_nameIndex.find(app->getName());
+	if (iter != current->m_nameIndex.end())
+	{
+		replaced = next->m_apps[iter->second];
+		next->m_apps[iter->second] = app;
+	}
+	else
+	{
+		next->m_apps.push_back(app);
+	}
+	publish(std::move(next));
+	return replaced;
+}
+
+std::shared_ptr<Application> AppRegistry::remove(const std::string &appName)
+{
+	std::lock_guard<std::mutex> guard(m_writeMutex);
+	const auto current = snapshot();
+	const auto iter = current->m_nameIndex.find(appName);
+	if (iter == current->m_nameIndex.end())
+	{
+		return nullptr;
+	}
+	auto next = clone(*current);
+	auto removed = next->m_apps[iter->second];
+	next->m_apps.erase(next->m_apps.begin() + iter->second);
+	publish(std::move(next));
+	return removed;
+}
+
+std::shared_ptr<AppSnapshot> AppRegistry::clone(const AppSnapshot &snapshot)
+{
+	// indexes are rebuilt by publish
+	auto copy = std::make_shared<AppSnapshot>();
+	copy->m_version = snapshot.m_version;
+	copy->m_apps = snapshot.m_apps;
+	return copy;
+}
+
+void AppRegistry::publish(std::shared_ptr<AppSnapshot> snapshot)
+{
+	snapshot->m_version++;
+	snapshot->index();
+	std::atomic_store(&m_snapshot, std::shared_ptr<const AppSnapshot>(std::move(snapshot)));
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Application;
+
+/// <summary>
+/// Immutable view of registered applications, indexed by name and by object address.
+/// Held by readers for lookup and iteration without lock, never changed after published.
+/// </summary>
+class AppSnapshot
+{
+public:
+	typedef std::vector<std::shared_ptr<Application>>::const_iterator const_iterator;
+
+	AppSnapshot();
+	virtual ~AppSnapshot();
+
+	/// <summary>
+	/// Increased by each registry change
+	/// </summary>
+	uint64_t version() const;
+	size_t size() const;
+	bool empty() const;
+	const_iterator begin() const;
+	const_iterator end() const;
+
+	/// <returns>nullptr when not found</returns>
+	const std::shared_ptr<Application> &find(const std::string &appName) const;
+	/// <returns>nullptr when not found</returns>
+	const std::shared_ptr<Application> &find(const void *app) const;
+
+private:
+	friend class AppRegistry;
+	/// <summary>
+	/// Build indexes from m_apps, only used before publish
+	/// </summary>
+	void index();
+
+	uint64_t m_version;
+	// registration order, a replaced application keeps the position
+	std::vector<std::shared_ptr<Application>> m_apps;
+	std::unordered_map<std::string, size_t> m_nameIndex;
+	std::unordered_map<const void *, size_t> m_addressIndex;
+};
+
+/// <summary>
+/// Copy-on-write application registry (RCU style).
+/// Writers are serialized, each change copies current snapshot and publishes a new version,
+/// readers load the current snapshot atomically.
+/// </summary>
+class AppRegistry
+{
+public:
+	AppRegistry();
+	virtual ~AppRegistry();
+
+	/// <summary>
+	/// Current snapshot, lock free
+	/// </summary>
+	std::shared_ptr<const AppSnapshot> snapshot() const;
+
+	/// <summary>
+	/// Register a new application
+	/// </summary>
+	/// <returns>false when an application with the same name exist</returns>
+	bool add(const std::shared_ptr<Application> &app);
+	/// <summary>
+	/// Register new applications with one copy and one publish, used for bulk load
+	/// </summary>
+	/// <returns>applications not registered because the same name exist</returns>
+	std::vector<std::shared_ptr<Application>> add(const std::vector<std::shared_ptr<Application>> &apps);
+	/// <summary>
+	/// Register application, replace the one with the same name
+	/// </summary>
+	/// <returns>replaced application, nullptr for none</returns>
+	std::shared_ptr<Application> replace(const std::shared_ptr<Application> &app);
+	/// <summary>
+	/// Unregister application
+	/// </summary>
+	/// <returns>removed application, nullptr for none</returns>
+	std::shared_ptr<Application> remove(const std::string &appName);
+
+private:
+	static std::shared_ptr<AppSnapshot> clone(const AppSnapshot &snapshot);
+	void publish(std::shared_ptr<AppSnapshot> snapshot);
+
+	std::mutex m_writeMutex;
+	std::shared_ptr<const AppSnapshot> m_snapshot;
+};
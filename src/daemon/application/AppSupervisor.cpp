@@ -0,0 +1,217 @@
+#include <algorithm>
+
+#include <prometheus/counter.h>
+#include <prometheus/histogram.h>
+
+#include "../../common/Utility.h"
+#include "../rest/PrometheusRest.h"
+#include "AppSupervisor.h"
+
+// shard pass slower than this is reported with its slowest application
+constexpr double APP_SUPERVISOR_SLOW_SHARD_SECONDS = 1.0;
+
+AppSupervisor::AppSupervisor(Evaluator evaluator, size_t workers)
+	: m_evaluator(std::move(evaluator)), m_exit(false), m_evaluations(0)
+{
+	for (size_t i = 0; i < std::max(workers, (size_t)1); i++)
+	{
+		m_shards.emplace_back(new Shard());
+	}
+}
+
+AppSupervisor::~AppSupervisor()
+{
+	m_exit = true;
+	for (auto &shard : m_shards)
+	{
+		// lock so that a worker between exit check and wait does not miss the notification
+		std::lock_guard<std::mutex> guard(shard->m_mutex);
+		shard->m_cond.notify_all();
+	}
+	for (auto &worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+AppSupervisor::Shard &AppSupervisor::shard(const std::string &appName)
+{
+	// same application always goes to the same shard
+	return *m_shards[std::hash<std::string>()(appName) % m_shards.size()];
+}
+
+void AppSupervisor::notify(const std::string &appName)
+{
+	schedule(appName, std::chrono::system_clock::now());
+}
+
+void AppSupervisor::schedule(const std::string &appName, const TimePoint &due)
+{
+	if (due == TimePoint::max())
+	{
+		return;
+	}
+	auto &appShard = shard(appName);
+	{
+		std::lock_guard<std::mutex> guard(appShard.m_mutex);
+		const auto iter = appShard.m_due.find(appName);
+		if (iter != appShard.m_due.end() && iter->second <= due)
+		{
+			return;
+		}
+		appShard.m_due[appName] = due;
+		appShard.m_deadlines.emplace(due, appName);
+	}
+	appShard.m_cond.notify_one();
+}
+
+size_t AppSupervisor::run(const TimePoint &until)
+{
+	// workers start with the first run, nothing is evaluated before daemon is ready to supervise
+	for (size_t i = m_workers.size() + 1; i < m_shards.size(); i++)
+	{
+		m_workers.emplace_back(&AppSupervisor::runShard, this, i, TimePoint::max());
+	}
+	const size_t evaluations = m_evaluations;
+	runShard(0, until);
+	return m_evaluations - evaluations;
+}
+
+void AppSupervisor::runShard(size_t index, const TimePoint &until)
+{
+	auto &shard = *m_shards[index];
+	std::unique_lock<std::mutex> lock(shard.m_mutex);
+	while (!m_exit)
+	{
+		// drop deadlines replaced by an earlier schedule
+		while (!shard.m_deadlines.empty())
+		{
+			const auto &top = shard.m_deadlines.top();
+			const auto due = shard.m_due.find(top.second);
+			if (due != shard.m_due.end() && due->second == top.first)
+				break;
+			shard.m_deadlines.pop();
+		}
+
+		// return at deadline even when applications keep being due, caller has maintenance to do
+		const auto now = std::chrono::system_clock::now();
+		if (now >= until)
+		{
+			break;
+		}
+		if (!shard.m_deadlines.empty() && shard.m_deadlines.top().first <= now)
+		{
+			// take all due applications of this shard as one pass
+			std::vector<std::string> dueApps;
+			while (!shard.m_deadlines.empty() && shard.m_deadlines.top().first <= now)
+			{
+				const auto &top = shard.m_deadlines.top();
+				const auto due = shard.m_due.find(top.second);
+				if (due != shard.m_due.end() && due->second == top.first)
+				{
+					dueApps.push_back(top.second);
+					shard.m_due.erase(due);
+				}
+				shard.m_deadlines.pop();
+			}
+
+			// evaluate without lock, event during evaluation schedule it again
+			lock.unlock();
+			runPass(index, dueApps);
+			lock.lock();
+			continue;
+		}
+
+		const auto wakeup = shard.m_deadlines.empty() ? until : std::min(until, shard.m_deadlines.top().first);
+		if (wakeup == TimePoint::max())
+		{
+			shard.m_cond.wait(lock);
+		}
+		else
+		{
+			shard.m_cond.wait_until(lock, wakeup);
+		}
+	}
+}
+
+void AppSupervisor::runPass(size_t index, const std::vector<std::string> &dueApps)
+{
+	const static char fname[] = "AppSupervisor::runPass() ";
+
+	const auto passStart = std::chrono::steady_clock::now();
+	std::vector<TimePoint> next(dueApps.size(), TimePoint::max());
+	double slowestSeconds = 0;
+	std::string slowestApp;
+	for (size_t i = 0; i < dueApps.size(); i++)
+	{
+		const auto &appName = dueApps[i];
+		const auto start = std::chrono::steady_clock::now();
+		try
+		{
+			next[i] = m_evaluator(appName);
+		}
+		catch (const std::exception &e)
+		{
+			LOG_ERR << fname << "Application <" << appName << "> evaluate failed with error: " << e.what();
+		}
+		catch (...)
+		{
+			LOG_ERR << fname << "Application <" << appName << "> evaluate failed with error " << std::strerror(errno);
+		}
+		const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		if (m_evaluateSeconds)
+		{
+			m_evaluateSeconds->metric().Observe(seconds);
+		}
+		if (seconds > slowestSeconds)
+		{
+			slowestSeconds = seconds;
+			slowestApp = appName;
+		}
+	}
+	for (size_t i = 0; i < dueApps.size(); i++)
+	{
+		schedule(dueApps[i], next[i]);
+	}
+	m_evaluations += dueApps.size();
+
+	const auto passSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - passStart).count();
+	if (m_passSeconds)
+	{
+		m_passSeconds->metric().Observe(passSeconds);
+	}
+	if (passSeconds > APP_SUPERVISOR_SLOW_SHARD_SECONDS)
+	{
+		if (m_slowShards)
+		{
+			m_slowShards->metric().Increment();
+		}
+		LOG_WAR << fname << "shard <" << index << "> evaluated " << dueApps.size() << " applications in " << passSeconds
+				<< " seconds, slowest application <" << slowestApp << "> took " << slowestSeconds << " seconds";
+	}
+	LOG_DBG << fname << "shard <" << index << "> evaluated " << dueApps.size() << " applications in " << passSeconds << " seconds";
+}
+
+size_t AppSupervisor::scheduledCount() const
+{
+	size_t count = 0;
+	for (const auto &shard : m_shards)
+	{
+		std::lock_guard<std::mutex> guard(shard->m_mutex);
+		count += shard->m_due.size();
+	}
+	return count;
+}
+
+void AppSupervisor::metrics(std::shared_ptr<HistogramMetric> passSeconds, std::shared_ptr<HistogramMetric> evaluateSeconds, std::shared_ptr<CounterMetric> slowShards)
+{
+	m_passSeconds = std::move(passSeconds);
+	m_evaluateSeconds = std::move(evaluateSeconds);
+	m_slowShards = std::move(slowShards);
+}
+
+std::unique_ptr<AppSupervisor> &AppSupervisor::instance()
+{
+	static std::unique_ptr<AppSupervisor> singleton;
+	return singleton;
+}
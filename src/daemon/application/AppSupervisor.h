@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class CounterMetric;
+class HistogramMetric;
+
+/// <summary>
+/// Event driven application supervisor.
+/// An application is evaluated only when it is due: at the time returned by its last evaluation
+/// (deadline heap), or at once after a state transition event (process exit, enable, disable, register).
+/// An idle application has no deadline and cost nothing until an event arrives.
+/// Applications are sharded by name hash, each shard has its own deadline heap and evaluation loop,
+/// so a slow evaluation only delays applications of the same shard.
+/// One application is always in one shard so it is never evaluated concurrently.
+/// </summary>
+class AppSupervisor
+{
+public:
+	typedef std::chrono::system_clock::time_point TimePoint;
+	/// <summary>
+	/// Evaluate application and return time of next evaluation, TimePoint::max() for idle
+	/// </summary>
+	typedef std::function<TimePoint(const std::string &appName)> Evaluator;
+
+	/// <param name="workers">number of shards evaluated in parallel, caller thread of run() evaluates the first one</param>
+	explicit AppSupervisor(Evaluator evaluator, size_t workers = 1);
+	virtual ~AppSupervisor();
+
+	/// <summary>
+	/// State transition event, evaluate application as soon as possible
+	/// </summary>
+	void notify(const std::string &appName);
+	/// <summary>
+	/// Evaluate application at given time, an earlier pending schedule of the same application is kept,
+	/// TimePoint::max() is ignored
+	/// </summary>
+	void schedule(const std::string &appName, const TimePoint &due);
+	/// <summary>
+	/// Evaluate due applications of the first shard until deadline, wake up on event or next due time,
+	/// applications still due at deadline are left for next run.
+	/// Other shards are evaluated by worker threads continuously after the first run.
+	/// </summary>
+	/// <returns>number of evaluations of all shards during this run</returns>
+	size_t run(const TimePoint &until);
+	/// <summary>
+	/// Number of applications with pending evaluation
+	/// </summary>
+	size_t scheduledCount() const;
+	/// <summary>
+	/// Export shard pass duration, per application evaluation latency and slow shard passes, set before run()
+	/// </summary>
+	void metrics(std::shared_ptr<HistogramMetric> passSeconds, std::shared_ptr<HistogramMetric> evaluateSeconds, std::shared_ptr<CounterMetric> slowShards);
+
+	/// <summary>
+	/// Supervisor of daemon, created by main, nullptr before that
+	/// </summary>
+	static std::unique_ptr<AppSupervisor> &instance();
+
+private:
+	typedef std::pair<TimePoint, std::string> Deadline;
+	struct Shard
+	{
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		// earliest deadline on top, entry is stale when it does not equal m_due of the application
+		std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> m_deadlines;
+		std::unordered_map<std::string, TimePoint> m_due;
+	};
+	Shard &shard(const std::string &appName);
+	/// <summary>
+	/// Evaluate due applications of one shard until deadline or exit
+	/// </summary>
+	void runShard(size_t index, const TimePoint &until);
+	/// <summary>
+	/// Evaluate due applications of one shard and schedule them again, called without shard lock
+	/// </summary>
+	void runPass(size_t index, const std::vector<std::string> &dueApps);
+
+	const Evaluator m_evaluator;
+	std::vector<std::unique_ptr<Shard>> m_shards;
+	// worker threads of m_shards[1..], started by first run()
+	std::vector<std::thread> m_workers;
+	std::atomic<bool> m_exit;
+	std::atomic<size_t> m_evaluations;
+
+	std::shared_ptr<HistogramMetric> m_passSeconds;
+	std::shared_ptr<HistogramMetric> m_evaluateSeconds;
+	std::shared_ptr<CounterMetric> m_slowShards;
+};
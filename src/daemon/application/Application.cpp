@@ -2,6 +2,7 @@
 #include <assert.h>
 #include <limits>
 
+#include <ace/OS_NS_sys_stat.h>
 #include <boost/smart_ptr/make_shared.hpp>
 #include <prometheus/counter.h>
 #include <prometheus/gauge.h>
@@ -22,10 +23,14 @@
 #include "../rest/RestHandler.h"
 #include "../security/Security.h"
 #include "../security/User.h"
+#include "AppChangeJournal.h"
+#include "AppSupervisor.h"
 #include "AppTimer.h"
 #include "Application.h"
 
 constexpr int INVALID_RETURN_CODE = std::numeric_limits<int>::min();
+// resource usage in cached runtime JSON is sampled at most once in this period
+constexpr int APP_RESOURCE_USAGE_REFRESH_SECONDS = 5;
 
 Application::Application()
 	: m_persistAble(true), m_ownerPermission(0), m_metadata(EMPTY_STR_JSON),
@@ -34,7 +39,9 @@ Application::Application()
 	  m_startInterval(0), m_bufferTime(0), m_startIntervalValueIsCronExpr(false),
 	  m_nextStartTimerId(INVALID_TIMER_ID), m_regTime(std::chrono::system_clock::now()), m_appId(Utility::createUUID()),
 	  m_version(0), m_suicideTimerId(INVALID_TIMER_ID),
-	  m_pid(ACE_INVALID_PID), m_return(INVALID_RETURN_CODE), m_health(true), m_status(STATUS::ENABLED), m_starts(std::make_shared<prometheus::Counter>())
+	  m_pid(ACE_INVALID_PID), m_return(INVALID_RETURN_CODE), m_health(true), m_status(STATUS::ENABLED),
+	  m_runtime(std::make_shared<AppRuntime>()), m_usage(std::make_shared<AppUsage>()),
+	  m_revision(APP_CHANGE_JOURNAL::instance()->nextRevision()), m_starts(std::make_shared<prometheus::Counter>())
 {
 	const static char fname[] = "Application::Application() ";
 	LOG_DBG << fname << "Entered.";
@@ -88,7 +95,8 @@ const std::string &Application::getName() const
 
 void Application::health(bool health)
 {
-	m_health = health; // health: 0-health, 1-unhealthy
+	if (m_health.exchange(health) != health) // health: 0-health, 1-unhealthy
+		bumpRevision();
 }
 
 pid_t Application::getpid() const
@@ -131,6 +139,12 @@ STATUS Application::getStatus() const
 	return m_status.load();
 }
 
+const nlohmann::json &Application::getMetadata() const
+{
+	// metadata is not changed after FromJson
+	return m_metadata;
+}
+
 bool Application::isPersistAble() const
 {
 	return m_persistAble;
@@ -143,7 +157,7 @@ void Application::setUnPersistable()
 
 bool Application::available(const std::chrono::system_clock::time_point &now)
 {
-	std::lock_guard<std::recursive_mutex> guard(m_appMutex);
+	// end time is spec and status is atomic, no lock
 	// check expired
 	if (m_endTime != AppTimer::EPOCH_ZERO_TIME && m_endTime != std::chrono::system_clock::time_point::max() && now >= m_endTime)
 	{
@@ -354,6 +368,7 @@ bool Application::attach(int pid)
 		LOG_INF << fname << "attached pid <" << pid << "> to application " << m_name << ", last start on: " << DateTime::formatLocalTime(*m_procStartTime);
 		if (m_process->running())
 			checkProcStdoutFile = m_process;
+		publishRuntime();
 	}
 	// registerCheckStdoutTimer() outside of m_appMutex
 	if (checkProcStdoutFile)
@@ -366,6 +381,20 @@ void Application::execute(void *ptree)
 	const static char fname[] = "Application::execute() ";
 	auto now = std::chrono::system_clock::now();
 	bool scheduleNextRun = false; // the first time to start the event chain
+
+	// attached process exit is handled the same as child process exit notification
+	std::shared_ptr<AppProcess> exitedProcess;
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_appMutex);
+		if (m_process && m_process->attachedExited())
+			exitedProcess = m_process;
+	}
+	if (exitedProcess)
+	{
+		LOG_INF << fname << "attached process of application <" << m_name << "> exited";
+		onExitUpdate(exitedProcess->returnValue());
+	}
+
 	if (this->available(now))
 	{
 		auto inDailyRange = m_timer->isInDailyTimeRange(now);
@@ -377,6 +406,7 @@ void Application::execute(void *ptree)
 			terminate(m_process);
 			setInvalidError();
 			m_nextLaunchTime.reset();
+			publishRuntime();
 		}
 		scheduleNextRun = (m_nextLaunchTime == nullptr);
 	}
@@ -390,6 +420,7 @@ void Application::execute(void *ptree)
 			terminate(m_process);
 			setInvalidError();
 			m_nextLaunchTime.reset();
+			publishRuntime();
 		}
 	}
 
@@ -408,6 +439,29 @@ void Application::execute(void *ptree)
 	}
 }
 
+std::chrono::system_clock::time_point Application::nextEvaluation(const std::chrono::system_clock::time_point &now)
+{
+	auto next = std::chrono::system_clock::time_point::max();
+	std::lock_guard<std::recursive_mutex> guard(m_appMutex);
+	if (m_status == STATUS::NOTAVIALABLE)
+	{
+		return next;
+	}
+	// periodic work: daily time range check, buffer process clean, prometheus metrics,
+	// exit of attached process (recovered pid, docker container, image pull) which is not a child
+	if (m_dailyLimit || m_bufferProcess || Configuration::instance()->prometheusEnabled() || (m_process && m_process->attached()))
+	{
+		next = now + std::chrono::seconds(Configuration::instance()->getScheduleInterval());
+	}
+	// terminate when end time reached
+	if (m_endTime != AppTimer::EPOCH_ZERO_TIME && m_endTime != std::chrono::system_clock::time_point::max() && now < m_endTime)
+	{
+		next = std::min(next, m_endTime);
+	}
+	// child process exit, enable, disable and register are notified by event
+	return next;
+}
+
 void Application::spawn()
 {
 	const static char fname[] = "Application::spawn() ";
@@ -442,6 +496,7 @@ void Application::spawn()
 		m_pid = m_process->spawnProcess(getCmdLine(), execUser, m_workdir, getMergedEnvMap(), m_resourceLimit, m_stdoutFile, m_metadata, APP_STD_OUT_MAX_FILE_SIZE, sudoSwitchUser);
 		if (m_pid.load() > 0)
 			checkProcStdoutFile = m_process;
+		publishRuntime();
 
 		// 3. post process
 		setLastError(m_process->startError());
@@ -475,21 +530,29 @@ void Application::disable()
 	if (m_status.compare_exchange_strong(enabled, STATUS::DISABLED))
 	{
 		LOG_INF << fname << "Application <" << m_name << "> disabled.";
+		bumpRevision();
 	}
 	// kill process
 	terminate(m_process);
 	m_nextLaunchTime.reset();
+	publishRuntime();
 	setInvalidError();
 
 	save();
+	if (const auto &supervisor = AppSupervisor::instance())
+		supervisor->notify(m_name);
 }
 
 void Application::enable()
 {
 	auto disabled = STATUS::DISABLED;
-	m_status.compare_exchange_strong(disabled, STATUS::ENABLED);
+	if (m_status.compare_exchange_strong(disabled, STATUS::ENABLED))
+		bumpRevision();
 
 	save();
+	// schedule first run
+	if (const auto &supervisor = AppSupervisor::instance())
+		supervisor->notify(m_name);
 }
 
 std::string Application::runAsyncrize(int timeoutSeconds)
@@ -535,6 +598,10 @@ std::string Application::runApp(int timeoutSeconds)
 	m_procStartTime = boost::make_shared<std::chrono::system_clock::time_point>(std::chrono::system_clock::now());
 	bool sudoSwitchUser = (m_shellAppFile != nullptr && Utility::startWith(m_shellAppFile->getShellStartCmd(), "/usr/bin/sudo"));
 	m_pid = m_process->spawnProcess(getCmdLine(), execUser, m_workdir, getMergedEnvMap(), m_resourceLimit, m_stdoutFile, m_metadata, APP_STD_OUT_MAX_FILE_SIZE, sudoSwitchUser);
+	// health is part of published runtime, set before publish so revision covers it
+	if (m_pid.load() > 0)
+		m_health = true;
+	publishRuntime();
 	// TODO: run app does not call registerCheckStdoutTimer() for now
 	setLastError(m_process->startError());
 	if (m_metricStartCount)
@@ -542,7 +609,6 @@ std::string Application::runApp(int timeoutSeconds)
 
 	if (m_pid.load() > 0)
 	{
-		m_health = true;
 		if (timeoutSeconds > 0)
 			m_process->delayKill(timeoutSeconds, __FUNCTION__);
 	}
@@ -592,40 +658,54 @@ std::tuple<std::string, bool, int> Application::getOutput(long &position, long m
 {
 	const static char fname[] = "Application::getOutput() ";
 
-	std::shared_ptr<AppProcess> process;
-	{
-		std::lock_guard<std::recursive_mutex> guard(m_appMutex);
-		process = m_process;
-	}
+	const auto runtime = getRuntime();
+	const auto &process = runtime->m_process;
 	if (process != nullptr && index == 0 && process->getuuid() == processUuid && process->running() && timeout > 0)
 	{
 		// TODO: timeout > 0 already now work, will remove related code in future.
 		process->wait(ACE_Time_Value(timeout));
 	}
 
-	std::lock_guard<std::recursive_mutex> guard(m_appMutex);
 	bool finished = false;
 	int exitCode = 0;
-	if (m_process && index == 0)
+	if (process && index == 0)
 	{
-		if (processUuid.length() && m_process->getuuid() != processUuid)
+		if (processUuid.length() && process->getuuid() != processUuid)
 		{
 			throw NotFoundException("No corresponding process running or the given process uuid is wrong");
 		}
-		if (m_process->getuuid() == processUuid)
+		if (process->getuuid() == processUuid)
 		{
-			if (!m_process->running())
+			if (!process->running())
 			{
-				exitCode = m_process->returnValue();
+				exitCode = process->returnValue();
 				finished = true;
 				LOG_DBG << fname << "process:" << processUuid << " finished with exit code: " << exitCode;
 			}
 		}
-		auto output = m_process->getOutputMsg(&position, maxSize);
+		auto output = process->getOutputMsg(&position, maxSize);
 		return std::make_tuple(output, finished, exitCode);
 	}
-	auto file = m_stdoutFileQueue->getFileName(index);
-	return std::make_tuple(Utility::readFileCpp(file, &position, maxSize), finished, exitCode);
+	if (index < 0 || index >= (int)runtime->m_stdoutFiles.size())
+	{
+		throw NotFoundException(Utility::stringFormat("no such index <%d> of stdout log file for <%s>", index, m_name.c_str()));
+	}
+	return std::make_tuple(Utility::readFileCpp(runtime->m_stdoutFiles[index], &position, maxSize), finished, exitCode);
+}
+
+long Application::getOutputSize(int index)
+{
+	const auto runtime = getRuntime();
+	if (index == 0)
+	{
+		return runtime->m_process ? runtime->m_process->getOutputSize() : -1;
+	}
+	if (index < 0 || index >= (int)runtime->m_stdoutFiles.size())
+	{
+		throw NotFoundException(Utility::stringFormat("no such index <%d> of stdout log file for <%s>", index, m_name.c_str()));
+	}
+	const auto &file = runtime->m_stdoutFiles[index];
+	return Utility::isFileExist(file) ? (long)ACE_OS::filesize(file.c_str()) : -1;
 }
 
 void Application::initMetrics()
@@ -679,17 +759,18 @@ void Application::initMetrics(std::shared_ptr<Application> fromApp)
 		m_metricMemory = fromApp->m_metricMemory;
 		m_metricCpu = fromApp->m_metricCpu;
 		m_metricFileDesc = fromApp->m_metricFileDesc;
-		m_starts = fromApp->m_starts;
+		std::atomic_store(&m_starts, std::atomic_load(&fromApp->m_starts));
 	}
 }
 
-nlohmann::json Application::AsJson(bool returnRuntimeInfo, void *ptree)
+nlohmann::json Application::AsJson(bool returnRuntimeInfo, void *ptree, bool returnUsage)
 {
 	const static char fname[] = "Application::AsJson() ";
 
 	nlohmann::json result = nlohmann::json::object();
 
-	std::lock_guard<std::recursive_mutex> guard(m_appMutex);
+	// spec is not changed after FromJson, runtime state is read from snapshot, no lock
+	const auto runtime = getRuntime();
 	LOG_DBG << fname << "application:" << m_name;
 	result[JSON_KEY_APP_name] = std::string(m_name);
 	if (m_owner)
@@ -715,13 +796,16 @@ nlohmann::json Application::AsJson(bool returnRuntimeInfo, void *ptree)
 		result[JSON_KEY_APP_metadata] = m_metadata;
 	if (returnRuntimeInfo)
 	{
-		if (m_return != INVALID_RETURN_CODE)
-			result[JSON_KEY_APP_return] = m_return.load();
-		if (m_process && m_process->running())
+		if (runtime->m_return != INVALID_RETURN_CODE)
+			result[JSON_KEY_APP_return] = runtime->m_return;
+		if (runtime->m_process && runtime->m_process->running())
 		{
-			result[JSON_KEY_APP_pid] = m_pid.load();
-			auto usage = m_process->getProcessDetails(ptree);
-			if (std::get<0>(usage))
+			result[JSON_KEY_APP_pid] = runtime->m_pid;
+			if (returnUsage && (ptree || usageExpired()))
+				sampleUsage(ptree);
+			const auto sample = std::atomic_load(&m_usage);
+			const auto &usage = sample->m_usage;
+			if (returnUsage && sample->m_pid == runtime->m_pid && std::get<0>(usage))
 			{
 				result[JSON_KEY_APP_memory] = (std::get<1>(usage));
 				result[JSON_KEY_APP_cpu] = (std::get<2>(usage));
@@ -729,17 +813,17 @@ nlohmann::json Application::AsJson(bool returnRuntimeInfo, void *ptree)
 				result[JSON_KEY_APP_pstree] = std::string(std::get<4>(usage));
 			}
 		}
-		if (m_procStartTime && std::chrono::time_point_cast<std::chrono::hours>(*m_procStartTime).time_since_epoch().count() > 24) // avoid print 1970-01-01 08:00:00
-			result[JSON_KEY_APP_last_start] = std::chrono::duration_cast<std::chrono::seconds>((*m_procStartTime).time_since_epoch()).count();
-		if (m_procExitTime && std::chrono::time_point_cast<std::chrono::hours>(*m_procExitTime).time_since_epoch().count() > 24)
-			result[JSON_KEY_APP_last_exit] = std::chrono::duration_cast<std::chrono::seconds>((*m_procExitTime).time_since_epoch()).count();
-		if (m_process && !m_process->containerId().empty())
+		if (runtime->m_procStartTime && std::chrono::time_point_cast<std::chrono::hours>(*runtime->m_procStartTime).time_since_epoch().count() > 24) // avoid print 1970-01-01 08:00:00
+			result[JSON_KEY_APP_last_start] = std::chrono::duration_cast<std::chrono::seconds>((*runtime->m_procStartTime).time_since_epoch()).count();
+		if (runtime->m_procExitTime && std::chrono::time_point_cast<std::chrono::hours>(*runtime->m_procExitTime).time_since_epoch().count() > 24)
+			result[JSON_KEY_APP_last_exit] = std::chrono::duration_cast<std::chrono::seconds>((*runtime->m_procExitTime).time_since_epoch()).count();
+		if (runtime->m_process && !runtime->m_process->containerId().empty())
 		{
-			result[JSON_KEY_APP_container_id] = std::string((m_process->containerId()));
+			result[JSON_KEY_APP_container_id] = std::string((runtime->m_process->containerId()));
 		}
 		result[JSON_KEY_APP_health] = (this->health());
-		if (m_stdoutFileQueue->size())
-			result[JSON_KEY_APP_stdout_cache_size] = (m_stdoutFileQueue->size());
+		if (runtime->m_stdoutFiles.size())
+			result[JSON_KEY_APP_stdout_cache_size] = (runtime->m_stdoutFiles.size());
 		// result[JSON_KEY_APP_id] = std::string(m_appId);
 	}
 	if (m_dailyLimit != nullptr)
@@ -782,7 +866,7 @@ nlohmann::json Application::AsJson(bool returnRuntimeInfo, void *ptree)
 		auto err = getLastError();
 		if (err.length())
 			result[JSON_KEY_APP_last_error] = std::string(err);
-		result[JSON_KEY_APP_starts] = static_cast<long long>(m_starts->Value());
+		result[JSON_KEY_APP_starts] = static_cast<long long>(std::atomic_load(&m_starts)->Value());
 	}
 
 	result[JSON_KEY_APP_behavior] = this->behaviorAsJson();
@@ -794,15 +878,98 @@ nlohmann::json Application::AsJson(bool returnRuntimeInfo, void *ptree)
 	{
 		result[JSON_KEY_SHORT_APP_start_interval_seconds] = std::string(m_startIntervalValue);
 	}
-	if (returnRuntimeInfo && m_nextLaunchTime)
+	if (returnRuntimeInfo && runtime->m_nextLaunchTime)
 	{
-		result[JSON_KEY_SHORT_APP_next_start_time] = std::chrono::duration_cast<std::chrono::seconds>((*m_nextLaunchTime).time_since_epoch()).count();
+		result[JSON_KEY_SHORT_APP_next_start_time] = std::chrono::duration_cast<std::chrono::seconds>((*runtime->m_nextLaunchTime).time_since_epoch()).count();
 	}
 
 	Utility::addExtraAppTimeReferStr(result);
 	return result;
 }
 
+uint64_t Application::getRevision() const
+{
+	return m_revision.load();
+}
+
+void Application::bumpRevision(bool journal)
+{
+	// revision from journal sequence is unique among all applications, a re-created application never reuse one
+	m_revision = journal ? APP_CHANGE_JOURNAL::instance()->record(m_name, m_owner, m_ownerPermission) : APP_CHANGE_JOURNAL::instance()->nextRevision();
+}
+
+bool Application::usageExpired() const
+{
+	const auto runtime = getRuntime();
+	const auto sample = std::atomic_load(&m_usage);
+	return runtime->m_process && runtime->m_pid > 0 &&
+		   (sample->m_pid != runtime->m_pid || std::chrono::steady_clock::now() - sample->m_sampleTime > std::chrono::seconds(APP_RESOURCE_USAGE_REFRESH_SECONDS));
+}
+
+void Application::sampleUsage(void *ptree)
+{
+	const auto runtime = getRuntime();
+	if (runtime->m_process)
+	{
+		// sample without lock, concurrent samplers may both publish, the later one wins
+		auto sample = std::make_shared<AppUsage>();
+		sample->m_pid = runtime->m_pid;
+		sample->m_sampleTime = std::chrono::steady_clock::now();
+		sample->m_usage = runtime->m_process->getProcessDetails(ptree);
+		const auto previous = std::atomic_load(&m_usage);
+		const bool changed = (previous->m_pid != sample->m_pid || previous->m_usage != sample->m_usage);
+		std::atomic_store(&m_usage, std::shared_ptr<const AppUsage>(std::move(sample)));
+		if (changed)
+		{
+			// resource usage is not a state change for watchers
+			bumpRevision(false);
+		}
+	}
+}
+
+std::shared_ptr<const nlohmann::json> Application::AsRuntimeJson()
+{
+	if (usageExpired())
+		sampleUsage();
+	// read revision before build, a change during build invalidates this cache
+	const auto revision = m_revision.load();
+	auto cache = std::atomic_load(&m_runtimeJson);
+	if (cache == nullptr || cache->first != revision)
+	{
+		cache = std::make_shared<const std::pair<uint64_t, nlohmann::json>>(revision, AsJson(true));
+		std::atomic_store(&m_runtimeJson, cache);
+	}
+	// aliasing constructor, share ownership with cache entry
+	return std::shared_ptr<const nlohmann::json>(cache, &cache->second);
+}
+
+std::shared_ptr<const AppRuntime> Application::getRuntime() const
+{
+	return std::atomic_load(&m_runtime);
+}
+
+void Application::publishRuntime()
+{
+	std::lock_guard<std::recursive_mutex> guard(m_appMutex);
+	auto runtime = std::make_shared<AppRuntime>();
+	runtime->m_process = m_process;
+	runtime->m_pid = m_pid.load();
+	runtime->m_return = m_return.load();
+	runtime->m_procStartTime = m_procStartTime;
+	runtime->m_procExitTime = m_procExitTime;
+	runtime->m_nextLaunchTime = m_nextLaunchTime;
+	if (m_stdoutFileQueue)
+	{
+		for (int i = 0; i < m_stdoutFileQueue->size(); i++)
+		{
+			runtime->m_stdoutFiles.push_back(m_stdoutFileQueue->getFileName(i));
+		}
+	}
+	// snapshot is visible before revision bump, so a reader never caches old state with new revision
+	std::atomic_store(&m_runtime, std::shared_ptr<const AppRuntime>(std::move(runtime)));
+	bumpRevision();
+}
+
 void Application::save()
 {
 	const static char fname[] = "Application::save() ";
@@ -836,7 +1003,7 @@ void Application::dump()
 {
 	const static char fname[] = "Application::dump() ";
 
-	std::lock_guard<std::recursive_mutex> guard(m_appMutex);
+	const auto runtime = getRuntime();
 
 	LOG_DBG << fname << "m_name:" << m_name;
 	LOG_DBG << fname << "m_commandLine:" << m_commandLine;
@@ -850,21 +1017,21 @@ void Application::dump()
 		LOG_DBG << fname << "m_owner:" << m_owner->getName();
 	LOG_DBG << fname << "m_permission:" << m_ownerPermission;
 	LOG_DBG << fname << "m_status:" << (int)m_status.load();
-	if (m_pid.load() != ACE_INVALID_PID)
-		LOG_DBG << fname << "m_pid:" << m_pid.load();
+	if (runtime->m_pid != ACE_INVALID_PID)
+		LOG_DBG << fname << "m_pid:" << runtime->m_pid;
 	LOG_DBG << fname << "m_startTimeValue:" << DateTime::formatLocalTime(m_startTime);
 	LOG_DBG << fname << "m_endTimeValue:" << DateTime::formatLocalTime(m_endTime);
 	LOG_DBG << fname << "m_regTime:" << DateTime::formatLocalTime(m_regTime);
 	LOG_DBG << fname << "m_dockerImage:" << m_dockerImage;
 	LOG_DBG << fname << "m_stdoutFile:" << m_stdoutFile;
-	LOG_DBG << fname << "m_starts:" << m_starts->Value();
+	LOG_DBG << fname << "m_starts:" << std::atomic_load(&m_starts)->Value();
 	LOG_DBG << fname << "m_version:" << m_version;
 	LOG_DBG << fname << "m_lastError:" << getLastError();
 
 	LOG_DBG << fname << "m_startInterval:" << m_startInterval;
 	LOG_DBG << fname << "m_bufferTime:" << m_bufferTime;
-	if (m_nextLaunchTime)
-		LOG_DBG << fname << "m_nextLaunchTime:" << DateTime::formatLocalTime(*m_nextLaunchTime);
+	if (runtime->m_nextLaunchTime)
+		LOG_DBG << fname << "m_nextLaunchTime:" << DateTime::formatLocalTime(*runtime->m_nextLaunchTime);
 	if (m_dailyLimit != nullptr)
 		m_dailyLimit->dump();
 	if (m_resourceLimit != nullptr)
@@ -875,7 +1042,9 @@ std::shared_ptr<AppProcess> Application::allocProcess(bool monitorProcess, const
 {
 	std::shared_ptr<AppProcess> process;
 	m_stdoutFileQueue->enqueue();
-	m_starts->Increment();
+	std::atomic_load(&m_starts)->Increment();
+	// process start information is updated in the same m_appMutex scope
+	publishRuntime();
 
 	// prepare shell mode script
 	if ((m_shellApp || m_sessionLogin) && (m_shellAppFile == nullptr || !Utility::isFileExist(m_shellAppFile->getShellFileName())))
@@ -917,6 +1086,7 @@ void Application::destroy()
 	LOG_DBG << fname << "suicideTimerId: " << m_suicideTimerId.load() << " nextStartTimerId: " << m_nextStartTimerId.load();
 	this->disable();
 	this->m_status.store(STATUS::NOTAVIALABLE);
+	bumpRevision();
 	auto timerId = INVALID_TIMER_ID;
 	timerId = m_suicideTimerId.exchange(timerId);
 	this->cancelTimer(timerId);
@@ -947,6 +1117,10 @@ void Application::onExitUpdate(int code)
 	m_return.store(code);
 	if (code != 0 && m_process)
 		setLastError(Utility::stringFormat("exited with return code: %d, msg: %s", code, m_process->startError().c_str()));
+	publishRuntime();
+	// evaluate error handling (restart) at once
+	if (const auto &supervisor = AppSupervisor::instance())
+		supervisor->notify(m_name);
 	// this->registerTimer(0, 0, std::bind(&Application::handleError, this), fname);
 }
 
@@ -963,6 +1137,7 @@ void Application::terminate(std::shared_ptr<AppProcess> &process)
 	m_return = 9;
 	m_procExitTime = boost::make_shared<std::chrono::system_clock::time_point>(std::chrono::system_clock::now());
 	process.reset();
+	publishRuntime();
 }
 
 void Application::handleError()
@@ -982,7 +1157,11 @@ void Application::handleError()
 		break;
 	case AppBehavior::Action::KEEPALIVE:
 		// keep alive always, used for period run
-		m_nextLaunchTime = boost::make_shared<std::chrono::system_clock::time_point>(std::chrono::system_clock::now());
+		{
+			std::lock_guard<std::recursive_mutex> guard(m_appMutex);
+			m_nextLaunchTime = boost::make_shared<std::chrono::system_clock::time_point>(std::chrono::system_clock::now());
+			publishRuntime();
+		}
 		this->registerTimer(0, 0, std::bind(&Application::spawn, this), fname);
 		LOG_DBG << fname << "next action for <" << m_name << "> is KEEPALIVE";
 		break;
@@ -1028,6 +1207,7 @@ boost::shared_ptr<std::chrono::system_clock::time_point> Application::scheduleNe
 	{
 		m_nextLaunchTime.reset();
 	}
+	publishRuntime();
 	return m_nextLaunchTime;
 }
 
@@ -1057,6 +1237,7 @@ void Application::setLastError(const std::string &error)
 		{
 			m_lastError = "";
 		}
+		bumpRevision();
 	}
 }
 
@@ -1,11 +1,13 @@
 #pragma once
 #include <atomic>
 #include <chrono>
+#include <limits>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <tuple>
+#include <vector>
 
 #include <boost/smart_ptr/shared_ptr.hpp>
 #include <boost/thread/synchronized_value.hpp>
@@ -28,8 +30,37 @@ namespace prometheus
 	class Counter;
 };
 
+/// <summary>
+/// Immutable snapshot of Application runtime state.
+/// Writers change runtime state under m_appMutex and publish a new snapshot,
+/// readers (REST view, output, dump) load the current snapshot and never take m_appMutex.
+/// </summary>
+struct AppRuntime
+{
+	std::shared_ptr<AppProcess> m_process;
+	pid_t m_pid = ACE_INVALID_PID;
+	int m_return = std::numeric_limits<int>::min(); // INVALID_RETURN_CODE
+	boost::shared_ptr<std::chrono::system_clock::time_point> m_procStartTime;
+	boost::shared_ptr<std::chrono::system_clock::time_point> m_procExitTime;
+	boost::shared_ptr<std::chrono::system_clock::time_point> m_nextLaunchTime;
+	// stdout cache file names, index is the output file index
+	std::vector<std::string> m_stdoutFiles;
+};
+
+/// <summary>
+/// Resource usage sample of one process
+/// </summary>
+struct AppUsage
+{
+	pid_t m_pid = ACE_INVALID_PID;
+	std::chrono::steady_clock::time_point m_sampleTime;
+	std::tuple<bool, uint64_t, float, uint64_t, std::string> m_usage;
+};
+
 //////////////////////////////////////////////////////////////////////////
 /// An Application is used to define and manage a process job.
+/// Spec members are set by FromJson() before the application is registered and not changed after,
+/// runtime members are published by AppRuntime snapshot.
 //////////////////////////////////////////////////////////////////////////
 class Application : public TimerHandler, public AppBehavior
 {
@@ -47,6 +78,7 @@ public:
 	int getOwnerPermission() const;
 	bool isCloudApp() const;
 	STATUS getStatus() const;
+	const nlohmann::json &getMetadata() const;
 	bool isPersistAble() const;
 	void setUnPersistable();
 
@@ -55,7 +87,8 @@ public:
 	bool attach(int pid);
 
 	static void FromJson(const std::shared_ptr<Application> &app, const nlohmann::json &obj) noexcept(false);
-	virtual nlohmann::json AsJson(bool returnRuntimeInfo, void *ptree = nullptr);
+	/// <param name="returnUsage">include process resource usage (memory, cpu, fd, pstree) in runtime info</param>
+	virtual nlohmann::json AsJson(bool returnRuntimeInfo, void *ptree = nullptr, bool returnUsage = true);
 	virtual void save();
 	virtual void remove();
 	virtual void dump();
@@ -63,6 +96,10 @@ public:
 
 	// operate
 	void execute(void *ptree = nullptr);
+	/// <summary>
+	/// Time when execute() is needed again without any event, time_point::max() for an idle application
+	/// </summary>
+	std::chrono::system_clock::time_point nextEvaluation(const std::chrono::system_clock::time_point &now = std::chrono::system_clock::now());
 	void enable();
 	void disable();
 	void destroy();
@@ -78,17 +115,51 @@ public:
 	std::string runAsyncrize(int timeoutSeconds) noexcept(false);
 	std::string runSyncrize(int timeoutSeconds, void *asyncHttpRequest) noexcept(false);
 	std::tuple<std::string, bool, int> getOutput(long &position, long maxSize, const std::string &processUuid = "", int index = 0, size_t timeout = 0);
+	// current size of output file with given index, -1 when not available
+	long getOutputSize(int index = 0);
 
 	// prometheus
 	void initMetrics();
 	void initMetrics(std::shared_ptr<Application> fromApp);
 
+	// revision
+	/// <summary>
+	/// Monotonic revision, bumped when spec or runtime state changed, unique among all applications
+	/// </summary>
+	uint64_t getRevision() const;
+	/// <summary>
+	/// Allocate a new revision, and record the change to AppChangeJournal for watchers
+	/// </summary>
+	void bumpRevision(bool journal = true);
+	/// <summary>
+	/// Resource usage of running process was sampled too long ago
+	/// </summary>
+	bool usageExpired() const;
+	/// <summary>
+	/// Sample resource usage of running process, revision is bumped when usage changed
+	/// </summary>
+	void sampleUsage(void *ptree = nullptr);
+	/// <summary>
+	/// Runtime JSON (AsJson with runtime info) cached per revision
+	/// </summary>
+	std::shared_ptr<const nlohmann::json> AsRuntimeJson();
+	/// <summary>
+	/// Current runtime state snapshot, lock free
+	/// </summary>
+	std::shared_ptr<const AppRuntime> getRuntime() const;
+
 protected:
 	// error
 	void setLastError(const std::string &error) noexcept(false);
 	const std::string getLastError() const noexcept(false);
 	void setInvalidError() noexcept(false);
 
+	// runtime snapshot
+	/// <summary>
+	/// Publish runtime state as a new snapshot and bump revision, called after runtime state changed
+	/// </summary>
+	void publishRuntime();
+
 	// process
 	std::shared_ptr<AppProcess> allocProcess(bool monitorProcess, const std::string &dockerImage, const std::string &appName);
 	void spawn();
@@ -145,7 +216,7 @@ protected:
 	std::map<std::string, std::string> m_secEnvMap;
 	std::string m_dockerImage;
 
-	// runtime dynamic variables (which will also be read by API)
+	// runtime dynamic variables, changed under m_appMutex and read by API from m_runtime snapshot
 	std::shared_ptr<AppProcess> m_process;
 	std::atomic<pid_t> m_pid;
 	std::atomic<int> m_return; // the exit code of last instance
@@ -156,6 +227,12 @@ protected:
 	boost::shared_ptr<std::chrono::system_clock::time_point> m_nextLaunchTime;
 	// error
 	boost::synchronized_value<std::string> m_lastError;
+	// published snapshots, accessed by std::atomic_load/std::atomic_store
+	std::shared_ptr<const AppRuntime> m_runtime;
+	std::shared_ptr<const AppUsage> m_usage;
+	// revision and runtime JSON cache keyed by revision, accessed by std::atomic_load/std::atomic_store
+	std::atomic<uint64_t> m_revision;
+	std::shared_ptr<const std::pair<uint64_t, nlohmann::json>> m_runtimeJson;
 
 	// Prometheus
 	std::shared_ptr<CounterMetric> m_metricStartCount;
@@ -163,5 +240,6 @@ protected:
 	std::shared_ptr<GaugeMetric> m_metricCpu;
 	std::shared_ptr<GaugeMetric> m_metricAppPid;
 	std::shared_ptr<GaugeMetric> m_metricFileDesc;
+	// shared with the replaced application, accessed by std::atomic_load/std::atomic_store
 	std::shared_ptr<prometheus::Counter> m_starts;
 };
@@ -514,7 +514,7 @@ void ConsulConnection::syncTopology()
 {
 	const static char fname[] = "ConsulConnection::syncTopology() ";
 
-	auto currentAllApps = Configuration::instance()->getApps();
+	const auto currentAllApps = Configuration::instance()->getApps();
 	std::shared_ptr<ConsulTopology> newTopology;
 	auto topology = retrieveTopology(MY_HOST_NAME);
 	auto hostTopologyIt = topology.find(MY_HOST_NAME);
@@ -531,12 +531,10 @@ void ConsulConnection::syncTopology()
 			{
 				auto &consulTask = task[appName];
 				std::shared_ptr<Application> topologyAppObj = consulTask->m_app;
-				auto it = std::find_if(currentAllApps.begin(), currentAllApps.end(), [&appName](std::shared_ptr<Application> const &obj)
-									   { return obj->getName() == appName; });
-				if (it != currentAllApps.end())
+				const auto &currentRunningApp = currentAllApps->find(appName);
+				if (currentRunningApp)
 				{
 					// Update app
-					auto &currentRunningApp = *it;
 					if (!currentRunningApp->operator==(topologyAppObj))
 					{
 						Configuration::instance()->addApp(currentRunningApp->AsJson(false), nullptr, false);
@@ -556,7 +554,7 @@ void ConsulConnection::syncTopology()
 			}
 		}
 
-		for (const auto &currentApp : currentAllApps)
+		for (const auto &currentApp : *currentAllApps)
 		{
 			if (currentApp->isCloudApp())
 			{
@@ -573,7 +571,7 @@ void ConsulConnection::syncTopology()
 	else
 	{
 		// retrieveTopology will throw if connection was not reached
-		for (const auto &currentApp : currentAllApps)
+		for (const auto &currentApp : *currentAllApps)
 		{
 			if (currentApp->isCloudApp())
 			{
@@ -615,8 +613,8 @@ void ConsulConnection::offlineNode()
 	path = std::string(CONSUL_BASE_PATH).append("topology/").append(MY_HOST_NAME);
 	requestConsul(web::http::methods::DEL, path, {}, {}, nullptr);
 
-	auto currentAllApps = Configuration::instance()->getApps();
-	for (const auto &currentApp : currentAllApps)
+	const auto currentAllApps = Configuration::instance()->getApps();
+	for (const auto &currentApp : *currentAllApps)
 	{
 		if (currentApp->isCloudApp())
 		{
@@ -1,15 +1,21 @@
+#include <algorithm>
 #include <chrono>
 #include <list>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <ace/Acceptor.h>
 #include <ace/Init_ACE.h>
+#include <ace/LSOCK_Acceptor.h>
 #include <ace/OS.h>
 #include <ace/Process_Manager.h>
 #include <ace/Reactor.h>
 #include <ace/SSL/SSL_Context.h>
 #include <ace/SSL/SSL_SOCK_Acceptor.h>
+#include <ace/UNIX_Addr.h>
 #include <boost/filesystem.hpp>
 
 #include "../common/TimerHandler.h"
@@ -20,6 +26,7 @@
 #include "HealthCheckTask.h"
 #include "PersistManager.h"
 #include "ResourceCollection.h"
+#include "application/AppSupervisor.h"
 #include "application/Application.h"
 #include "consul/ConsulConnection.h"
 #include "process/AppProcess.h"
@@ -32,8 +39,12 @@
 #include "../common/Valgrind.h"
 #endif
 
-typedef ACE_Acceptor<TcpHandler, ACE_SSL_SOCK_Acceptor> TcpAcceptor; // Specialize a Tcp Acceptor.
+typedef ACE_Acceptor<TlsTcpHandler, ACE_SSL_SOCK_Acceptor> TcpAcceptor;  // Specialize a Tcp Acceptor.
+typedef ACE_Acceptor<UnixTcpHandler, ACE_LSOCK_Acceptor> UnixAcceptor; // Local Unix domain socket Acceptor.
 static std::vector<std::unique_ptr<std::thread>> m_threadPool;
+// application execute is mostly process spawn and file IO, a few shards are enough to isolate a slow one
+constexpr unsigned int APP_SUPERVISOR_WORKERS_MAX = 4;
+static const std::vector<double> APP_EXECUTE_HISTOGRAM_BUCKETS = {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5};
 
 int main(int argc, char *argv[])
 {
@@ -85,6 +96,51 @@ int main(int argc, char *argv[])
 		Configuration::instance(config);
 		Utility::initDateTimeZone(Configuration::instance()->getPosixTimezone(), true);
 
+		// event driven application supervisor, an application is executed only when due or after a state transition,
+		// applications are executed in parallel shards, each shard with its own loop
+		const auto supervisorWorkers = std::max(1u, std::min(APP_SUPERVISOR_WORKERS_MAX, std::thread::hardware_concurrency()));
+		AppSupervisor::instance() = std::make_unique<AppSupervisor>(
+			[](const std::string &appName)
+			{
+				auto app = Configuration::instance()->getApp(appName, false);
+				if (app == nullptr)
+				{
+					return AppSupervisor::TimePoint::max();
+				}
+				// share one process tree scan between evaluations for prometheus metrics
+				static std::mutex ptreeMutex;
+				static std::shared_ptr<std::list<os::Process>> ptree;
+				static auto ptreeTime = std::chrono::steady_clock::time_point();
+				if (Configuration::instance()->prometheusEnabled() && RESTHANDLER::instance()->collected())
+				{
+					std::shared_ptr<std::list<os::Process>> processes;
+					{
+						std::lock_guard<std::mutex> guard(ptreeMutex);
+						if (ptree == nullptr || std::chrono::steady_clock::now() - ptreeTime > std::chrono::seconds(1))
+						{
+							ptree = std::make_shared<std::list<os::Process>>(os::processes());
+							ptreeTime = std::chrono::steady_clock::now();
+						}
+						processes = ptree;
+					}
+					app->execute((void *)(processes.get()));
+				}
+				else
+				{
+					app->execute();
+				}
+				return app->nextEvaluation();
+			},
+			supervisorWorkers);
+		if (Configuration::instance()->prometheusEnabled())
+		{
+			AppSupervisor::instance()->metrics(
+				RESTHANDLER::instance()->createPromHistogram(PROM_METRIC_NAME_appmesh_app_supervisor_pass_seconds, PROM_METRIC_HELP_appmesh_app_supervisor_pass_seconds, {}, APP_EXECUTE_HISTOGRAM_BUCKETS),
+				RESTHANDLER::instance()->createPromHistogram(PROM_METRIC_NAME_appmesh_app_execute_seconds, PROM_METRIC_HELP_appmesh_app_execute_seconds, {}, APP_EXECUTE_HISTOGRAM_BUCKETS),
+				RESTHANDLER::instance()->createPromCounter(PROM_METRIC_NAME_appmesh_app_supervisor_slow_shard_total, PROM_METRIC_HELP_appmesh_app_supervisor_slow_shard_total, {}));
+		}
+		LOG_INF << fname << "application supervisor started with " << supervisorWorkers << " workers";
+
 		// init security [both for server side and REST client side (file operation API)]
 		Security::init(Configuration::instance()->getJwt()->m_jwtInterface);
 
@@ -112,16 +168,24 @@ int main(int argc, char *argv[])
 
 		// init REST
 		TcpAcceptor acceptor; // Acceptor factory.
+		UnixAcceptor unixAcceptor;
 		ACE_INET_Addr acceptorAddr(Configuration::instance()->getRestTcpPort(), Configuration::instance()->getRestListenAddress().c_str());
 		if (config->getRestEnabled())
 		{
 			TcpHandler::initTcpSSL(ACE_SSL_Context::instance());
-			// thread for TCP reactor
+			// thread for TCP acceptor reactor
 			m_threadPool.push_back(std::make_unique<std::thread>(std::bind(&TimerManager::runReactorEvent, ACE_Reactor::instance())));
+			// threads for sharded TCP connection reactors
+			for (const auto &reactor : TcpHandler::initReactors(Configuration::instance()->getReactorThreadPoolSize()))
+			{
+				m_threadPool.push_back(std::make_unique<std::thread>(std::bind(&TimerManager::runReactorEvent, reactor.get())));
+			}
+			LOG_INF << fname << "starting <" << Configuration::instance()->getReactorThreadPoolSize() << "> threads for TCP reactor";
 			// threads for REST service pool
+			TcpHandler::initMsgQueue(Configuration::instance()->getThreadPoolSize());
 			for (size_t i = 0; i < Configuration::instance()->getThreadPoolSize(); i++)
 			{
-				m_threadPool.push_back(std::make_unique<std::thread>(TcpHandler::handleTcpRest));
+				m_threadPool.push_back(std::make_unique<std::thread>(std::bind(&TcpHandler::handleTcpRest, i)));
 			}
 			LOG_INF << fname << "starting <" << Configuration::instance()->getThreadPoolSize() << "> threads for REST thread pool";
 
@@ -129,6 +193,24 @@ int main(int argc, char *argv[])
 			{
 				throw std::runtime_error(std::string("Failed to listen with error: ") + std::strerror(errno));
 			}
+			// local clients use Unix domain socket to skip TLS and TCP loopback, TLS port keep serving remote clients
+			const auto unixSocket = Configuration::instance()->getRestUnixSocket();
+			if (!unixSocket.empty())
+			{
+				ACE_OS::unlink(unixSocket.c_str()); // remove stale socket file left by previous process
+				if (unixAcceptor.open(ACE_UNIX_Addr(unixSocket.c_str()), ACE_Reactor::instance()) == -1)
+				{
+					LOG_ERR << fname << "Failed to listen on Unix socket <" << unixSocket << "> with error: " << std::strerror(errno);
+				}
+				else if (ACE_OS::chmod(unixSocket.c_str(), REST_UNIX_SOCKET_PERMISSION) == -1)
+				{
+					LOG_ERR << fname << "Failed to set permission for Unix socket <" << unixSocket << "> with error: " << std::strerror(errno);
+				}
+				else
+				{
+					LOG_INF << fname << "listening on Unix socket <" << unixSocket << ">";
+				}
+			}
 			// start agent
 			if (!Configuration::instance()->isAppExist(SEPARATE_AGENT_APP_NAME))
 			{
@@ -154,8 +236,8 @@ int main(int argc, char *argv[])
 		// token black list recover
 		TOKEN_BLACK_LIST::instance()->init(snap->m_tokenBlackList);
 		// app pid recover
-		std::for_each(apps.begin(), apps.end(),
-					  [&snap](std::vector<std::shared_ptr<Application>>::reference p)
+		std::for_each(apps->begin(), apps->end(),
+					  [&snap](const std::shared_ptr<Application> &p)
 					  {
 						  if (snap && snap->m_apps.count(p->getName()))
 						  {
@@ -177,22 +259,32 @@ int main(int argc, char *argv[])
 		if (config->getRestEnabled())
 			client.connect(acceptorAddr);
 
-		// monitor applications
+		// monitor applications, evaluate all once then each application schedules itself
+		apps = Configuration::instance()->getApps();
+		for (const auto &app : *apps)
+		{
+			AppSupervisor::instance()->notify(app->getName());
+		}
+		// do not hold removed applications for daemon lifetime
+		apps.reset();
 		int tcpErrorCounter = 0;
 		while (QUIT_HANDLER::instance()->is_set() == 0)
 		{
-			// wait and test connect
+			// supervise applications until next maintenance
+			AppSupervisor::instance()->run(std::chrono::system_clock::now() + std::chrono::seconds(Configuration::instance()->getScheduleInterval()));
+
+			// test connect
 			if (Configuration::instance()->getRestEnabled())
 			{
-				// check tcp and wait
-				if (!client.testConnection(Configuration::instance()->getScheduleInterval()))
+				// check tcp without wait
+				if (!client.testConnection(0))
 				{
 					tcpErrorCounter++;
 					if (tcpErrorCounter > 30)
 					{
 						ACE_OS::_exit(-1);
 					}
-					std::this_thread::sleep_for(std::chrono::seconds(Configuration::instance()->getScheduleInterval()));
+					AppSupervisor::instance()->run(std::chrono::system_clock::now() + std::chrono::seconds(Configuration::instance()->getScheduleInterval()));
 					client.connect(acceptorAddr);
 				}
 				else
@@ -200,27 +292,6 @@ int main(int argc, char *argv[])
 					tcpErrorCounter = 0;
 				}
 			}
-			else
-			{
-				std::this_thread::sleep_for(std::chrono::seconds(Configuration::instance()->getScheduleInterval()));
-			}
-
-			// monitor application
-			std::list<os::Process> ptree;
-			if (Configuration::instance()->prometheusEnabled() && RESTHANDLER::instance()->collected())
-				ptree = os::processes();
-			auto allApp = Configuration::instance()->getApps();
-			for (const auto &app : allApp)
-			{
-				try
-				{
-					app->execute((void *)(&ptree));
-				}
-				catch (...)
-				{
-					LOG_ERR << fname << "Application <" << app->getName() << "> execute failed with error " << std::strerror(errno);
-				}
-			}
 
 			PersistManager::instance()->persistSnapshot();
 			// health-check
@@ -239,6 +310,7 @@ int main(int argc, char *argv[])
 	TIMER_MANAGER::instance()->reactor()->end_reactor_event_loop();
 	TIMER_MANAGER::instance()->reactor()->close();
 	ACE_Reactor::instance()->end_reactor_event_loop();
+	TcpHandler::closeReactors();
 	TcpHandler::closeMsgQueue();
 	for (const auto &t : m_threadPool)
 		t->join();
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <fstream>
 #include <thread>
 
@@ -25,7 +26,7 @@ AppProcess::AppProcess(void *owner)
 	: m_owner(owner), m_delayKillTimerId(INVALID_TIMER_ID), m_stdOutSizeTimerId(INVALID_TIMER_ID),
 	  m_stdOutMaxSize(0), m_stdinHandler(ACE_INVALID_HANDLE), m_stdoutHandler(ACE_INVALID_HANDLE),
 	  m_lastProcCpuTime(0), m_lastSysCpuTime(0), m_uuid(Utility::createUUID()),
-	  m_pid(ACE_INVALID_PID), m_returnValue(-1)
+	  m_pid(ACE_INVALID_PID), m_returnValue(-1), m_attached(false)
 {
 	const static char fname[] = "AppProcess::AppProcess() ";
 	LOG_DBG << fname << "Entered, ID: " << m_uuid;
@@ -56,6 +57,7 @@ AppProcess::~AppProcess()
 void AppProcess::attach(int pid, const std::string &stdoutFile)
 {
 	this->m_pid = pid;
+	this->m_attached = (pid > 0);
 	m_stdoutFileName = stdoutFile;
 
 	CLOSE_ACE_HANDLER(m_stdoutHandler);
@@ -69,6 +71,17 @@ void AppProcess::detach(void)
 	attach(ACE_INVALID_PID, std::string());
 }
 
+bool AppProcess::attached() const
+{
+	return m_attached;
+}
+
+bool AppProcess::attachedExited()
+{
+	// only the first caller see the exit
+	return m_attached && !running() && m_attached.exchange(false);
+}
+
 pid_t AppProcess::getpid(void) const
 {
 	return m_pid;
@@ -444,6 +457,12 @@ const std::string AppProcess::getOutputMsg(long *position, int maxSize, bool rea
 	return Utility::readFileCpp(m_stdoutFileName, position, maxSize, readLine);
 }
 
+long AppProcess::getOutputSize()
+{
+	std::lock_guard<std::recursive_mutex> guard(m_outFileMutex);
+	return std::max(ACE_OS::filesize(m_stdoutFileName.c_str()), (ACE_OFF_T)0);
+}
+
 void AppProcess::startError(const std::string &err)
 {
 	m_startError = err;
@@ -142,6 +142,18 @@ public:
 	/// </summary>
 	void detach(void);
 
+	/// <summary>
+	/// Whether the process is attached instead of spawned, attached process is not a child and exit is not notified
+	/// </summary>
+	/// <returns></returns>
+	bool attached() const;
+
+	/// <summary>
+	/// Poll exit of attached process
+	/// </summary>
+	/// <returns>true only once after attached process exited</returns>
+	bool attachedExited();
+
 	/// <summary>
 	/// kill the process group
 	/// </summary>
@@ -194,6 +206,11 @@ public:
 	/// </summary>
 	/// <returns></returns>
 	virtual const std::string getOutputMsg(long *position = nullptr, int maxSize = APP_STD_OUT_VIEW_DEFAULT_SIZE, bool readLine = false);
+	/// <summary>
+	/// current size of stdoutFile, used to plan a streamed output read
+	/// </summary>
+	/// <returns>-1 when output is not read from local file</returns>
+	virtual long getOutputSize();
 
 	/// <summary>
 	/// save last error
@@ -230,4 +247,5 @@ private:
 	std::string m_startError;
 	std::atomic<pid_t> m_pid;
 	std::atomic<int> m_returnValue;
+	std::atomic<bool> m_attached;
 };
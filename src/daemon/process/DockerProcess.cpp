@@ -247,10 +247,12 @@ int DockerProcess::execPullDockerImage(std::map<std::string, std::string> &envMa
 
 pid_t DockerProcess::getpid(void) const
 {
-	if (ACE_Process::getpid() == 1)
+	// container root pid or image pull pid is attached to AppProcess, ACE_Process is never spawned
+	const auto pid = AppProcess::getpid();
+	if (pid == 1)
 		return ACE_INVALID_PID;
 	else
-		return ACE_Process::getpid();
+		return pid;
 }
 
 std::string DockerProcess::containerId() const
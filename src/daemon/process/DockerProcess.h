@@ -74,6 +74,7 @@ public:
 	/// <param name="readLine"></param>
 	/// <returns></returns>
 	const std::string getOutputMsg(long *position = nullptr, int maxSize = APP_STD_OUT_VIEW_DEFAULT_SIZE, bool readLine = false) override;
+	long getOutputSize() override { return -1; }
 
 protected:
 	/// <summary>
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <ace/Process.h>
 
 #include "../../common/Utility.h"
@@ -35,14 +37,37 @@ void MonitoredProcess::replyAsyncRequest()
 	{
 		try
 		{
+			if (m_httpRequest && m_httpRequest->cancelled())
+			{
+				// client gave up or disconnected, no need read output
+				LOG_WAR << fname << "request <" << m_httpRequest->m_uuid << "> cancelled, skip reply";
+				m_httpRequest = nullptr;
+			}
 			if (m_httpRequest)
 			{
+				// process exited, output file is complete, stream it in chunks
 				long position = 0;
-				auto body = this->getOutputMsg(&position);
+				const long endPosition = std::min(this->getOutputSize(), (long)APP_STD_OUT_VIEW_DEFAULT_SIZE);
 				std::map<std::string, std::string> headers;
 				headers[HTTP_HEADER_KEY_exit_code] = std::to_string(AppProcess::returnValue());
-				headers[HTTP_HEADER_KEY_output_pos] = std::to_string(position);
-				m_httpRequest->reply(web::http::status_codes::OK, body, headers);
+				headers[HTTP_HEADER_KEY_output_pos] = std::to_string(endPosition);
+				auto stream = m_httpRequest->replyStream(web::http::status_codes::OK, headers);
+				bool complete = true;
+				while (complete && position < endPosition)
+				{
+					if (m_httpRequest->cancelled())
+					{
+						complete = false;
+						break;
+					}
+					const auto chunk = this->getOutputMsg(&position, std::min(endPosition - position, (long)RESPONSE_STREAM_CHUNK_SIZE));
+					complete = !chunk.empty() && stream->write(chunk);
+				}
+				// output position header is only valid when all output until it was sent
+				if (complete)
+					stream->end();
+				else
+					stream->abort();
 				// explicit release memory here
 				m_httpRequest = nullptr;
 			}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <map>
 #include <string>
 
@@ -5,6 +6,7 @@
 
 #include "../../common/Utility.h"
 #include "../Configuration.h"
+#include "../application/AppChangeJournal.h"
 #include "../application/Application.h"
 #include "../process/AppProcess.h"
 #include "HttpRequest.h"
@@ -14,16 +16,28 @@
 
 APP_OUT_MULTI_MAP_TYPE APP_OUT_VIEW_MAP;
 
-HttpRequest::HttpRequest(const Request &request, int tcpHandlerId)
+HttpRequest::HttpRequest(Request &&request, int tcpHandlerId)
 	: m_tcpHanlerId(tcpHandlerId)
 {
-	this->m_uuid = request.uuid;
-	this->m_method = request.http_method;
-	this->m_relative_uri = request.request_uri;
-	this->m_remote_address = request.client_addr;
-	this->m_body = request.body;
-	this->m_querys = request.querys;
-	this->m_headers = request.headers;
+	this->m_uuid = std::move(request.uuid);
+	this->m_method = std::move(request.http_method);
+	this->m_relative_uri = std::move(request.request_uri);
+	this->m_remote_address = std::move(request.client_addr);
+	this->m_body = std::move(request.body);
+	this->m_querys = std::move(request.querys);
+	this->m_headers = std::move(request.headers);
+
+	// deadline set by agent has precedence, otherwise use X-Request-Timeout (seconds) relative to receive time
+	if (request.deadline > 0)
+	{
+		this->m_deadline = std::chrono::system_clock::time_point(std::chrono::milliseconds(request.deadline));
+	}
+	else if (m_headers.count(HTTP_HEADER_KEY_request_timeout))
+	{
+		const auto timeout = std::atof(m_headers.find(HTTP_HEADER_KEY_request_timeout)->second.c_str());
+		if (timeout > 0)
+			this->m_deadline = std::chrono::system_clock::now() + std::chrono::milliseconds(static_cast<int64_t>(timeout * 1000));
+	}
 }
 
 HttpRequest::~HttpRequest()
@@ -32,7 +46,21 @@ HttpRequest::~HttpRequest()
 
 nlohmann::json HttpRequest::extractJson() const
 {
-	return nlohmann::json::parse(m_body);
+	return bodyJson();
+}
+
+const nlohmann::json &HttpRequest::bodyJson() const
+{
+	if (!m_bodyJson)
+	{
+		auto body = nlohmann::json::parse(m_body);
+		if (body.is_string())
+		{
+			body = nlohmann::json::parse(body.get<std::string>());
+		}
+		m_bodyJson = std::make_shared<const nlohmann::json>(std::move(body));
+	}
+	return *m_bodyJson;
 }
 
 void HttpRequest::reply(web::http::status_code status) const
@@ -60,6 +88,36 @@ void HttpRequest::reply(web::http::status_code status, const std::string &body_d
 	reply(m_relative_uri, m_uuid, body_data, headers, status, content_type);
 }
 
+std::unique_ptr<HttpResponseStream> HttpRequest::replyStream(web::http::status_code status, const std::map<std::string, std::string> &headers, const std::string &content_type) const
+{
+	return std::make_unique<HttpResponseStream>(m_relative_uri, m_uuid, m_tcpHanlerId, status, headers, content_type);
+}
+
+bool HttpRequest::expired() const
+{
+	return m_deadline.time_since_epoch().count() && std::chrono::system_clock::now() > m_deadline;
+}
+
+bool HttpRequest::cancelled() const
+{
+	return expired() || (m_tcpHanlerId > 0 && !TcpHandler::connected(m_tcpHanlerId));
+}
+
+const std::string &HttpRequest::pathParam(const std::string &name) const
+{
+	const static char fname[] = "HttpRequest::pathParam() ";
+
+	for (const auto &param : m_pathParams)
+	{
+		if (param.first == name && param.second.length())
+		{
+			return param.second;
+		}
+	}
+	LOG_WAR << fname << "no path parameter <" << name << "> from path :" << m_relative_uri;
+	throw std::invalid_argument(Utility::stringFormat("no data from path for parameter <%s>", name.c_str()));
+}
+
 std::shared_ptr<HttpRequest> HttpRequest::deserialize(const char *input, int inputSize, int tcpHandlerId)
 {
 	const static char fname[] = "HttpRequest::deserialize() ";
@@ -68,7 +126,7 @@ std::shared_ptr<HttpRequest> HttpRequest::deserialize(const char *input, int inp
 	Request req;
 	if (req.deserialize(input, inputSize))
 	{
-		return std::make_shared<HttpRequest>(req, tcpHandlerId);
+		return std::make_shared<HttpRequest>(std::move(req), tcpHandlerId);
 	}
 	else
 	{
@@ -119,6 +177,99 @@ void HttpRequest::reply(const std::string &requestUri, const std::string &uuid,
 		TcpHandler::replyTcp(m_tcpHanlerId, response);
 	}
 }
+////////////////////////////////////////////////////////////////////////////////
+// Streamed response
+////////////////////////////////////////////////////////////////////////////////
+HttpResponseStream::HttpResponseStream(const std::string &requestUri, const std::string &uuid, int tcpHandlerId, web::http::status_code status,
+									   const std::map<std::string, std::string> &headers, const std::string &bodyType)
+	: m_requestUri(requestUri), m_uuid(uuid), m_tcpHanlerId(tcpHandlerId), m_status(status), m_headers(headers), m_bodyType(bodyType),
+	  m_streaming(tcpHandlerId > 0 && TcpHandler::streaming(tcpHandlerId)), m_started(false), m_ended(false)
+{
+}
+
+HttpResponseStream::~HttpResponseStream()
+{
+	// not finished by caller (exception), partial body is not complete
+	abort();
+}
+
+bool HttpResponseStream::write(const std::string &chunk)
+{
+	const static char fname[] = "HttpResponseStream::write() ";
+
+	if (m_ended)
+		return false;
+	if (chunk.empty())
+		return true;
+	if (!m_streaming)
+	{
+		m_buffer.append(chunk);
+		return true;
+	}
+	// back pressure: producer follow the peer instead of growing connection send queue
+	if (!TcpHandler::waitSendQueue(m_tcpHanlerId, RESPONSE_STREAM_HIGH_WATER, std::chrono::seconds(RESPONSE_STREAM_SEND_TIMEOUT_SECONDS)))
+	{
+		LOG_WAR << fname << "stop stream <" << m_uuid << "> for connection closed or peer not reading";
+		return false;
+	}
+	const bool sent = send(StreamState::Chunk, chunk);
+	m_started = true;
+	return sent;
+}
+
+void HttpResponseStream::end()
+{
+	if (m_ended)
+		return;
+	m_ended = true;
+	// nothing streamed yet, reply as a normal single frame response
+	send(m_started ? StreamState::End : StreamState::None, m_buffer);
+	m_buffer.clear();
+}
+
+void HttpResponseStream::abort()
+{
+	const static char fname[] = "HttpResponseStream::abort() ";
+
+	if (m_ended)
+		return;
+	m_ended = true;
+	m_buffer.clear();
+	LOG_WAR << fname << "abort incomplete stream <" << m_uuid << ">";
+	if (!m_started && m_tcpHanlerId > 0)
+	{
+		nlohmann::json body;
+		body[REST_TEXT_MESSAGE_JSON_KEY] = std::string("response interrupted");
+		Response response;
+		response.uuid = m_uuid;
+		response.request_uri = m_requestUri;
+		response.body = body.dump();
+		response.http_status = web::http::status_codes::InternalError;
+		response.body_msg_type = CONTENT_TYPE_APPLICATION_JSON;
+		TcpHandler::replyTcp(m_tcpHanlerId, response);
+	}
+}
+
+bool HttpResponseStream::send(StreamState state, const std::string &body)
+{
+	if (m_tcpHanlerId <= 0)
+		return false;
+
+	Response response;
+	response.uuid = m_uuid;
+	response.request_uri = m_requestUri;
+	response.body = body;
+	response.stream_state = static_cast<int>(state);
+	if (!m_started)
+	{
+		// only the first frame carry status and headers
+		response.http_status = m_status;
+		response.headers = m_headers;
+		response.body_msg_type = m_bodyType;
+	}
+	return TcpHandler::replyTcp(m_tcpHanlerId, response);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // HttpRequest with remove app from global map
 ////////////////////////////////////////////////////////////////////////////////
@@ -175,6 +326,12 @@ void HttpRequestOutputView::response()
 		if (!m_httpRequestReplyFlag.test_and_set())
 		{
 			this->cancelTimer(m_delayReplyTimerId);
+			if (this->cancelled())
+			{
+				LOG_WAR << fname << "request <" << m_uuid << "> cancelled, skip reply";
+				m_app.reset();
+				return;
+			}
 			long pos = RestHandler::getHttpQueryValue(*this, HTTP_QUERY_KEY_stdout_position, 0, 0, 0);
 			int index = RestHandler::getHttpQueryValue(*this, HTTP_QUERY_KEY_stdout_index, 0, 0, 0);
 			long maxSize = RestHandler::getHttpQueryValue(*this, HTTP_QUERY_KEY_stdout_maxsize, APP_STD_OUT_VIEW_DEFAULT_SIZE, 1024, APP_STD_OUT_VIEW_DEFAULT_SIZE);
@@ -183,7 +340,12 @@ void HttpRequestOutputView::response()
 			bool outputHtml = RestHandler::getHttpQueryString(*this, HTTP_QUERY_KEY_html).length();
 			bool outputJson = RestHandler::getHttpQueryString(*this, HTTP_QUERY_KEY_json).length();
 
-			auto result = m_app->getOutput(pos, maxSize, processUuid, index, timeout);
+			// plain output from local file is streamed in chunks, html and json need complete output to format
+			const long startPos = pos;
+			const long outputSize = m_app->getOutputSize(index);
+			const bool streamOutput = !outputHtml && !outputJson && outputSize >= 0;
+
+			auto result = m_app->getOutput(pos, streamOutput ? std::min<long>(maxSize, RESPONSE_STREAM_CHUNK_SIZE) : maxSize, processUuid, index, timeout);
 			auto output = std::get<0>(result);
 			const auto &finished = std::get<1>(result);
 			const auto &exitCode = std::get<2>(result);
@@ -191,11 +353,43 @@ void HttpRequestOutputView::response()
 			{
 				LOG_INF << fname << "Get application output size <" << output.size() << ">";
 			}
+			// output position of the whole response is decided before stream start
+			const long endPos = streamOutput ? std::max(pos, std::min(outputSize, startPos + maxSize)) : pos;
 			std::map<std::string, std::string> headers;
-			if (pos)
-				headers[HTTP_HEADER_KEY_output_pos] = std::to_string(pos);
+			if (endPos)
+				headers[HTTP_HEADER_KEY_output_pos] = std::to_string(endPos);
 			if (finished)
 				headers[HTTP_HEADER_KEY_exit_code] = std::to_string(exitCode);
+			if (streamOutput)
+			{
+				auto stream = this->replyStream(web::http::status_codes::OK, headers);
+				bool complete = false;
+				try
+				{
+					while (stream->write(output) && !this->cancelled())
+					{
+						if (pos >= endPos)
+						{
+							complete = true;
+							break;
+						}
+						output = std::get<0>(m_app->getOutput(pos, std::min<long>(endPos - pos, RESPONSE_STREAM_CHUNK_SIZE), processUuid, index, 0));
+						if (output.empty())
+							break;
+					}
+				}
+				catch (const std::exception &e)
+				{
+					LOG_WAR << fname << "read output of request <" << m_uuid << "> failed: " << e.what();
+				}
+				// output position header is only valid when all output until it was sent
+				if (complete)
+					stream->end();
+				else
+					stream->abort();
+				m_app.reset();
+				return;
+			}
 			if (outputHtml)
 			{
 				// https://github.com/yesoreyeram/grafana-infinity-datasource/blob/main/testdata/users.html
@@ -228,4 +422,113 @@ void HttpRequestOutputView::response()
 	{
 		HttpRequest::reply(web::http::status_codes::ExpectationFailed);
 	}
-}
\ No newline at end of file
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// HttpRequest used to handle application watch
+////////////////////////////////////////////////////////////////////////////////
+HttpRequestAppWatch::HttpRequestAppWatch(const HttpRequest &message, const std::string &userName, uint64_t revision, int timeout)
+	: HttpRequest(message), m_userName(userName), m_revision(revision), m_deadline(std::chrono::steady_clock::now() + std::chrono::seconds(timeout)),
+	  m_timeoutTimerId(INVALID_TIMER_ID), m_watcherId(0), m_replied(false)
+{
+}
+
+HttpRequestAppWatch::~HttpRequestAppWatch()
+{
+}
+
+void HttpRequestAppWatch::init()
+{
+	const static char fname[] = "HttpRequestAppWatch::init() ";
+
+	if (m_revision == 0 || std::chrono::steady_clock::now() >= m_deadline)
+	{
+		response();
+		return;
+	}
+
+	// check deadline and client disconnect every second
+	m_timeoutTimerId = this->registerTimer(1000L, 1, std::bind(&HttpRequestAppWatch::checkTimeout, this), fname);
+	// reply from timer thread, journal watcher is called with application state being changed
+	const auto self = std::static_pointer_cast<HttpRequestAppWatch>(TimerHandler::shared_from_this());
+	const auto watcherId = APP_CHANGE_JOURNAL::instance()->watch(m_revision, [self]()
+																 { self->registerTimer(0, 0, std::bind(&HttpRequestAppWatch::response, self.get()), "HttpRequestAppWatch::watch() "); });
+	if (watcherId == 0)
+	{
+		response();
+		return;
+	}
+	m_watcherId = watcherId;
+	// replied by timeout before watcher id is set
+	if (m_replied)
+	{
+		APP_CHANGE_JOURNAL::instance()->unwatch(watcherId);
+	}
+	LOG_DBG << fname << "request <" << m_uuid << "> watch revision <" << m_revision << ">";
+}
+
+void HttpRequestAppWatch::checkTimeout()
+{
+	if (this->cancelled() || std::chrono::steady_clock::now() >= m_deadline)
+	{
+		response();
+	}
+}
+
+void HttpRequestAppWatch::response()
+{
+	const static char fname[] = "HttpRequestAppWatch::response() ";
+
+	if (m_replied.exchange(true))
+	{
+		return;
+	}
+	this->cancelTimer(m_timeoutTimerId);
+	APP_CHANGE_JOURNAL::instance()->unwatch(m_watcherId);
+	if (this->cancelled())
+	{
+		LOG_WAR << fname << "request <" << m_uuid << "> cancelled, skip reply";
+		return;
+	}
+
+	try
+	{
+		// read revision before collecting, a change after it is reported again by next watch
+		const auto journal = APP_CHANGE_JOURNAL::instance();
+		const auto current = journal->revision();
+		std::map<std::string, AppChange> changes;
+		const bool incremental = m_revision > 0 && journal->changes(m_revision, changes);
+		auto apps = Configuration::instance()->getUserApps(m_userName, true);
+		auto removed = nlohmann::json::array();
+		if (incremental)
+		{
+			apps.erase(std::remove_if(apps.begin(), apps.end(), [&changes](const std::shared_ptr<Application> &app)
+									  { return changes.count(app->getName()) == 0; }),
+					   apps.end());
+			// only report removed application the user could view, same as application list
+			for (const auto &change : changes)
+			{
+				const auto &name = change.first;
+				if (name != SEPARATE_REST_APP_NAME && name != SEPARATE_AGENT_APP_NAME && !Configuration::instance()->isAppExist(name) &&
+					Configuration::instance()->checkOwnerPermission(m_userName, change.second.m_owner, change.second.m_ownerPermission, false))
+				{
+					removed.push_back(name);
+				}
+			}
+		}
+
+		nlohmann::json result = nlohmann::json::object();
+		result[JSON_KEY_WATCH_revision] = current;
+		// full application list when client start from zero or journal no longer retain its revision
+		result[JSON_KEY_WATCH_reset] = !incremental;
+		result[JSON_KEY_WATCH_applications] = Configuration::serializeApplication(apps, true);
+		result[JSON_KEY_WATCH_removed] = std::move(removed);
+		HttpRequest::reply(web::http::status_codes::OK, result);
+	}
+	catch (const std::exception &e)
+	{
+		LOG_WAR << fname << "request <" << m_uuid << "> failed: " << e.what();
+		HttpRequest::reply(web::http::status_codes::ExpectationFailed);
+	}
+}
+
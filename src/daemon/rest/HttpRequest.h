@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <map>
 #include <memory>
 
@@ -7,10 +9,12 @@
 
 #include "../../common/TimerHandler.h"
 #include "../../common/Utility.h"
+#include "RestRouter.h"
 #include "protoc/ProtobufHelper.h"
 
 #define CONTENT_TYPE_APPLICATION_JSON "application/json"
 
+class HttpResponseStream;
 /// <summary>
 /// HttpRequest is wrapper of <web::http::http_request>,
 ///    - used for REST server forward request to TCP server and wait TCP result then response REST client
@@ -24,16 +28,24 @@ public:
 	/// <summary>
 	/// Construction for deserialize
 	/// TCP REST Server receive and decode this, m_forwardResponse2RestServer always set to true
+	/// Decoded request data is moved without copy
 	/// </summary>
-	explicit HttpRequest(const Request &request, int tcpHandlerId);
+	explicit HttpRequest(Request &&request, int tcpHandlerId);
 
 	virtual ~HttpRequest();
 
 	/// <summary>
 	/// Always use this function to get http body
 	/// http body will always be extract with string (for serialize purpose) and parse to JSON here
+	/// Return a copy of the cached body document, for handlers that modify it
 	/// </summary>
 	nlohmann::json extractJson() const;
+	/// <summary>
+	/// Parsed body document, parsed once on first access and shared by dispatcher and handlers,
+	/// a JSON encoded string body is unwrapped to the document it contains
+	/// </summary>
+	/// <exception cref="nlohmann::json::parse_error">body is not valid JSON</exception>
+	const nlohmann::json &bodyJson() const;
 
 	/// <summary>
 	/// Asynchronously responses to this HTTP request.
@@ -86,6 +98,34 @@ public:
 			   const std::map<std::string, std::string> &headers,
 			   const std::string &content_type = "text/plain") const;
 
+	/// <summary>
+	/// Start a streamed response, body is written in chunks by the returned stream.
+	/// </summary>
+	/// <param name="status">Response status code.</param>
+	/// <param name="headers">Headers value in the response header, sent with the first chunk.</param>
+	/// <param name="content_type">Content type of the body.</param>
+	/// <returns>stream used to write body, response is finished by end() or destruction</returns>
+	std::unique_ptr<HttpResponseStream> replyStream(web::http::status_code status,
+													const std::map<std::string, std::string> &headers,
+													const std::string &content_type = "text/plain") const;
+
+	/// <summary>
+	/// Whether request deadline passed, caller already gave up waiting for the reply
+	/// </summary>
+	bool expired() const;
+
+	/// <summary>
+	/// Whether request no longer need to be handled: deadline passed or client connection closed,
+	/// long running handler should check this and stop early
+	/// </summary>
+	bool cancelled() const;
+
+	/// <summary>
+	/// Get path parameter captured by route pattern
+	/// </summary>
+	/// <exception cref="std::invalid_argument">parameter not exist or empty</exception>
+	const std::string &pathParam(const std::string &name) const;
+
 	static std::shared_ptr<HttpRequest> deserialize(const char *input, int inputSize, int tcpHandlerId);
 	static const nlohmann::json emptyJson();
 	void dump() const;
@@ -97,6 +137,14 @@ public:
 	std::string m_body;
 	std::map<std::string, std::string> m_querys;
 	std::map<std::string, std::string> m_headers;
+	// path parameters set by router, decoded and XSS safe
+	PathParams m_pathParams;
+	// absolute deadline from Request or X-Request-Timeout header, epoch zero means no deadline
+	std::chrono::system_clock::time_point m_deadline;
+
+private:
+	// lazily parsed m_body, immutable and shared by request copies
+	mutable std::shared_ptr<const nlohmann::json> m_bodyJson;
 
 private:
 	/// <summary>
@@ -114,6 +162,51 @@ private:
 	const int m_tcpHanlerId;
 };
 
+/// <summary>
+/// Streamed response of one request: ordered body chunk frames with the request uuid
+/// followed by an end of stream frame, status and headers are carried by the first chunk.
+/// When the peer does not accept stream (HTTP_HEADER_KEY_response_stream), chunks are
+/// buffered and replied as one response on end().
+/// </summary>
+class HttpResponseStream
+{
+public:
+	HttpResponseStream(const std::string &requestUri, const std::string &uuid, int tcpHandlerId, web::http::status_code status,
+					   const std::map<std::string, std::string> &headers, const std::string &bodyType);
+	virtual ~HttpResponseStream();
+
+	/// <summary>
+	/// Send one body chunk
+	/// </summary>
+	/// <returns>false when connection is closed, caller should stop writing</returns>
+	bool write(const std::string &chunk);
+	/// <summary>
+	/// Finish response, send end of stream marker or the buffered response
+	/// </summary>
+	void end();
+	/// <summary>
+	/// Stop an incomplete response without end of stream marker, so peer does not take
+	/// the partial body as complete, error is replied when nothing was sent yet
+	/// </summary>
+	void abort();
+
+private:
+	bool send(StreamState state, const std::string &body);
+
+private:
+	const std::string m_requestUri;
+	const std::string m_uuid;
+	const int m_tcpHanlerId;
+	const web::http::status_code m_status;
+	const std::map<std::string, std::string> m_headers;
+	const std::string m_bodyType;
+	const bool m_streaming;
+	bool m_started;
+	bool m_ended;
+	// body of non-stream peer
+	std::string m_buffer;
+};
+
 class Application;
 /// <summary>
 /// HttpRequest used to remove Application when finished reply
@@ -145,3 +238,27 @@ private:
 	std::shared_ptr<Application> m_app;
 	std::atomic_flag m_httpRequestReplyFlag;
 };
+
+/// <summary>
+/// HttpRequest parked by application watch (long poll), replied when AppChangeJournal
+/// records a change after requested revision or timeout, no REST worker is held while waiting
+/// </summary>
+class HttpRequestAppWatch : public TimerHandler, public HttpRequest
+{
+public:
+	HttpRequestAppWatch(const HttpRequest &message, const std::string &userName, uint64_t revision, int timeout);
+	virtual ~HttpRequestAppWatch();
+	void init();
+	void response();
+
+private:
+	void checkTimeout();
+
+private:
+	const std::string m_userName;
+	const uint64_t m_revision;
+	const std::chrono::steady_clock::time_point m_deadline;
+	long m_timeoutTimerId;
+	std::atomic<uint64_t> m_watcherId;
+	std::atomic<bool> m_replied;
+};
@@ -1,9 +1,11 @@
 #include <ace/OS.h>
 #include <boost/algorithm/string_regex.hpp>
 #include <prometheus/counter.h>
+#include <prometheus/histogram.h>
 #include <prometheus/registry.h>
 #include <prometheus/text_serializer.h>
 
+#include "../../common/BufferPool.h"
 #include "../../common/Utility.h"
 #include "../../common/os/process.hpp"
 #include "../../common/os/pstree.hpp"
@@ -11,6 +13,8 @@
 #include "../ResourceCollection.h"
 #include "PrometheusRest.h"
 #include "RestBase.h"
+#include "TcpServer.h"
+#include "UploadWriter.h"
 
 std::shared_ptr<PrometheusRest> PrometheusRest::m_instance;
 constexpr auto CONTENT_TYPE = "text/plain; version=0.0.4; charset=utf-8";
@@ -41,6 +45,51 @@ void PrometheusRest::initMetrics()
 		PROM_METRIC_NAME_appmesh_prom_file_descriptor,
 		PROM_METRIC_HELP_appmesh_prom_file_descriptor,
 		{});
+	m_bufferHeapAllocations = createPromCounter(
+		PROM_METRIC_NAME_appmesh_tcp_buffer_allocation_total,
+		PROM_METRIC_HELP_appmesh_tcp_buffer_allocation_total,
+		{{"type", "heap"}});
+	m_bufferPoolReuses = createPromCounter(
+		PROM_METRIC_NAME_appmesh_tcp_buffer_allocation_total,
+		PROM_METRIC_HELP_appmesh_tcp_buffer_allocation_total,
+		{{"type", "pool"}});
+	for (size_t i = 0; i < REQUEST_LANE_NUM; i++)
+	{
+		const std::map<std::string, std::string> laneLabel = {{"lane", RequestQueue::laneName(static_cast<RequestLane>(i))}};
+		m_queueDepth.push_back(createPromGauge(PROM_METRIC_NAME_appmesh_rest_queue_depth, PROM_METRIC_HELP_appmesh_rest_queue_depth, laneLabel));
+		m_queueWaitSeconds.push_back(createPromCounter(PROM_METRIC_NAME_appmesh_rest_queue_wait_seconds_total, PROM_METRIC_HELP_appmesh_rest_queue_wait_seconds_total, laneLabel));
+		m_queueDequeued.push_back(createPromCounter(PROM_METRIC_NAME_appmesh_rest_queue_dequeue_total, PROM_METRIC_HELP_appmesh_rest_queue_dequeue_total, laneLabel));
+		m_queueRejected.push_back(createPromCounter(PROM_METRIC_NAME_appmesh_rest_queue_reject_total, PROM_METRIC_HELP_appmesh_rest_queue_reject_total, laneLabel));
+		m_queueExpired.push_back(createPromCounter(PROM_METRIC_NAME_appmesh_rest_queue_drop_total, PROM_METRIC_HELP_appmesh_rest_queue_drop_total, laneLabel));
+	}
+	m_tlsFullHandshakes = createPromCounter(
+		PROM_METRIC_NAME_appmesh_tls_handshake_total,
+		PROM_METRIC_HELP_appmesh_tls_handshake_total,
+		{{"type", "full"}});
+	m_tlsResumedHandshakes = createPromCounter(
+		PROM_METRIC_NAME_appmesh_tls_handshake_total,
+		PROM_METRIC_HELP_appmesh_tls_handshake_total,
+		{{"type", "resumed"}});
+	m_tlsResumptionRatio = createPromGauge(
+		PROM_METRIC_NAME_appmesh_tls_resumption_ratio,
+		PROM_METRIC_HELP_appmesh_tls_resumption_ratio,
+		{});
+	m_tlsKernelOffload = createPromCounter(
+		PROM_METRIC_NAME_appmesh_tls_kernel_offload_total,
+		PROM_METRIC_HELP_appmesh_tls_kernel_offload_total,
+		{});
+	m_uploadActive = createPromGauge(
+		PROM_METRIC_NAME_appmesh_file_upload_active,
+		PROM_METRIC_HELP_appmesh_file_upload_active,
+		{});
+	m_uploadBytes = createPromCounter(
+		PROM_METRIC_NAME_appmesh_file_upload_bytes_total,
+		PROM_METRIC_HELP_appmesh_file_upload_bytes_total,
+		{});
+	m_uploadThroughput = createPromGauge(
+		PROM_METRIC_NAME_appmesh_file_upload_throughput,
+		PROM_METRIC_HELP_appmesh_file_upload_throughput,
+		{});
 	// Const Gauge counter
 	m_promGauge = createPromGauge(
 		PROM_METRIC_NAME_appmesh_prom_scrape_up,
@@ -74,7 +123,12 @@ std::shared_ptr<GaugeMetric> PrometheusRest::createPromGauge(const std::string &
 	return std::make_shared<GaugeMetric>(m_promRegistry, metricName, metricHelp, labels);
 }
 
-void PrometheusRest::handleRest(const HttpRequest &message, const std::map<std::string, std::function<void(const HttpRequest &)>> &restFunctions)
+std::shared_ptr<HistogramMetric> PrometheusRest::createPromHistogram(const std::string &metricName, const std::string &metricHelp, const std::map<std::string, std::string> &labels, const std::vector<double> &buckets)
+{
+	return std::make_shared<HistogramMetric>(m_promRegistry, metricName, metricHelp, labels, buckets);
+}
+
+void PrometheusRest::handleRest(const HttpRequest &message, const RestRouter &restFunctions)
 {
 	if (message.m_method == web::http::methods::GET && message.m_relative_uri != METRIC_PATH)
 		PROM_COUNTER_INCREASE(m_restGetCounter)
@@ -118,6 +172,38 @@ void PrometheusRest::apiMetrics(const HttpRequest &message)
 	{
 		m_appmeshFileDesc->metric().Set(os::pstree()->totalFileDescriptors());
 	}
+	if (m_bufferHeapAllocations)
+	{
+		m_bufferHeapAllocations->advanceTo(BufferPool::instance().heapAllocations());
+	}
+	if (m_bufferPoolReuses)
+	{
+		m_bufferPoolReuses->advanceTo(BufferPool::instance().poolReuses());
+	}
+	for (size_t i = 0; i < m_queueDepth.size(); i++)
+	{
+		const auto stats = TcpHandler::requestQueue().stats(static_cast<RequestLane>(i));
+		m_queueDepth[i]->metric().Set(stats.m_depth);
+		m_queueWaitSeconds[i]->advanceTo(stats.m_waitSeconds);
+		m_queueDequeued[i]->advanceTo(stats.m_dequeued);
+		m_queueRejected[i]->advanceTo(stats.m_rejected);
+		m_queueExpired[i]->advanceTo(stats.m_expired);
+	}
+	if (m_tlsFullHandshakes && m_tlsResumedHandshakes && m_tlsResumptionRatio && m_tlsKernelOffload)
+	{
+		const auto tls = TcpHandler::tlsStats();
+		m_tlsFullHandshakes->advanceTo(tls.m_handshakes - tls.m_resumed);
+		m_tlsResumedHandshakes->advanceTo(tls.m_resumed);
+		m_tlsResumptionRatio->metric().Set(tls.m_handshakes ? (double)tls.m_resumed / tls.m_handshakes : 0);
+		m_tlsKernelOffload->advanceTo(tls.m_kernelOffload);
+	}
+	if (m_uploadActive && m_uploadBytes && m_uploadThroughput)
+	{
+		const auto upload = UploadWriter::stats();
+		m_uploadActive->metric().Set(upload.m_activeUploads);
+		m_uploadBytes->advanceTo(upload.m_totalBytes);
+		m_uploadThroughput->metric().Set(upload.m_lastBytesPerSecond);
+	}
 	auto body = collectData();
 	message.reply(web::http::status_codes::OK, body, CONTENT_TYPE);
 }
@@ -151,6 +237,17 @@ prometheus::Counter &CounterMetric::metric()
 	return *m_metric;
 }
 
+void CounterMetric::advanceTo(double total)
+{
+	// concurrent scrapes must not add the same delta twice
+	std::lock_guard<std::mutex> guard(m_advanceMutex);
+	const auto current = m_metric->Value();
+	if (total > current)
+	{
+		m_metric->Increment(total - current);
+	}
+}
+
 GaugeMetric::GaugeMetric(std::shared_ptr<prometheus::Registry> registry, const std::string &name, const std::string &help, std::map<std::string, std::string> label)
 	: m_metric(nullptr), m_family(nullptr), m_promRegistry(registry), m_name(name), m_help(help), m_label(label)
 {
@@ -180,3 +277,33 @@ prometheus::Gauge &GaugeMetric::metric()
 {
 	return *m_metric;
 }
+
+HistogramMetric::HistogramMetric(std::shared_ptr<prometheus::Registry> registry, const std::string &name, const std::string &help, std::map<std::string, std::string> label, const std::vector<double> &buckets)
+	: m_metric(nullptr), m_family(nullptr), m_promRegistry(registry), m_name(name), m_help(help), m_label(label)
+{
+	const static char fname[] = "HistogramMetric::HistogramMetric() ";
+
+	std::map<std::string, std::string> commonLabels = {{"host", MY_HOST_NAME}, {"pid", std::to_string(ResourceCollection::instance()->getPid())}};
+	commonLabels.insert(label.begin(), label.end());
+
+	auto &family = prometheus::BuildHistogram()
+					   .Name(m_name)
+					   .Help(help)
+					   .Register(*m_promRegistry);
+	m_family = &family;
+	m_metric = &((family.Add(commonLabels, buckets)));
+
+	LOG_DBG << fname << "metric " << m_name << " added";
+}
+
+HistogramMetric::~HistogramMetric()
+{
+	const static char fname[] = "HistogramMetric::~HistogramMetric() ";
+	m_family->Remove(m_metric);
+	LOG_DBG << fname << "metric " << m_name << " removed";
+}
+
+prometheus::Histogram &HistogramMetric::metric()
+{
+	return *m_metric;
+}
@@ -2,6 +2,8 @@
 
 #include <atomic>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 #include <prometheus/family.h>
 
@@ -12,6 +14,7 @@ namespace prometheus
 {
 	class Counter;
 	class Gauge;
+	class Histogram;
 	class Registry;
 }; // namespace prometheus
 
@@ -36,8 +39,13 @@ public:
 	virtual ~CounterMetric();
 
 	prometheus::Counter &metric();
+	/// <summary>
+	/// Advance counter to a monotonic total accumulated by its owner
+	/// </summary>
+	void advanceTo(double total);
 
 private:
+	std::mutex m_advanceMutex;
 	prometheus::Counter *m_metric;
 	prometheus::Family<prometheus::Counter> *m_family;
 	std::shared_ptr<prometheus::Registry> m_promRegistry;
@@ -70,6 +78,30 @@ private:
 	const std::map<std::string, std::string> m_label;
 };
 
+/// <summary>
+/// Metric Wrapper for reg/unreg metric automaticaly
+/// </summary>
+class HistogramMetric
+{
+public:
+	explicit HistogramMetric(std::shared_ptr<prometheus::Registry> registry,
+							 const std::string &name, const std::string &help,
+							 std::map<std::string, std::string> label,
+							 const std::vector<double> &buckets);
+
+	virtual ~HistogramMetric();
+
+	prometheus::Histogram &metric();
+
+private:
+	prometheus::Histogram *m_metric;
+	prometheus::Family<prometheus::Histogram> *m_family;
+	std::shared_ptr<prometheus::Registry> m_promRegistry;
+	const std::string m_name;
+	const std::string m_help;
+	const std::map<std::string, std::string> m_label;
+};
+
 /// <summary>
 /// Prometheus Exporter REST service
 /// </summary>
@@ -95,6 +127,15 @@ public:
 	/// <param name="labels"></param>
 	/// <returns>return null if exporter was not enabled</returns>
 	std::shared_ptr<GaugeMetric> createPromGauge(const std::string &metricName, const std::string &metricHelp, const std::map<std::string, std::string> &labels) noexcept(false);
+	/// <summary>
+	/// Create a Histogram Metric
+	/// </summary>
+	/// <param name="metricName"></param>
+	/// <param name="metricHelp"></param>
+	/// <param name="labels"></param>
+	/// <param name="buckets">bucket upper bounds in ascending order</param>
+	/// <returns>return null if exporter was not enabled</returns>
+	std::shared_ptr<HistogramMetric> createPromHistogram(const std::string &metricName, const std::string &metricHelp, const std::map<std::string, std::string> &labels, const std::vector<double> &buckets) noexcept(false);
 
 	/// <summary>
 	/// Collect all metrics
@@ -114,7 +155,7 @@ protected:
 	/// </summary>
 	/// <param name="message"></param>
 	/// <param name="restFunctions"></param>
-	virtual void handleRest(const HttpRequest &message, const std::map<std::string, std::function<void(const HttpRequest &)>> &restFunctions) override;
+	virtual void handleRest(const HttpRequest &message, const RestRouter &restFunctions) override;
 
 private:
 	/// <summary>
@@ -144,6 +185,24 @@ private:
 	std::shared_ptr<CounterMetric> m_restDelCounter;
 	std::shared_ptr<CounterMetric> m_restPostCounter;
 	std::shared_ptr<GaugeMetric> m_appmeshFileDesc;
+	// TCP frame buffer allocation metric
+	std::shared_ptr<CounterMetric> m_bufferHeapAllocations;
+	std::shared_ptr<CounterMetric> m_bufferPoolReuses;
+	// REST request queue lane metric, indexed by RequestLane
+	std::vector<std::shared_ptr<GaugeMetric>> m_queueDepth;
+	std::vector<std::shared_ptr<CounterMetric>> m_queueWaitSeconds;
+	std::vector<std::shared_ptr<CounterMetric>> m_queueDequeued;
+	std::vector<std::shared_ptr<CounterMetric>> m_queueRejected;
+	std::vector<std::shared_ptr<CounterMetric>> m_queueExpired;
+	// TLS handshake metric
+	std::shared_ptr<CounterMetric> m_tlsFullHandshakes;
+	std::shared_ptr<CounterMetric> m_tlsResumedHandshakes;
+	std::shared_ptr<GaugeMetric> m_tlsResumptionRatio;
+	std::shared_ptr<CounterMetric> m_tlsKernelOffload;
+	// TCP file upload metric
+	std::shared_ptr<GaugeMetric> m_uploadActive;
+	std::shared_ptr<CounterMetric> m_uploadBytes;
+	std::shared_ptr<GaugeMetric> m_uploadThroughput;
 
 public:
 	static std::shared_ptr<PrometheusRest> instance() { return m_instance; }
@@ -165,6 +224,41 @@ public:
 // App Mesh file descriptors
 #define PROM_METRIC_NAME_appmesh_prom_file_descriptor "appmesh_prom_file_descriptor"
 #define PROM_METRIC_HELP_appmesh_prom_file_descriptor "appmesh file descriptors"
+// App Mesh TCP frame buffer allocations
+#define PROM_METRIC_NAME_appmesh_tcp_buffer_allocation_total "appmesh_tcp_buffer_allocation_total"
+#define PROM_METRIC_HELP_appmesh_tcp_buffer_allocation_total "tcp frame buffer allocation count"
+// App Mesh REST request queue
+#define PROM_METRIC_NAME_appmesh_rest_queue_depth "appmesh_rest_queue_depth"
+#define PROM_METRIC_HELP_appmesh_rest_queue_depth "rest request queue depth"
+#define PROM_METRIC_NAME_appmesh_rest_queue_wait_seconds_total "appmesh_rest_queue_wait_seconds_total"
+#define PROM_METRIC_HELP_appmesh_rest_queue_wait_seconds_total "rest request accumulated queue wait seconds"
+#define PROM_METRIC_NAME_appmesh_rest_queue_dequeue_total "appmesh_rest_queue_dequeue_total"
+#define PROM_METRIC_HELP_appmesh_rest_queue_dequeue_total "rest request dequeue count"
+#define PROM_METRIC_NAME_appmesh_rest_queue_reject_total "appmesh_rest_queue_reject_total"
+#define PROM_METRIC_HELP_appmesh_rest_queue_reject_total "rest request rejected count for full queue"
+#define PROM_METRIC_NAME_appmesh_rest_queue_drop_total "appmesh_rest_queue_drop_total"
+#define PROM_METRIC_HELP_appmesh_rest_queue_drop_total "rest request dropped count for deadline passed before handle"
+// App Mesh TLS
+#define PROM_METRIC_NAME_appmesh_tls_handshake_total "appmesh_tls_handshake_total"
+#define PROM_METRIC_HELP_appmesh_tls_handshake_total "tls handshake count of TCP REST port"
+#define PROM_METRIC_NAME_appmesh_tls_resumption_ratio "appmesh_tls_resumption_ratio"
+#define PROM_METRIC_HELP_appmesh_tls_resumption_ratio "ratio of tls handshakes resumed from session cache or ticket"
+#define PROM_METRIC_NAME_appmesh_tls_kernel_offload_total "appmesh_tls_kernel_offload_total"
+#define PROM_METRIC_HELP_appmesh_tls_kernel_offload_total "tls connection count with kernel tls offload"
+// App Mesh file upload
+#define PROM_METRIC_NAME_appmesh_file_upload_active "appmesh_file_upload_active"
+#define PROM_METRIC_HELP_appmesh_file_upload_active "file upload in progress"
+#define PROM_METRIC_NAME_appmesh_file_upload_bytes_total "appmesh_file_upload_bytes_total"
+#define PROM_METRIC_HELP_appmesh_file_upload_bytes_total "file upload bytes written to disk"
+#define PROM_METRIC_NAME_appmesh_file_upload_throughput "appmesh_file_upload_throughput"
+#define PROM_METRIC_HELP_appmesh_file_upload_throughput "bytes per second of last finished file upload"
+// App Mesh application supervisor
+#define PROM_METRIC_NAME_appmesh_app_supervisor_pass_seconds "appmesh_app_supervisor_pass_seconds"
+#define PROM_METRIC_HELP_appmesh_app_supervisor_pass_seconds "duration of one application supervisor shard pass over its due applications"
+#define PROM_METRIC_NAME_appmesh_app_execute_seconds "appmesh_app_execute_seconds"
+#define PROM_METRIC_HELP_appmesh_app_execute_seconds "duration of one application execute"
+#define PROM_METRIC_NAME_appmesh_app_supervisor_slow_shard_total "appmesh_app_supervisor_slow_shard_total"
+#define PROM_METRIC_HELP_appmesh_app_supervisor_slow_shard_total "application supervisor shard passes slower than one second"
 // App Mesh HTTP request count
 #define PROM_METRIC_NAME_appmesh_http_request_count "appmesh_http_request_count"
 #define PROM_METRIC_HELP_appmesh_http_request_count "app mesh http request count"
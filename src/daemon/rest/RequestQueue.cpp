@@ -0,0 +1,224 @@
+#include "RequestQueue.h"
+#include "../../common/Utility.h"
+#include "HttpRequest.h"
+
+// every N dequeue start scan from a rotating lane to avoid starvation
+constexpr uint64_t LANE_FAIRNESS_INTERVAL = 8;
+
+RequestQueue::Worker::Worker()
+	: m_sleeping(false), m_signaled(false), m_popCounter(0)
+{
+}
+
+RequestQueue::RequestQueue(const std::array<size_t, REQUEST_LANE_NUM> &capacities)
+	: m_producerIndex(0), m_closed(false)
+{
+	for (size_t i = 0; i < REQUEST_LANE_NUM; i++)
+	{
+		m_laneCounters[i].m_capacity = capacities[i];
+		m_laneCounters[i].m_depth = 0;
+		m_laneCounters[i].m_dequeued = 0;
+		m_laneCounters[i].m_rejected = 0;
+		m_laneCounters[i].m_expired = 0;
+		m_laneCounters[i].m_waitMicroseconds = 0;
+	}
+}
+
+RequestQueue::~RequestQueue()
+{
+	close();
+}
+
+void RequestQueue::init(size_t workerNum)
+{
+	m_workers.clear();
+	for (size_t i = 0; i < std::max(workerNum, (size_t)1); i++)
+		m_workers.push_back(std::make_unique<Worker>());
+}
+
+RequestLane RequestQueue::classify(const HttpRequest &request)
+{
+	const auto &method = request.m_method;
+	const auto &path = request.m_relative_uri;
+
+	if (method == web::http::methods::OPTIONS || method == web::http::methods::HEAD ||
+		path == "/metrics" || path == "/appmesh/metrics" ||
+		(Utility::startWith(path, "/appmesh/app/") && Utility::endWith(path, "/health")))
+	{
+		return RequestLane::Health;
+	}
+	if (path == "/appmesh/app/run" || path == "/appmesh/app/syncrun" || Utility::startWith(path, "/appmesh/file/"))
+	{
+		return RequestLane::LongRunning;
+	}
+	if (method == web::http::methods::GET)
+	{
+		return RequestLane::Read;
+	}
+	return RequestLane::Mutation;
+}
+
+const char *RequestQueue::laneName(RequestLane lane)
+{
+	static const char *LANE_NAMES[] = {"health", "read", "mutation", "long"};
+	return LANE_NAMES[static_cast<size_t>(lane)];
+}
+
+bool RequestQueue::enqueue(const std::shared_ptr<HttpRequest> &request)
+{
+	const auto lane = classify(*request);
+	auto &counter = m_laneCounters[static_cast<size_t>(lane)];
+	if (m_closed || m_workers.empty())
+	{
+		counter.m_rejected++;
+		return false;
+	}
+	if (counter.m_depth.fetch_add(1) >= counter.m_capacity)
+	{
+		counter.m_depth--;
+		counter.m_rejected++;
+		return false;
+	}
+
+	// prefer a sleeping worker, otherwise round robin
+	const auto workerNum = m_workers.size();
+	const auto start = m_producerIndex++;
+	size_t target = start % workerNum;
+	for (size_t i = 0; i < workerNum; i++)
+	{
+		if (m_workers[(start + i) % workerNum]->m_sleeping)
+		{
+			target = (start + i) % workerNum;
+			break;
+		}
+	}
+	auto &worker = *m_workers[target];
+	{
+		std::lock_guard<std::mutex> guard(worker.m_mutex);
+		worker.m_lanes[static_cast<size_t>(lane)].push_back(QueueItem{request, lane, std::chrono::steady_clock::now()});
+	}
+
+	// pair with seq_cst store of m_sleeping in dequeue(): either the sleeping
+	// worker re-scan finds this item, or this scan finds it sleeping
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (worker.m_sleeping)
+	{
+		wakeup(worker);
+	}
+	else
+	{
+		for (size_t i = 1; i < workerNum; i++)
+		{
+			auto &other = *m_workers[(target + i) % workerNum];
+			if (other.m_sleeping)
+			{
+				wakeup(other);
+				break;
+			}
+		}
+	}
+	return true;
+}
+
+std::shared_ptr<HttpRequest> RequestQueue::dequeue(size_t workerIndex)
+{
+	auto &self = *m_workers[workerIndex % m_workers.size()];
+	QueueItem item;
+	while (!m_closed)
+	{
+		if (tryGet(workerIndex, item))
+			return complete(item);
+
+		self.m_sleeping = true;
+		// re-scan after announce sleeping to avoid lost wakeup
+		if (tryGet(workerIndex, item))
+		{
+			self.m_sleeping = false;
+			return complete(item);
+		}
+		{
+			std::unique_lock<std::mutex> lock(self.m_mutex);
+			self.m_cond.wait(lock, [&self, this]()
+							 { return self.m_signaled || m_closed; });
+			self.m_signaled = false;
+		}
+		self.m_sleeping = false;
+	}
+	return nullptr;
+}
+
+void RequestQueue::expired(RequestLane lane)
+{
+	m_laneCounters[static_cast<size_t>(lane)].m_expired++;
+}
+
+void RequestQueue::close()
+{
+	m_closed = true;
+	for (auto &worker : m_workers)
+	{
+		std::lock_guard<std::mutex> guard(worker->m_mutex);
+		for (auto &lane : worker->m_lanes)
+			lane.clear();
+		worker->m_signaled = true;
+		worker->m_cond.notify_all();
+	}
+	for (auto &counter : m_laneCounters)
+		counter.m_depth = 0;
+}
+
+RequestQueue::LaneStats RequestQueue::stats(RequestLane lane) const
+{
+	const auto &counter = m_laneCounters[static_cast<size_t>(lane)];
+	return LaneStats{counter.m_depth.load(), counter.m_dequeued.load(), counter.m_rejected.load(), counter.m_expired.load(), counter.m_waitMicroseconds.load() / 1000000.0};
+}
+
+bool RequestQueue::tryPop(Worker &worker, size_t startLane, QueueItem &item)
+{
+	std::lock_guard<std::mutex> guard(worker.m_mutex);
+	for (size_t i = 0; i < REQUEST_LANE_NUM; i++)
+	{
+		auto &lane = worker.m_lanes[(startLane + i) % REQUEST_LANE_NUM];
+		if (!lane.empty())
+		{
+			item = std::move(lane.front());
+			lane.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool RequestQueue::tryGet(size_t workerIndex, QueueItem &item)
+{
+	const auto workerNum = m_workers.size();
+	auto &self = *m_workers[workerIndex % workerNum];
+	const auto counter = self.m_popCounter++;
+	const size_t startLane = (counter % LANE_FAIRNESS_INTERVAL == 0) ? (counter / LANE_FAIRNESS_INTERVAL) % REQUEST_LANE_NUM : 0;
+
+	if (tryPop(self, startLane, item))
+		return true;
+	// steal from others
+	for (size_t i = 1; i < workerNum; i++)
+	{
+		if (tryPop(*m_workers[(workerIndex + i) % workerNum], startLane, item))
+			return true;
+	}
+	return false;
+}
+
+void RequestQueue::wakeup(Worker &worker)
+{
+	std::lock_guard<std::mutex> guard(worker.m_mutex);
+	worker.m_signaled = true;
+	worker.m_cond.notify_one();
+}
+
+std::shared_ptr<HttpRequest> RequestQueue::complete(QueueItem &item)
+{
+	auto &counter = m_laneCounters[static_cast<size_t>(item.m_lane)];
+	counter.m_depth--;
+	counter.m_dequeued++;
+	counter.m_waitMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - item.m_enqueueTime).count();
+	return std::move(item.m_request);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class HttpRequest;
+
+/// <summary>
+/// Priority lanes of REST request queue, smaller value has higher priority
+/// </summary>
+enum class RequestLane : int
+{
+	Health = 0,	 // health check, metrics, OPTIONS/HEAD
+	Read,		 // GET
+	Mutation,	 // PUT/POST/DELETE
+	LongRunning, // app run, file download/upload
+	Count
+};
+constexpr size_t REQUEST_LANE_NUM = static_cast<size_t>(RequestLane::Count);
+
+/// <summary>
+/// Bounded REST request queue with priority lanes and work stealing workers.
+/// Each lane has its own capacity, enqueue to a full lane fails immediately
+/// so that caller can shed load instead of queue without limit.
+/// Each worker owns per-lane deques fed by reactor threads (prefer idle worker),
+/// a worker without local work steals from other workers before sleep, and a
+/// sleeping worker is only woken when it is needed, so there is no shared lock
+/// and no condition variable notify for every request.
+/// Dequeue prefers higher priority lanes, and periodically starts from a
+/// rotating lane so lower priority lanes are not starved.
+/// </summary>
+class RequestQueue
+{
+public:
+	/// <summary>
+	/// Per lane statistics
+	/// </summary>
+	struct LaneStats
+	{
+		size_t m_depth;
+		uint64_t m_dequeued;
+		uint64_t m_rejected;
+		uint64_t m_expired; // dequeued but dropped for deadline passed
+		double m_waitSeconds; // accumulated queue wait time of dequeued requests
+	};
+
+	explicit RequestQueue(const std::array<size_t, REQUEST_LANE_NUM> &capacities);
+	virtual ~RequestQueue();
+
+	/// <summary>
+	/// Create worker slots, should be called before enqueue and dequeue
+	/// </summary>
+	void init(size_t workerNum);
+
+	/// <summary>
+	/// Get lane for a request according to method and path
+	/// </summary>
+	static RequestLane classify(const HttpRequest &request);
+	static const char *laneName(RequestLane lane);
+
+	/// <summary>
+	/// Enqueue request to its lane
+	/// </summary>
+	/// <returns>false if lane is full or queue closed</returns>
+	bool enqueue(const std::shared_ptr<HttpRequest> &request);
+
+	/// <summary>
+	/// Block until get a request for worker
+	/// </summary>
+	/// <param name="workerIndex">worker index less than init() worker number</param>
+	/// <returns>nullptr when queue closed</returns>
+	std::shared_ptr<HttpRequest> dequeue(size_t workerIndex);
+
+	/// <summary>
+	/// Count a dequeued request dropped by worker for its deadline passed
+	/// </summary>
+	void expired(RequestLane lane);
+
+	void close();
+	LaneStats stats(RequestLane lane) const;
+
+private:
+	struct QueueItem
+	{
+		std::shared_ptr<HttpRequest> m_request;
+		RequestLane m_lane;
+		std::chrono::steady_clock::time_point m_enqueueTime;
+	};
+	struct Worker
+	{
+		Worker();
+		std::mutex m_mutex;
+		std::condition_variable m_cond;
+		std::array<std::deque<QueueItem>, REQUEST_LANE_NUM> m_lanes;
+		std::atomic_bool m_sleeping;
+		bool m_signaled;
+		uint64_t m_popCounter;
+	};
+	struct LaneCounter
+	{
+		size_t m_capacity;
+		std::atomic<size_t> m_depth;
+		std::atomic<uint64_t> m_dequeued;
+		std::atomic<uint64_t> m_rejected;
+		std::atomic<uint64_t> m_expired;
+		std::atomic<uint64_t> m_waitMicroseconds;
+	};
+
+	// pop from one worker in lane priority order, start lane rotates for fairness
+	bool tryPop(Worker &worker, size_t startLane, QueueItem &item);
+	// pop local first and then steal from others
+	bool tryGet(size_t workerIndex, QueueItem &item);
+	void wakeup(Worker &worker);
+	std::shared_ptr<HttpRequest> complete(QueueItem &item);
+
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	std::array<LaneCounter, REQUEST_LANE_NUM> m_laneCounters;
+	std::atomic_size_t m_producerIndex;
+	std::atomic_bool m_closed;
+};
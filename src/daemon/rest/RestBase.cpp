@@ -1,11 +1,13 @@
 #include <functional>
 
 #include <boost/algorithm/string_regex.hpp>
+#include <curlpp/cURLpp.hpp>
 #include <jwt-cpp/traits/nlohmann-json/defaults.h>
 
 #include "../../common/Utility.h"
 #include "../Configuration.h"
 #include "../ResourceCollection.h"
+#include "../security/JwtClaimsCache.h"
 #include "../security/Security.h"
 #include "../security/TokenBlacklist.h"
 #include "HttpRequest.h"
@@ -56,11 +58,10 @@ void RestBase::handle_head(const HttpRequest &message)
     message.reply(web::http::status_codes::OK);
 }
 
-void RestBase::handleRest(const HttpRequest &message, const std::map<std::string, std::function<void(const HttpRequest &)>> &restFunctions)
+void RestBase::handleRest(const HttpRequest &message, const RestRouter &restFunctions)
 {
     const static char fname[] = "RestHandler::handleRest() ";
     REST_INFO_PRINT;
-    std::function<void(const HttpRequest &)> stdFunction;
     const auto path = Utility::stringReplace(message.m_relative_uri, "//", "/");
 
     if (path == "/" || path.empty())
@@ -71,17 +72,9 @@ void RestBase::handleRest(const HttpRequest &message, const std::map<std::string
         return;
     }
 
-    bool findRest = false;
-    for (const auto &kvp : restFunctions)
-    {
-        if (path == kvp.first || boost::regex_match(path, boost::regex(kvp.first)))
-        {
-            findRest = true;
-            stdFunction = kvp.second;
-            break;
-        }
-    }
-    if (!findRest)
+    PathParams pathParams;
+    const auto stdFunction = restFunctions.match(path, pathParams);
+    if (stdFunction == nullptr)
     {
         message.reply(web::http::status_codes::NotFound, convertText2Json(Utility::stringFormat("Path not found %s:%s", message.m_method.c_str(), path.c_str())));
         return;
@@ -91,18 +84,18 @@ void RestBase::handleRest(const HttpRequest &message, const std::map<std::string
     {
         // this is REST handler service, defend XSS attach before enter to REST handler
         const_cast<HttpRequest *>(&message)->m_relative_uri = replaceXssRiskChars(message.m_relative_uri);
+        for (auto &param : pathParams)
+        {
+            param.second = Utility::stdStringTrim(curlpp::unescape(replaceXssRiskChars(param.second)));
+        }
+        const_cast<HttpRequest *>(&message)->m_pathParams = std::move(pathParams);
         if (message.m_body.length())
         {
-            auto body = nlohmann::json::parse(message.m_body);
-            if (body.is_string())
-            {
-                body = nlohmann::json::parse(body.get<std::string>());
-            }
-            // tranverseJsonTree(body);
-            const_cast<HttpRequest *>(&message)->m_body = body.dump();
+            // reject invalid JSON body before handler, parsed document is cached for handlers
+            message.bodyJson();
         }
 
-        stdFunction(message);
+        (*stdFunction)(message);
     }
     catch (const NotFoundException &e)
     {
@@ -134,15 +127,15 @@ void RestBase::bindRestMethod(const web::http::method &method, const std::string
 
     LOG_DBG << fname << "bind " << method << " for " << path;
 
-    // bind to map
+    // compile to route tree
     if (method == web::http::methods::GET)
-        m_restGetFunctions[path] = std::move(func);
+        m_restGetFunctions.add(path, std::move(func));
     else if (method == web::http::methods::PUT)
-        m_restPutFunctions[path] = std::move(func);
+        m_restPutFunctions.add(path, std::move(func));
     else if (method == web::http::methods::POST)
-        m_restPstFunctions[path] = std::move(func);
+        m_restPstFunctions.add(path, std::move(func));
     else if (method == web::http::methods::DEL)
-        m_restDelFunctions[path] = std::move(func);
+        m_restDelFunctions.add(path, std::move(func));
     else
         LOG_ERR << fname << method << " not supported.";
 }
@@ -225,10 +218,17 @@ void RestBase::tranverseJsonTree(nlohmann::json &val)
 const std::tuple<std::string, std::string> RestBase::verifyToken(const HttpRequest &message)
 {
     const auto token = getJwtToken(message);
+    // read before any check, invalidation during verification drops the put below
+    const auto generation = JWT_CLAIMS_CACHE::instance()->generation();
 
     if (TOKEN_BLACK_LIST::instance()->isTokenBlacklisted(token))
         throw std::invalid_argument("token blocked");
 
+    // token verified before and not invalidated
+    JwtClaims claims;
+    if (JWT_CLAIMS_CACHE::instance()->get(token, claims))
+        return std::make_tuple(claims.m_userName, claims.m_userGroup);
+
     const auto decoded_token = jwt::decode(token);
     if (decoded_token.has_payload_claim(HTTP_HEADER_JWT_name))
     {
@@ -252,6 +252,14 @@ const std::tuple<std::string, std::string> RestBase::verifyToken(const HttpReque
 
         verifier.verify(decoded_token);
 
+        // token without expiry is not cached
+        if (decoded_token.has_expires_at())
+        {
+            claims.m_userName = userName.as_string();
+            claims.m_userGroup = userGroup.as_string();
+            claims.m_expiry = decoded_token.get_expires_at();
+            JWT_CLAIMS_CACHE::instance()->put(token, claims, generation);
+        }
         return std::make_tuple(userName.as_string(), userGroup.as_string());
     }
     else
@@ -263,6 +271,10 @@ const std::tuple<std::string, std::string> RestBase::verifyToken(const HttpReque
 const std::string RestBase::getJwtUserName(const HttpRequest &message)
 {
     const auto token = getJwtToken(message);
+    JwtClaims claims;
+    if (JWT_CLAIMS_CACHE::instance()->get(token, claims))
+        return claims.m_userName;
+
     const auto decoded_token = jwt::decode(token);
     if (decoded_token.has_payload_claim(HTTP_HEADER_JWT_name))
     {
@@ -282,8 +294,9 @@ bool RestBase::permissionCheck(const HttpRequest &message, const std::string &pe
     const auto result = verifyToken(message);
     const auto userName = std::get<0>(result);
     const auto groupName = std::get<1>(result);
-    // check user role permission
-    if (permission.empty() || Security::instance()->getUserPermissions(userName, groupName).count(permission))
+    // check user role permission with immutable snapshot, no Security lock and no allocation
+    const auto snapshot = Security::snapshot();
+    if (permission.empty() || (snapshot && snapshot->hasPermission(userName, groupName, permission)))
     {
         LOG_DBG << fname << "authentication success for remote: " << message.m_remote_address << " with user : " << userName << " and permission : " << permission;
         return true;
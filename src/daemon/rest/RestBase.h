@@ -4,6 +4,7 @@
 #include <memory>
 
 #include "../../common/Utility.h"
+#include "RestRouter.h"
 
 class HttpRequest;
 
@@ -31,12 +32,12 @@ protected:
     /// </summary>
     /// <param name="message"></param>
     /// <param name="restFunctions"></param>
-    virtual void handleRest(const HttpRequest &message, const std::map<std::string, std::function<void(const HttpRequest &)>> &restFunctions);
+    virtual void handleRest(const HttpRequest &message, const RestRouter &restFunctions);
     /// <summary>
     /// Bind a REST path to a function
     /// </summary>
     /// <param name="method"></param>
-    /// <param name="path">support regex</param>
+    /// <param name="path">route pattern, support typed path parameter like /appmesh/app/{name}</param>
     /// <param name="func"></param>
     void bindRestMethod(const web::http::method &method, const std::string &path, std::function<void(const HttpRequest &)> func);
 
@@ -57,11 +58,11 @@ protected:
     const std::string createJwtToken(const std::string &uname, const std::string &userGroup, int timeoutSeconds);
 
 protected:
-    // API functions
-    std::map<std::string, std::function<void(const HttpRequest &)>> m_restGetFunctions;
-    std::map<std::string, std::function<void(const HttpRequest &)>> m_restPutFunctions;
-    std::map<std::string, std::function<void(const HttpRequest &)>> m_restPstFunctions;
-    std::map<std::string, std::function<void(const HttpRequest &)>> m_restDelFunctions;
+    // API functions, compiled route tree per method
+    RestRouter m_restGetFunctions;
+    RestRouter m_restPutFunctions;
+    RestRouter m_restPstFunctions;
+    RestRouter m_restDelFunctions;
 };
 
 #define REST_INFO_PRINT                       \
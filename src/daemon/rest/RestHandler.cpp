@@ -1,7 +1,7 @@
+#include <algorithm>
 #include <chrono>
 
-#include <boost/algorithm/string_regex.hpp>
-#include <curlpp/cURLpp.hpp>
+#include <ace/OS_NS_sys_stat.h>
 #include <jwt-cpp/traits/nlohmann-json/defaults.h>
 
 #include "../../common/DurationParse.h"
@@ -12,6 +12,7 @@
 #include "../Configuration.h"
 #include "../Label.h"
 #include "../ResourceCollection.h"
+#include "../application/AppChangeJournal.h"
 #include "../application/Application.h"
 #include "../consul/ConsulConnection.h"
 #include "../security/Security.h"
@@ -29,27 +30,35 @@ constexpr auto REST_PATH_TOKEN_RENEW = "/appmesh/token/renew";
 constexpr auto REST_PATH_SEC_TOTP_SECRET = "/appmesh/totp/secret";
 constexpr auto REST_PATH_SEC_TOTP_SETUP = "/appmesh/totp/setup";
 constexpr auto REST_PATH_SEC_TOTP_VALIDATE = "/appmesh/totp/validate";
-constexpr auto REST_PATH_SEC_TOTP_DISABLE = R"(/appmesh/totp/([^/\*]+)/disable)";
+constexpr auto REST_PATH_SEC_TOTP_DISABLE = "/appmesh/totp/{user}/disable";
 
 // 2. View Application
-constexpr auto REST_PATH_APP_VIEW = R"(/appmesh/app/([^/\*]+))";
-constexpr auto REST_PATH_APP_OUT_VIEW = R"(/appmesh/app/([^/\*]+)/output)";
+constexpr auto REST_PATH_APP_VIEW = "/appmesh/app/{name}";
+constexpr auto REST_PATH_APP_OUT_VIEW = "/appmesh/app/{name}/output";
 constexpr auto REST_PATH_APP_ALL_VIEW = "/appmesh/applications";
-constexpr auto REST_PATH_APP_HEALTH = R"(/appmesh/app/([^/\*]+)/health)";
+constexpr auto REST_PATH_APP_ALL_WATCH = "/appmesh/applications/watch";
+constexpr auto REST_PATH_APP_HEALTH = "/appmesh/app/{name}/health";
+// page size of application list
+constexpr int APP_LIST_DEFAULT_PAGE_SIZE = 100;
+constexpr int APP_LIST_MAX_PAGE_SIZE = 1000;
+// long poll timeout of application watch
+constexpr int APP_WATCH_DEFAULT_TIMEOUT_SECONDS = 30;
+constexpr int APP_WATCH_MAX_TIMEOUT_SECONDS = 300;
+constexpr size_t APP_WATCH_MAX_WATCHERS = 1024;
 
 // 3. Cloud Application
 constexpr auto REST_PATH_CLOUD_APP_ALL_VIEW = "/appmesh/cloud/applications";
-constexpr auto REST_PATH_CLOUD_APP_VIEW = R"(/appmesh/cloud/app/([^/\*]+))";
-constexpr auto REST_PATH_CLOUD_APP_OUT_VIEW = R"(/appmesh/cloud/app/([^/\*]+)/output/([^/\*]+))";
-constexpr auto REST_PATH_CLOUD_APP_ADD = R"(/appmesh/cloud/app/([^/\*]+))";
-constexpr auto REST_PATH_CLOUD_APP_DELETE = R"(/appmesh/cloud/app/([^/\*]+))";
+constexpr auto REST_PATH_CLOUD_APP_VIEW = "/appmesh/cloud/app/{name}";
+constexpr auto REST_PATH_CLOUD_APP_OUT_VIEW = "/appmesh/cloud/app/{name}/output/{host}";
+constexpr auto REST_PATH_CLOUD_APP_ADD = "/appmesh/cloud/app/{name}";
+constexpr auto REST_PATH_CLOUD_APP_DELETE = "/appmesh/cloud/app/{name}";
 constexpr auto REST_PATH_CLOUD_NODES_VIEW = "/appmesh/cloud/nodes";
 
 // 4. Manage Application
-constexpr auto REST_PATH_APP_ADD = R"(/appmesh/app/([^/\*]+))";
-constexpr auto REST_PATH_APP_ENABLE = R"(/appmesh/app/([^/\*]+)/enable)";
-constexpr auto REST_PATH_APP_DISABLE = R"(/appmesh/app/([^/\*]+)/disable)";
-constexpr auto REST_PATH_APP_DELETE = R"(/appmesh/app/([^/\*]+))";
+constexpr auto REST_PATH_APP_ADD = "/appmesh/app/{name}";
+constexpr auto REST_PATH_APP_ENABLE = "/appmesh/app/{name}/enable";
+constexpr auto REST_PATH_APP_DISABLE = "/appmesh/app/{name}/disable";
+constexpr auto REST_PATH_APP_DELETE = "/appmesh/app/{name}";
 
 // 5. Operate Application
 constexpr auto REST_PATH_APP_RUN_ASYNC = "/appmesh/app/run";
@@ -61,24 +70,24 @@ constexpr auto REST_PATH_FILE_UPLOAD = "/appmesh/file/upload";
 
 // 7. Label Management
 constexpr auto REST_PATH_LABEL_VIEW_ALL = "/appmesh/labels";
-constexpr auto REST_PATH_LABEL_ADD = R"(/appmesh/label/([^/\*]+))";
-constexpr auto REST_PATH_LABEL_DELETE = R"(/appmesh/label/([^/\*]+))";
+constexpr auto REST_PATH_LABEL_ADD = "/appmesh/label/{name}";
+constexpr auto REST_PATH_LABEL_DELETE = "/appmesh/label/{name}";
 
 // 8. Config
 constexpr auto REST_PATH_CONFIG_VIEW = "/appmesh/config";
 constexpr auto REST_PATH_CONFIG_SET = "/appmesh/config";
 
 // 9. Security
-constexpr auto REST_PATH_SEC_USER_CHANGE_PWD = R"(/appmesh/user/([^/\*]+)/passwd)";
-constexpr auto REST_PATH_SEC_USER_LOCK = R"(/appmesh/user/([^/\*]+)/lock)";
-constexpr auto REST_PATH_SEC_USER_UNLOCK = R"(/appmesh/user/([^/\*]+)/unlock)";
-constexpr auto REST_PATH_SEC_USER_ADD = R"(/appmesh/user/([^/\*]+))";
+constexpr auto REST_PATH_SEC_USER_CHANGE_PWD = "/appmesh/user/{name}/passwd";
+constexpr auto REST_PATH_SEC_USER_LOCK = "/appmesh/user/{name}/lock";
+constexpr auto REST_PATH_SEC_USER_UNLOCK = "/appmesh/user/{name}/unlock";
+constexpr auto REST_PATH_SEC_USER_ADD = "/appmesh/user/{name}";
 constexpr auto REST_PATH_SEC_USER_VIEW = "/appmesh/user/self";
-constexpr auto REST_PATH_SEC_USER_DELETE = R"(/appmesh/user/([^/\*]+))";
+constexpr auto REST_PATH_SEC_USER_DELETE = "/appmesh/user/{name}";
 constexpr auto REST_PATH_SEC_USER_VIEW_ALL = "/appmesh/users";
 constexpr auto REST_PATH_SEC_ROLE_VIEW_ALL = "/appmesh/roles";
-constexpr auto REST_PATH_SEC_ROLE_UPDATE = R"(/appmesh/role/([^/\*]+))";
-constexpr auto REST_PATH_SEC_ROLE_DELETE = R"(/appmesh/role/([^/\*]+))";
+constexpr auto REST_PATH_SEC_ROLE_UPDATE = "/appmesh/role/{name}";
+constexpr auto REST_PATH_SEC_ROLE_DELETE = "/appmesh/role/{name}";
 constexpr auto REST_PATH_SEC_USER_PERM_VIEW = "/appmesh/user/permissions";
 constexpr auto REST_PATH_SEC_PERM_VIEW_ALL = "/appmesh/permissions";
 constexpr auto REST_PATH_SEC_USER_GROUPS_VIEW = "/appmesh/user/groups";
@@ -103,6 +112,7 @@ RestHandler::RestHandler() : PrometheusRest()
 	bindRestMethod(web::http::methods::GET, REST_PATH_APP_VIEW, std::bind(&RestHandler::apiAppView, this, std::placeholders::_1));
 	bindRestMethod(web::http::methods::GET, REST_PATH_APP_OUT_VIEW, std::bind(&RestHandler::apiAppOutputView, this, std::placeholders::_1));
 	bindRestMethod(web::http::methods::GET, REST_PATH_APP_ALL_VIEW, std::bind(&RestHandler::apiAppsView, this, std::placeholders::_1));
+	bindRestMethod(web::http::methods::GET, REST_PATH_APP_ALL_WATCH, std::bind(&RestHandler::apiAppsWatch, this, std::placeholders::_1));
 	bindRestMethod(web::http::methods::GET, REST_PATH_APP_HEALTH, std::bind(&RestHandler::apiHealth, this, std::placeholders::_1));
 
 	// 3. Cloud Application
@@ -210,69 +220,10 @@ std::string RestHandler::getHttpQueryString(const HttpRequest &message, const st
 	return rt;
 }
 
-std::string RestHandler::regexSearch(const std::string &value, const char *expr)
-{
-	const static char fname[] = "RestHandler::regexSearch() ";
-
-	std::string result;
-	boost::regex expression(expr);
-	boost::smatch what;
-	if (boost::regex_search(value, what, expression) && what.size() > 1)
-	{
-		// NOTE: start from position 1, skip the REST patch prefix
-		for (size_t i = 1; i < what.size(); ++i)
-		{
-			if (what[i].matched)
-			{
-				result = Utility::stdStringTrim(what[i].str());
-				if (result.length())
-				{
-					return result;
-				}
-				LOG_WAR << fname << "no data from path :" << value << " for regex expression: " << expr;
-				throw std::invalid_argument("no data from path for regex search");
-			}
-		}
-	}
-	LOG_WAR << fname << "failed parse data from path :" << value << " for regex expression: " << expr;
-	throw std::invalid_argument("failed to search data from regex expression");
-}
-
-std::tuple<std::string, std::string> RestHandler::regexSearch2(const std::string &value, const char *expr)
-{
-	const static char fname[] = "RestHandler::regexSearch2() ";
-
-	std::string first, second;
-	boost::regex expression(expr);
-	boost::smatch what;
-	if (boost::regex_search(value, what, expression) && what.size() > 1)
-	{
-		// NOTE: start from position 1, skip the REST patch prefix
-		for (size_t i = 1; i < what.size(); ++i)
-		{
-			if (what[i].matched)
-			{
-				if (first.empty())
-				{
-					first = Utility::stdStringTrim(what[i].str());
-				}
-				else if (second.empty())
-				{
-					second = Utility::stdStringTrim(what[i].str());
-					return std::make_tuple(first, second);
-				}
-			}
-		}
-	}
-	LOG_WAR << fname << "failed parse data from path :" << value << " for regex expression: " << expr;
-	throw std::invalid_argument("failed to search data from regex expression");
-}
-
 void RestHandler::apiAppEnable(const HttpRequest &message)
 {
 	permissionCheck(message, PERMISSION_KEY_app_control);
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto appName = regexSearch(path, REST_PATH_APP_ENABLE);
+	auto appName = message.pathParam("name");
 
 	checkAppAccessPermission(message, appName, true);
 
@@ -283,8 +234,7 @@ void RestHandler::apiAppEnable(const HttpRequest &message)
 void RestHandler::apiAppDisable(const HttpRequest &message)
 {
 	permissionCheck(message, PERMISSION_KEY_app_control);
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto appName = regexSearch(path, REST_PATH_APP_DISABLE);
+	auto appName = message.pathParam("name");
 
 	checkAppAccessPermission(message, appName, true);
 
@@ -294,8 +244,7 @@ void RestHandler::apiAppDisable(const HttpRequest &message)
 
 void RestHandler::apiAppDelete(const HttpRequest &message)
 {
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto appName = regexSearch(path, REST_PATH_APP_DELETE);
+	auto appName = message.pathParam("name");
 
 	if (!Configuration::instance()->isAppExist(appName))
 	{
@@ -345,15 +294,74 @@ void RestHandler::apiFileDownload(const HttpRequest &message)
 	headers[HTTP_HEADER_KEY_file_mode] = std::to_string(std::get<0>(fileInfo));
 	headers[HTTP_HEADER_KEY_file_user] = std::to_string(std::get<1>(fileInfo));
 	headers[HTTP_HEADER_KEY_file_group] = std::to_string(std::get<2>(fileInfo));
+	headers[web::http::header_names::accept_ranges] = "bytes";
 	std::string body = HttpRequest::emptyJson().dump();
+	auto status = web::http::status_codes::OK;
 	if (!(message.m_headers.count(web::http::header_names::user_agent) && message.m_headers.find(web::http::header_names::user_agent)->second == HTTP_USER_AGENT_APPMESH_GO))
 	{
 		LOG_DBG << fname << "Downloading file not from App Mesh agent";
+		// byte range is served by TCP stream here, agent serve range for HTTP client itself
+		const int64_t fileSize = ACE_OS::filesize(file.c_str());
+		int64_t offset = 0;
+		int64_t length = fileSize;
+		if (message.m_headers.count(web::http::header_names::range))
+		{
+			if (!parseByteRange(message.m_headers.find(web::http::header_names::range)->second, fileSize, offset, length))
+			{
+				headers[web::http::header_names::content_range] = std::string("bytes */") + std::to_string(fileSize);
+				message.reply(web::http::status_codes::RangeNotSatisfiable, convertText2Json("invalid range"), headers);
+				return;
+			}
+			status = web::http::status_codes::PartialContent;
+			headers[web::http::header_names::content_range] = Utility::stringFormat("bytes %lld-%lld/%lld", (long long)offset, (long long)(offset + length - 1), (long long)fileSize);
+		}
 		auto wrapper = convertText2Json("download from TCP stream");
 		wrapper[TCP_JSON_MSG_FILE] = file;
+		wrapper[TCP_JSON_MSG_FILE_OFFSET] = offset;
+		wrapper[TCP_JSON_MSG_FILE_LENGTH] = length;
 		body = wrapper.dump();
 	}
-	message.reply(web::http::status_codes::OK, body, headers, web::http::mime_types::application_octetstream);
+	message.reply(status, body, headers, web::http::mime_types::application_octetstream);
+}
+
+bool RestHandler::parseByteRange(const std::string &range, int64_t fileSize, int64_t &offset, int64_t &length)
+{
+	// single range only: "bytes=start-end", "bytes=start-" or "bytes=-suffix"
+	const std::string unit = "bytes=";
+	if (range.compare(0, unit.length(), unit) != 0 || range.find(',') != std::string::npos)
+		return false;
+	const auto spec = range.substr(unit.length());
+	const auto dash = spec.find('-');
+	if (dash == std::string::npos)
+		return false;
+	const auto first = spec.substr(0, dash);
+	const auto last = spec.substr(dash + 1);
+	if (first.empty() && last.empty())
+		return false;
+	if (!(first.empty() || Utility::isNumber(first)) || !(last.empty() || Utility::isNumber(last)))
+		return false;
+	try
+	{
+		if (first.empty())
+		{
+			// suffix range: last N bytes
+			const auto suffix = std::min<int64_t>(std::stoll(last), fileSize);
+			offset = fileSize - suffix;
+			length = suffix;
+		}
+		else
+		{
+			offset = std::stoll(first);
+			const int64_t end = last.empty() ? fileSize - 1 : std::min<int64_t>(std::stoll(last), fileSize - 1);
+			length = end - offset + 1;
+		}
+	}
+	catch (const std::out_of_range &)
+	{
+		// position exceed int64 range
+		return false;
+	}
+	return offset >= 0 && offset < fileSize && length > 0;
 }
 
 void RestHandler::apiFileUpload(const HttpRequest &message)
@@ -405,8 +413,7 @@ void RestHandler::apiLabelAdd(const HttpRequest &message)
 {
 	permissionCheck(message, PERMISSION_KEY_label_set);
 
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto labelKey = regexSearch(path, REST_PATH_LABEL_ADD);
+	auto labelKey = message.pathParam("name");
 
 	auto querymap = message.m_querys;
 	if (querymap.find((HTTP_QUERY_KEY_label_value)) != querymap.end())
@@ -428,8 +435,7 @@ void RestHandler::apiLabelDel(const HttpRequest &message)
 {
 	permissionCheck(message, PERMISSION_KEY_label_delete);
 
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto labelKey = regexSearch(path, REST_PATH_LABEL_DELETE);
+	auto labelKey = message.pathParam("name");
 
 	Configuration::instance()->getLabel()->delLabel(labelKey);
 	Configuration::instance()->saveConfigToDisk();
@@ -475,8 +481,7 @@ void RestHandler::apiUserChangePwd(const HttpRequest &message)
 {
 	const static char fname[] = "RestHandler::apiUserChangePwd() ";
 
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto targetUser = regexSearch(path, REST_PATH_SEC_USER_CHANGE_PWD);
+	auto targetUser = message.pathParam("name");
 	const auto tokenUserName = getJwtUserName(message);
 	if (targetUser == "self")
 	{
@@ -515,9 +520,8 @@ void RestHandler::apiUserLock(const HttpRequest &message)
 {
 	const static char fname[] = "RestHandler::apiUserLock() ";
 
-	const auto path = (curlpp::unescape(message.m_relative_uri));
 	permissionCheck(message, PERMISSION_KEY_lock_user);
-	auto pathUserName = regexSearch(path, REST_PATH_SEC_USER_LOCK);
+	auto pathUserName = message.pathParam("name");
 	const auto tokenUserName = getJwtUserName(message);
 
 	if (pathUserName == JWT_ADMIN_NAME)
@@ -537,9 +541,8 @@ void RestHandler::apiUserUnlock(const HttpRequest &message)
 {
 	const static char fname[] = "RestHandler::apiUserUnlock() ";
 
-	const auto path = (curlpp::unescape(message.m_relative_uri));
 	permissionCheck(message, PERMISSION_KEY_unlock_user);
-	auto pathUserName = regexSearch(path, REST_PATH_SEC_USER_UNLOCK);
+	auto pathUserName = message.pathParam("name");
 	const auto tokenUserName = getJwtUserName(message);
 
 	Security::instance()->getUserInfo(pathUserName)->unlock();
@@ -554,12 +557,11 @@ void RestHandler::apiUserAdd(const HttpRequest &message)
 {
 	const static char fname[] = "RestHandler::apiUserAdd() ";
 
-	const auto path = (curlpp::unescape(message.m_relative_uri));
 	permissionCheck(message, PERMISSION_KEY_add_user);
-	auto pathUserName = regexSearch(path, REST_PATH_SEC_USER_ADD);
+	auto pathUserName = message.pathParam("name");
 	const auto tokenUserName = getJwtUserName(message);
 
-	Security::instance()->addUser(pathUserName, message.extractJson());
+	Security::instance()->addUser(pathUserName, message.bodyJson());
 	Security::instance()->save(Configuration::instance()->getJwt()->getJwtInterface());
 	ConsulConnection::instance()->saveSecurity();
 
@@ -579,9 +581,8 @@ void RestHandler::apiUserDel(const HttpRequest &message)
 {
 	const static char fname[] = "RestHandler::apiUserDel() ";
 
-	const auto path = (curlpp::unescape(message.m_relative_uri));
 	permissionCheck(message, PERMISSION_KEY_delete_user);
-	auto pathUserName = regexSearch(path, REST_PATH_SEC_USER_DELETE);
+	auto pathUserName = message.pathParam("name");
 	const auto tokenUserName = getJwtUserName(message);
 
 	Security::instance()->delUser(pathUserName);
@@ -616,12 +617,11 @@ void RestHandler::apiRoleUpdate(const HttpRequest &message)
 {
 	const static char fname[] = "RestHandler::apiRoleUpdate() ";
 
-	const auto path = (curlpp::unescape(message.m_relative_uri));
 	permissionCheck(message, PERMISSION_KEY_role_update);
-	auto pathRoleName = regexSearch(path, REST_PATH_SEC_ROLE_UPDATE);
+	auto pathRoleName = message.pathParam("name");
 	const auto tokenUserName = getJwtUserName(message);
 
-	Security::instance()->addRole(message.extractJson(), pathRoleName);
+	Security::instance()->addRole(message.bodyJson(), pathRoleName);
 	Security::instance()->save(Configuration::instance()->getJwt()->getJwtInterface());
 	ConsulConnection::instance()->saveSecurity();
 
@@ -633,10 +633,9 @@ void RestHandler::apiRoleDelete(const HttpRequest &message)
 {
 	const static char fname[] = "RestHandler::apiRoleDelete() ";
 
-	const auto path = (curlpp::unescape(message.m_relative_uri));
 	permissionCheck(message, PERMISSION_KEY_role_delete);
 
-	auto pathRoleName = regexSearch(path, REST_PATH_SEC_ROLE_DELETE);
+	auto pathRoleName = message.pathParam("name");
 	const auto tokenUserName = getJwtUserName(message);
 
 	Security::instance()->delRole(pathRoleName);
@@ -673,8 +672,7 @@ void RestHandler::apiPermissionsView(const HttpRequest &message)
 
 void RestHandler::apiHealth(const HttpRequest &message)
 {
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto appName = regexSearch(path, REST_PATH_APP_HEALTH);
+	auto appName = message.pathParam("name");
 	auto health = Configuration::instance()->getApp(appName)->health();
 	auto body = std::to_string(health);
 	message.reply(web::http::status_codes::OK, body);
@@ -849,7 +847,7 @@ void RestHandler::apiUserTotpSecret(const HttpRequest &message)
 	const auto user = Security::instance()->getUserInfo(userName);
 	const auto mfaSecret = user->totpGenerateKey();
 	user->totpActive(false); // set to under setup status
-	// otpauth://totp/{label}?secret={secret}&issuer={issuer}
+	// otpauth://totp/{name}?secret={secret}&issuer={issuer}
 	const auto totpUri = Utility::stringFormat(
 		"otpauth://totp/%s?secret=%s&issuer=%s", userName.c_str(), mfaSecret.c_str(), "AppMesh");
 
@@ -916,8 +914,7 @@ void RestHandler::apiUserTotpDisable(const HttpRequest &message)
 	const static char fname[] = "RestHandler::apiUserTotpDisable() ";
 
 	permissionCheck(message, PERMISSION_KEY_user_totp_disable);
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	const auto pathUserName = regexSearch(path, REST_PATH_SEC_TOTP_DISABLE);
+	const auto pathUserName = message.pathParam("user");
 	const auto tokenUserName = getJwtUserName(message);
 	const auto &userName = (pathUserName == "self") ? tokenUserName : pathUserName;
 
@@ -946,8 +943,7 @@ void RestHandler::apiUserTotpDisable(const HttpRequest &message)
 void RestHandler::apiAppView(const HttpRequest &message)
 {
 	permissionCheck(message, PERMISSION_KEY_view_app);
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto appName = regexSearch(path, REST_PATH_APP_VIEW);
+	auto appName = message.pathParam("name");
 
 	checkAppAccessPermission(message, appName, false);
 
@@ -1060,8 +1056,7 @@ void RestHandler::apiRunSync(const HttpRequest &message)
 void RestHandler::apiAppOutputView(const HttpRequest &message)
 {
 	permissionCheck(message, PERMISSION_KEY_view_app_output);
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto appName = regexSearch(path, REST_PATH_APP_OUT_VIEW);
+	auto appName = message.pathParam("name");
 
 	checkAppAccessPermission(message, appName, false);
 
@@ -1073,7 +1068,179 @@ void RestHandler::apiAppsView(const HttpRequest &message)
 {
 	permissionCheck(message, PERMISSION_KEY_view_all_app);
 	const auto tokenUserName = getJwtUserName(message);
-	message.reply(web::http::status_codes::OK, Configuration::instance()->serializeApplication(true, tokenUserName, true));
+	auto apps = Configuration::instance()->getUserApps(tokenUserName, true);
+
+	// filter and paginate before any serialization
+	filterApps(message, apps);
+	std::string nextCursor;
+	if (message.m_querys.count(HTTP_QUERY_KEY_limit) || message.m_querys.count(HTTP_QUERY_KEY_cursor))
+	{
+		nextCursor = paginateApps(message, apps);
+	}
+	// projection, process resource usage is only collected when requested
+	const static std::set<std::string> usageFields = {JSON_KEY_APP_memory, JSON_KEY_APP_cpu, JSON_KEY_APP_open_fd, JSON_KEY_APP_pstree};
+	const auto fields = Utility::splitString(getHttpQueryString(message, HTTP_QUERY_KEY_fields), ",");
+	const bool returnUsage = fields.empty() || std::any_of(fields.begin(), fields.end(), [](const std::string &field)
+														   { return usageFields.count(field) > 0; });
+
+	// same applications with different projection, filter or page is a different representation
+	std::string variant;
+	for (const auto &key : {HTTP_QUERY_KEY_fields, HTTP_QUERY_KEY_status, HTTP_QUERY_KEY_owner, HTTP_QUERY_KEY_label, HTTP_QUERY_KEY_name_prefix, HTTP_QUERY_KEY_cursor, HTTP_QUERY_KEY_limit})
+	{
+		variant.append(getHttpQueryString(message, key)).push_back('\0');
+	}
+	const auto etag = Configuration::runtimeETag(apps, returnUsage, variant);
+	std::map<std::string, std::string> headers = {{web::http::header_names::etag, etag}};
+	if (nextCursor.length())
+	{
+		headers[HTTP_HEADER_KEY_next_cursor] = nextCursor;
+	}
+
+	// conditional GET, nothing changed since client's last view
+	const auto ifNoneMatch = message.m_headers.find(web::http::header_names::if_none_match);
+	if (ifNoneMatch != message.m_headers.end() && matchETag(ifNoneMatch->second, etag))
+	{
+		message.reply(web::http::status_codes::NotModified, std::string(), headers);
+		return;
+	}
+	if (fields.empty())
+	{
+		message.reply(web::http::status_codes::OK, Configuration::serializeApplication(apps, true), headers);
+		return;
+	}
+
+	auto result = nlohmann::json::array();
+	for (const auto &app : apps)
+	{
+		const auto appJson = returnUsage ? app->AsRuntimeJson() : std::make_shared<const nlohmann::json>(app->AsJson(true, nullptr, false));
+		auto projection = nlohmann::json::object();
+		for (const auto &field : fields)
+		{
+			const auto value = appJson->find(field);
+			if (value != appJson->end())
+				projection[field] = *value;
+		}
+		result.push_back(std::move(projection));
+	}
+	message.reply(web::http::status_codes::OK, result, headers);
+}
+
+bool RestHandler::matchETag(const std::string &ifNoneMatch, const std::string &etag)
+{
+	// comma separated entity tags, weak comparison ignores W/ prefix
+	for (auto tag : Utility::splitString(ifNoneMatch, ","))
+	{
+		if (tag == "*")
+			return true;
+		if (Utility::startWith(tag, "W/"))
+			tag = tag.substr(2);
+		if (tag == etag)
+			return true;
+	}
+	return false;
+}
+
+void RestHandler::filterApps(const HttpRequest &message, std::vector<std::shared_ptr<Application>> &apps)
+{
+	const auto status = getHttpQueryString(message, HTTP_QUERY_KEY_status);
+	const auto owner = getHttpQueryString(message, HTTP_QUERY_KEY_owner);
+	const auto label = getHttpQueryString(message, HTTP_QUERY_KEY_label);
+	const auto namePrefix = getHttpQueryString(message, HTTP_QUERY_KEY_name_prefix);
+	if (status.empty() && owner.empty() && label.empty() && namePrefix.empty())
+	{
+		return;
+	}
+
+	int statusValue = 0;
+	if (status.length())
+	{
+		if (status.length() > 9 || status.find_first_not_of("0123456789") != std::string::npos)
+		{
+			throw std::invalid_argument(Utility::stringFormat("invalid status <%s>", status.c_str()));
+		}
+		statusValue = std::stoi(status);
+	}
+	const auto labelPos = label.find('=');
+	const auto labelKey = label.substr(0, labelPos);
+	const auto labelValue = labelPos == std::string::npos ? std::string() : label.substr(labelPos + 1);
+	apps.erase(std::remove_if(apps.begin(), apps.end(), [&](const std::shared_ptr<Application> &app)
+							  {
+								  if (status.length() && static_cast<int>(app->getStatus()) != statusValue)
+									  return true;
+								  if (owner.length() && (app->getOwner() == nullptr || app->getOwner()->getName() != owner))
+									  return true;
+								  if (namePrefix.length() && !Utility::startWith(app->getName(), namePrefix))
+									  return true;
+								  if (label.length())
+								  {
+									  const auto &metadata = app->getMetadata();
+									  if (!metadata.is_object() || metadata.find(labelKey) == metadata.end())
+										  return true;
+									  if (labelPos != std::string::npos)
+									  {
+										  const auto &value = metadata.at(labelKey);
+										  return value.is_string() ? value.get<std::string>() != labelValue : value.dump() != labelValue;
+									  }
+								  }
+								  return false; }),
+			   apps.end());
+}
+
+std::string RestHandler::paginateApps(const HttpRequest &message, std::vector<std::shared_ptr<Application>> &apps)
+{
+	const auto cursor = getHttpQueryString(message, HTTP_QUERY_KEY_cursor);
+	const auto limit = static_cast<size_t>(getHttpQueryValue(message, HTTP_QUERY_KEY_limit, APP_LIST_DEFAULT_PAGE_SIZE, 1, APP_LIST_MAX_PAGE_SIZE));
+
+	// name order is stable when applications are added or removed between pages
+	std::sort(apps.begin(), apps.end(), [](const std::shared_ptr<Application> &a, const std::shared_ptr<Application> &b)
+			  { return a->getName() < b->getName(); });
+	const auto begin = cursor.empty() ? apps.begin() : std::upper_bound(apps.begin(), apps.end(), cursor, [](const std::string &name, const std::shared_ptr<Application> &app)
+																		  { return name < app->getName(); });
+	const auto end = static_cast<size_t>(apps.end() - begin) > limit ? begin + limit : apps.end();
+	const bool hasMore = end != apps.end();
+	std::vector<std::shared_ptr<Application>> page(begin, end);
+	apps.swap(page);
+	return (hasMore && !apps.empty()) ? apps.back()->getName() : std::string();
+}
+
+void RestHandler::apiAppsWatch(const HttpRequest &message)
+{
+	const static char fname[] = "RestHandler::apiAppsWatch() ";
+
+	permissionCheck(message, PERMISSION_KEY_view_all_app);
+	const auto tokenUserName = getJwtUserName(message);
+	const auto revisionStr = getHttpQueryString(message, HTTP_QUERY_KEY_revision);
+	uint64_t revision = 0;
+	bool validRevision = revisionStr.find_first_not_of("0123456789") == std::string::npos;
+	if (validRevision && revisionStr.length())
+	{
+		try
+		{
+			revision = std::stoull(revisionStr);
+		}
+		catch (const std::out_of_range &)
+		{
+			validRevision = false;
+		}
+	}
+	if (!validRevision)
+	{
+		message.reply(web::http::status_codes::BadRequest, convertText2Json(Utility::stringFormat("invalid revision <%s>", revisionStr.c_str())));
+		return;
+	}
+	const auto timeout = getHttpQueryValue(message, HTTP_QUERY_KEY_timeout, APP_WATCH_DEFAULT_TIMEOUT_SECONDS, 0, APP_WATCH_MAX_TIMEOUT_SECONDS);
+	LOG_DBG << fname << "revision: " << revision << " timeout: " << timeout;
+
+	if (revision > 0 && APP_CHANGE_JOURNAL::instance()->watcherCount() >= APP_WATCH_MAX_WATCHERS)
+	{
+		LOG_WAR << fname << "too many watchers, reject request <" << message.m_uuid << ">";
+		message.reply(web::http::status_codes::TooManyRequests, convertText2Json("too many application watchers"));
+		return;
+	}
+
+	// long poll is parked without worker thread, replied on change or timeout
+	auto watchRequest = std::make_shared<HttpRequestAppWatch>(message, tokenUserName, revision, timeout);
+	watchRequest->init();
 }
 
 void RestHandler::apiCloudAppsView(const HttpRequest &message)
@@ -1085,8 +1252,7 @@ void RestHandler::apiCloudAppsView(const HttpRequest &message)
 void RestHandler::apiCloudAppView(const HttpRequest &message)
 {
 	permissionCheck(message, PERMISSION_KEY_cloud_app_view);
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto appName = regexSearch(path, REST_PATH_CLOUD_APP_VIEW);
+	auto appName = message.pathParam("name");
 
 	message.reply(web::http::status_codes::OK, ConsulConnection::instance()->viewCloudApp(appName));
 }
@@ -1094,10 +1260,8 @@ void RestHandler::apiCloudAppView(const HttpRequest &message)
 void RestHandler::apiCloudAppOutputView(const HttpRequest &message)
 {
 	permissionCheck(message, PERMISSION_KEY_cloud_app_out_view);
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto tp = regexSearch2(path, REST_PATH_CLOUD_APP_OUT_VIEW);
-	const auto &appName = std::get<0>(tp);
-	const auto &hostName = std::get<1>(tp);
+	const auto &appName = message.pathParam("name");
+	const auto &hostName = message.pathParam("host");
 
 	auto querymap = message.m_querys;
 	auto resp = ConsulConnection::instance()->viewCloudAppOutput(appName, hostName, querymap, message.m_headers);
@@ -1108,8 +1272,7 @@ void RestHandler::apiCloudAppAdd(const HttpRequest &message)
 {
 	permissionCheck(message, PERMISSION_KEY_cloud_app_reg);
 
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto appName = regexSearch(path, REST_PATH_CLOUD_APP_ADD);
+	auto appName = message.pathParam("name");
 
 	auto jsonApp = message.extractJson();
 	if (jsonApp.is_null())
@@ -1123,8 +1286,7 @@ void RestHandler::apiCloudAppDel(const HttpRequest &message)
 {
 	permissionCheck(message, PERMISSION_KEY_cloud_app_delete);
 
-	const auto path = (curlpp::unescape(message.m_relative_uri));
-	auto appName = regexSearch(path, REST_PATH_CLOUD_APP_DELETE);
+	auto appName = message.pathParam("name");
 
 	ConsulConnection::instance()->deleteCloudApp(appName);
 	message.reply(web::http::status_codes::OK, convertText2Json("Delete cloud application success"));
@@ -19,11 +19,27 @@ public:
 
 	static long getHttpQueryValue(const HttpRequest &message, const std::string &key, long defaultValue, long min, long max);
 	static std::string getHttpQueryString(const HttpRequest &message, const std::string &key);
+	/// <summary>
+	/// Parse single HTTP byte range against file size
+	/// </summary>
+	/// <returns>false if range is invalid or not satisfiable</returns>
+	static bool parseByteRange(const std::string &range, int64_t fileSize, int64_t &offset, int64_t &length);
+	/// <summary>
+	/// Match If-None-Match header value (comma separated entity tags or *) with current entity tag
+	/// </summary>
+	static bool matchETag(const std::string &ifNoneMatch, const std::string &etag);
 
 protected:
 	void checkAppAccessPermission(const HttpRequest &message, const std::string &appName, bool requestWrite);
-	std::string regexSearch(const std::string &value, const char *regex);
-	std::tuple<std::string, std::string> regexSearch2(const std::string &value, const char *regex);
+	/// <summary>
+	/// Filter applications by query: status, owner, label (metadata "key" or "key=value") and name_prefix
+	/// </summary>
+	static void filterApps(const HttpRequest &message, std::vector<std::shared_ptr<Application>> &apps);
+	/// <summary>
+	/// Sort applications by name and keep one page after query cursor (name of the last application of previous page)
+	/// </summary>
+	/// <returns>cursor of next page, empty for the last page</returns>
+	static std::string paginateApps(const HttpRequest &message, std::vector<std::shared_ptr<Application>> &apps);
 
 	nlohmann::json createJwtResponse(const HttpRequest &message, const std::string &uname, int timeoutSeconds, const std::string &ugroup, const std::string *token = nullptr);
 	void apiUserLogin(const HttpRequest &message);
@@ -38,6 +54,7 @@ protected:
 	void apiAppView(const HttpRequest &message);
 	void apiAppOutputView(const HttpRequest &message);
 	void apiAppsView(const HttpRequest &message);
+	void apiAppsWatch(const HttpRequest &message);
 
 	std::shared_ptr<Application> parseAndRegRunApp(const HttpRequest &message);
 	void apiRunAsync(const HttpRequest &message);
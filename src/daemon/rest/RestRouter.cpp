@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "../../common/Utility.h"
+#include "RestRouter.h"
+
+RestRouter::RestRouter()
+{
+}
+
+RestRouter::~RestRouter()
+{
+}
+
+void RestRouter::add(const std::string &pattern, Handler handler)
+{
+	const static char fname[] = "RestRouter::add() ";
+
+	Node *node = &m_root;
+	size_t pos = 0;
+	while (pos < pattern.length())
+	{
+		const auto paramStart = pattern.find('{', pos);
+		if (paramStart == std::string::npos)
+		{
+			node = insertStatic(node, pattern.substr(pos));
+			break;
+		}
+		const auto paramEnd = pattern.find('}', paramStart);
+		// parameter must be a whole segment
+		if (paramEnd == std::string::npos || paramStart == 0 || pattern[paramStart - 1] != '/' ||
+			(paramEnd + 1 < pattern.length() && pattern[paramEnd + 1] != '/'))
+		{
+			throw std::invalid_argument(Utility::stringFormat("invalid route pattern <%s>", pattern.c_str()));
+		}
+		node = insertStatic(node, pattern.substr(pos, paramStart - pos));
+
+		auto name = pattern.substr(paramStart + 1, paramEnd - paramStart - 1);
+		auto type = ParamType::String;
+		const auto typePos = name.find(':');
+		if (typePos != std::string::npos)
+		{
+			const auto typeName = name.substr(typePos + 1);
+			name = name.substr(0, typePos);
+			if (typeName == "int")
+				type = ParamType::Int;
+			else if (typeName != "string")
+				throw std::invalid_argument(Utility::stringFormat("invalid parameter type <%s> in route pattern <%s>", typeName.c_str(), pattern.c_str()));
+		}
+		if (name.empty())
+		{
+			throw std::invalid_argument(Utility::stringFormat("empty parameter name in route pattern <%s>", pattern.c_str()));
+		}
+		node = insertParam(node, name, type, pattern);
+		pos = paramEnd + 1;
+	}
+
+	if (node->m_handler)
+	{
+		LOG_WAR << fname << "replace handler for route " << pattern;
+		*node->m_handler = std::move(handler);
+		return;
+	}
+	node->m_handler = std::make_unique<Handler>(std::move(handler));
+	m_patterns.push_back(pattern);
+}
+
+const RestRouter::Handler *RestRouter::match(const std::string &path, PathParams &params) const
+{
+	const auto node = find(&m_root, path.data(), path.length(), params);
+	return node ? node->m_handler.get() : nullptr;
+}
+
+const std::vector<std::string> &RestRouter::patterns() const
+{
+	return m_patterns;
+}
+
+RestRouter::Node *RestRouter::insertStatic(Node *node, const std::string &text)
+{
+	size_t pos = 0;
+	while (pos < text.length())
+	{
+		const auto index = node->m_indices.find(text[pos]);
+		if (index == std::string::npos)
+		{
+			auto child = std::make_unique<Node>();
+			child->m_prefix = text.substr(pos);
+			node->m_indices.push_back(text[pos]);
+			node->m_children.push_back(std::move(child));
+			return node->m_children.back().get();
+		}
+
+		auto &child = node->m_children[index];
+		const auto &prefix = child->m_prefix;
+		const auto common = std::mismatch(prefix.begin(), prefix.end(), text.begin() + pos, text.end()).first - prefix.begin();
+		if ((size_t)common < prefix.length())
+		{
+			// split edge: common part becomes a new node owning the rest of old edge
+			auto split = std::make_unique<Node>();
+			split->m_prefix = prefix.substr(0, common);
+			child->m_prefix.erase(0, common);
+			split->m_indices.push_back(child->m_prefix[0]);
+			split->m_children.push_back(std::move(child));
+			child = std::move(split);
+		}
+		node = child.get();
+		pos += common;
+	}
+	return node;
+}
+
+RestRouter::Node *RestRouter::insertParam(Node *node, const std::string &name, ParamType type, const std::string &pattern)
+{
+	if (node->m_param)
+	{
+		if (node->m_param->m_paramName != name || node->m_param->m_paramType != type)
+		{
+			throw std::invalid_argument(Utility::stringFormat("parameter <%s> of route pattern <%s> conflicts with existing parameter <%s>",
+															  name.c_str(), pattern.c_str(), node->m_param->m_paramName.c_str()));
+		}
+		return node->m_param.get();
+	}
+	node->m_param = std::make_unique<Node>();
+	node->m_param->m_paramName = name;
+	node->m_param->m_paramType = type;
+	return node->m_param.get();
+}
+
+const RestRouter::Node *RestRouter::find(const Node *node, const char *path, size_t size, PathParams &params) const
+{
+	if (size == 0)
+	{
+		return node->m_handler ? node : nullptr;
+	}
+
+	// static edge first
+	const auto index = node->m_indices.find(path[0]);
+	if (index != std::string::npos)
+	{
+		const auto child = node->m_children[index].get();
+		const auto &prefix = child->m_prefix;
+		if (size >= prefix.length() && std::memcmp(path, prefix.data(), prefix.length()) == 0)
+		{
+			if (const auto found = find(child, path + prefix.length(), size - prefix.length(), params))
+			{
+				return found;
+			}
+		}
+	}
+
+	// parameter consumes one segment, backtrack when rest of path does not match
+	if (node->m_param)
+	{
+		const auto slash = static_cast<const char *>(std::memchr(path, '/', size));
+		const size_t segment = slash ? slash - path : size;
+		if (matchParam(node->m_param->m_paramType, path, segment))
+		{
+			params.emplace_back(node->m_param->m_paramName, std::string(path, segment));
+			if (const auto found = find(node->m_param.get(), path + segment, size - segment, params))
+			{
+				return found;
+			}
+			params.pop_back();
+		}
+	}
+	return nullptr;
+}
+
+bool RestRouter::matchParam(ParamType type, const char *value, size_t size)
+{
+	if (size == 0)
+		return false;
+	if (type == ParamType::Int)
+		return std::all_of(value, value + size, [](char c)
+						   { return c >= '0' && c <= '9'; });
+	return std::memchr(value, '*', size) == nullptr;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class HttpRequest;
+
+/// <summary>
+/// Path parameters captured by RestRouter, in pattern order
+/// </summary>
+typedef std::vector<std::pair<std::string, std::string>> PathParams;
+
+/// <summary>
+/// REST route table compiled to a radix tree once at bind time.
+/// Route pattern is a path with typed parameter segments:
+///   /appmesh/app/{name}/output : {name} matches one non-empty segment without '*'
+///   /appmesh/item/{id:int}     : {id:int} matches one segment of digits
+/// Static edges have precedence over parameters, so "/appmesh/user/self" wins over "/appmesh/user/{name}".
+/// Lookup walks the path bytes once, no regex and no allocation for routes without parameter.
+/// </summary>
+class RestRouter
+{
+public:
+	typedef std::function<void(const HttpRequest &)> Handler;
+
+	RestRouter();
+	virtual ~RestRouter();
+
+	/// <summary>
+	/// Compile and add a route, handler of an existing pattern is replaced
+	/// </summary>
+	/// <exception cref="std::invalid_argument">invalid pattern or parameter conflicts with existing route</exception>
+	void add(const std::string &pattern, Handler handler);
+	/// <summary>
+	/// Find handler for request path
+	/// </summary>
+	/// <param name="path">request path without query</param>
+	/// <param name="params">captured path parameters are appended</param>
+	/// <returns>nullptr when no route matches</returns>
+	const Handler *match(const std::string &path, PathParams &params) const;
+	/// <summary>
+	/// All added route patterns
+	/// </summary>
+	const std::vector<std::string> &patterns() const;
+
+private:
+	enum class ParamType : int
+	{
+		String = 0,
+		Int
+	};
+	struct Node
+	{
+		// static edge label from parent
+		std::string m_prefix;
+		// static children, m_indices holds first char of each child for fast scan
+		std::string m_indices;
+		std::vector<std::unique_ptr<Node>> m_children;
+		// parameter child, matches one path segment
+		std::unique_ptr<Node> m_param;
+		std::string m_paramName;
+		ParamType m_paramType = ParamType::String;
+		std::unique_ptr<Handler> m_handler;
+	};
+	Node *insertStatic(Node *node, const std::string &text);
+	Node *insertParam(Node *node, const std::string &name, ParamType type, const std::string &pattern);
+	const Node *find(const Node *node, const char *path, size_t size, PathParams &params) const;
+	static bool matchParam(ParamType type, const char *value, size_t size);
+
+private:
+	Node m_root;
+	std::vector<std::string> m_patterns;
+};
@@ -1,11 +1,18 @@
+#include <algorithm>
 #include <cerrno>
-#include <fstream>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <thread>
 
+#include <ace/OS_NS_fcntl.h>
+#include <ace/OS_NS_sys_stat.h>
+#include <ace/TP_Reactor.h>
 #include <ace/os_include/netinet/os_tcp.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
 
+#include "../../common/BufferPool.h"
 #include "../../common/TimerHandler.h"
 #include "../../common/Utility.h"
 #include "../Configuration.h"
@@ -14,164 +21,365 @@
 #include "TcpServer.h"
 #include "protoc/ProtobufHelper.h"
 
-ACE_Map_Manager<int, TcpHandler *, ACE_Recursive_Thread_Mutex> TcpHandler::m_handlers;
-MessageQueue TcpHandler::m_messageQueue;
+ShardedMap<int, TcpHandler *> TcpHandler::m_handlers;
+// lane capacity: health, read, mutation, long running
+RequestQueue TcpHandler::m_requestQueue(std::array<size_t, REQUEST_LANE_NUM>{{64, 1024, 256, 64}});
 std::atomic_int TcpHandler::m_idGenerator = ATOMIC_FLAG_INIT;
+std::vector<std::unique_ptr<ACE_Reactor>> TcpHandler::m_reactors;
+std::atomic_size_t TcpHandler::m_reactorIndex(0);
+std::atomic<uint64_t> TcpHandler::m_tlsHandshakes(0);
+std::atomic<uint64_t> TcpHandler::m_tlsResumed(0);
+std::atomic<uint64_t> TcpHandler::m_tlsKernelOffload(0);
 
-struct HttpRequestMsg
+namespace
 {
-	explicit HttpRequestMsg(const std::shared_ptr<char> &data, size_t len, int client)
-		: m_data(data), m_dataSize(len), m_tcpHanlerId(client)
+	// single write on non-blocking socket, return -1 with EWOULDBLOCK when socket buffer is full
+	ssize_t sendSome(const ACE_SSL_SOCK_Stream &socket, const char *data, size_t size)
 	{
+		return socket.send(data, size);
 	}
-	const std::shared_ptr<char> m_data;
-	const size_t m_dataSize;
-	const int m_tcpHanlerId;
-};
+	ssize_t sendSome(const ACE_LSOCK_Stream &socket, const char *data, size_t size)
+	{
+		return socket.send(data, size, 0);
+	}
+	// single read on non-blocking socket, return -1 with EWOULDBLOCK when no data available
+	ssize_t recvSome(const ACE_SSL_SOCK_Stream &socket, char *data, size_t size)
+	{
+		return socket.recv(data, size);
+	}
+	ssize_t recvSome(const ACE_LSOCK_Stream &socket, char *data, size_t size)
+	{
+		return socket.recv(data, size, 0);
+	}
+}
 
-// Default constructor.
+////////////////////////////////////////////////////////////////////////////////
+// TcpHandler: registry and dispatch shared by all transports
+////////////////////////////////////////////////////////////////////////////////
 TcpHandler::TcpHandler(void)
-	: m_id(++m_idGenerator)
+	: m_id(++m_idGenerator), m_compression(false), m_wireSchema(WireSchema::Map), m_streaming(false)
 {
-	const static char fname[] = "TcpHandler::TcpHandler() ";
-	m_handlers.bind(m_id, this);
-	LOG_DBG << fname << "client=" << m_id << ", total client number: " << m_handlers.current_size();
 }
 
 TcpHandler::~TcpHandler()
 {
-	const static char fname[] = "TcpHandler::~TcpHandler() ";
+}
+
+void TcpHandler::dispatch(const char *data, int dataSize)
+{
+	const static char fname[] = "TcpHandler::dispatch() ";
+
+	// decode in reactor thread, request lane depends on method and path
+	auto request = HttpRequest::deserialize(data, dataSize, m_id);
+	if (request == nullptr)
+	{
+		LOG_ERR << fname << "failed to decode message from client=" << m_id;
+		return;
+	}
+	if (!m_compression && request->m_headers.count(HTTP_HEADER_KEY_frame_compression) &&
+		request->m_headers.find(HTTP_HEADER_KEY_frame_compression)->second == HTTP_HEADER_VALUE_frame_compression_zstd)
+	{
+		LOG_INF << fname << "enable response compression for client=" << m_id;
+		m_compression = true;
+	}
+	if (m_wireSchema == WireSchema::Map && request->m_headers.count(HTTP_HEADER_KEY_wire_schema) &&
+		std::atoi(request->m_headers.find(HTTP_HEADER_KEY_wire_schema)->second.c_str()) == static_cast<int>(WireSchema::V1))
+	{
+		// peer switch request to V1 after it receive the first V1 response
+		LOG_INF << fname << "enable positional wire schema for client=" << m_id;
+		m_wireSchema = WireSchema::V1;
+	}
+	if (!m_streaming && request->m_headers.count(HTTP_HEADER_KEY_response_stream) &&
+		request->m_headers.find(HTTP_HEADER_KEY_response_stream)->second == "1")
+	{
+		LOG_INF << fname << "enable streamed response for client=" << m_id;
+		m_streaming = true;
+	}
+	if (!m_requestQueue.enqueue(request))
+	{
+		// load shedding: reply immediately when lane is full
+		LOG_WAR << fname << "request queue lane <" << RequestQueue::laneName(RequestQueue::classify(*request)) << "> is full, reject request: " << request->m_uuid;
+		nlohmann::json body;
+		body[REST_TEXT_MESSAGE_JSON_KEY] = std::string("server is busy, please retry later");
+		request->reply(web::http::status_codes::ServiceUnavailable, body, {{web::http::header_names::retry_after, std::to_string(REST_QUEUE_RETRY_AFTER_SECONDS)}});
+	}
+}
+
+ACE_Reactor *TcpHandler::nextReactor()
+{
+	// accept sharding: acceptor reactor only accept connections, each connection
+	// is owned by one of the sharded reactors, so TLS decrypt and framing run in parallel
+	if (m_reactors.empty())
+		return nullptr;
+	return m_reactors[m_reactorIndex++ % m_reactors.size()].get();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// TcpConnection: per connection reactor handler
+////////////////////////////////////////////////////////////////////////////////
+template <typename STREAM>
+TcpConnection<STREAM>::TcpConnection(void)
+	: m_registered(false), m_sendQueueBytes(0), m_sendScheduled(false), m_closed(false), m_writeWait(false), m_readSuspended(false)
+{
+	const static char fname[] = "TcpConnection::TcpConnection() ";
+	// initial reference is owned by the creator (ACE_Acceptor) and handed over to reactor in open()
+	this->reference_counting_policy().value(ACE_Event_Handler::Reference_Counting_Policy::ENABLED);
+	m_handlers.insert(m_id, this);
+	LOG_DBG << fname << "client=" << m_id << ", total client number: " << m_handlers.size();
+}
+
+template <typename STREAM>
+TcpConnection<STREAM>::~TcpConnection()
+{
+	const static char fname[] = "TcpConnection::~TcpConnection() ";
 	LOG_DBG << fname << "client=" << m_id;
-	m_handlers.unbind(m_id);
-	ACE_Reactor::instance()->remove_handler(this, READ_MASK);
+	m_handlers.erase(m_id);
+}
+
+template <typename STREAM>
+ACE_Event_Handler *TcpConnection<STREAM>::eventHandler()
+{
+	return this;
+}
+
+// handle_close() is triggered by reactor before it release reference,
+// or by ACE_Acceptor when open() failed
+template <typename STREAM>
+int TcpConnection<STREAM>::handle_close(ACE_HANDLE, ACE_Reactor_Mask)
+{
+	const static char fname[] = "TcpConnection::handle_close() ";
+	LOG_DBG << fname << "client=" << m_id;
+
+	// no new reference can be acquired by replyTcp() after unregister
+	m_handlers.erase(m_id);
+	{
+		// reject new reply and drop pending messages
+		std::lock_guard<std::mutex> guard(m_sendQueueLock);
+		m_closed = true;
+		m_sendQueue.clear();
+		m_sendQueueBytes = 0;
+	}
+	m_sendQueueCond.notify_all();
+	m_output = PendingOutput();
+	m_downloadFile.reset();
+	m_uploadFile.reset();
+	// handle_input() failure only removes READ_MASK, a pending WRITE_MASK must be removed before fd is closed
+	// and reused, reactor releases its reference then, so keep self alive until return
+	ACE_Event_Handler_var self;
+	if (m_registered && this->reactor())
+	{
+		this->add_reference();
+		self = this;
+		this->reactor()->remove_handler(this, ACE_Event_Handler::ALL_EVENTS_MASK | ACE_Event_Handler::DONT_CALL);
+	}
+	this->peer().close();
+	if (!m_registered)
+	{
+		// release creator reference, this will delete self
+		this->remove_reference();
+	}
+	return 0;
 }
 
 // Perform the tcp record receive.
 // handle_input() will be triggered before handle_close()
-int TcpHandler::handle_input(ACE_HANDLE)
+template <typename STREAM>
+int TcpConnection<STREAM>::handle_input(ACE_HANDLE)
 {
-	const static char fname[] = "TcpHandler::handle_input() ";
+	const static char fname[] = "TcpConnection::handle_input() ";
 	LOG_DBG << fname << "from client=" << m_id;
 
-	std::lock_guard<std::mutex> guard(m_socketLock); // hold this lock to avoid recv TCP file stream data
-	auto result = ProtobufHelper::readMessageBlock(this->peer());
-	auto data = std::get<0>(result);
-	auto readCount = std::get<1>(result);
-
-	// https://github.com/DOCGroup/ACE_TAO/blob/master/ACE/examples/Reactor/WFMO_Reactor/Network_Events.cpp#L66
-	if (readCount > 0)
+	if (m_readSuspended)
 	{
-		assert(data != nullptr);
-		m_messageQueue.enqueue(new ACE_Message_Block((const char *)(new HttpRequestMsg(data, readCount, m_id))));
-		return 0;
+		// notified by upload writer after its backlog drained
+		m_readSuspended = false;
+		if (this->reactor()->schedule_wakeup(this, ACE_Event_Handler::READ_MASK) == -1)
+		{
+			LOG_ERR << fname << "resume read failed with error: " << std::strerror(errno);
+			return -1;
+		}
+		// TLS records already decrypted into SSL buffer do not raise read readiness again, continue to read them
 	}
-	else if (readCount == 0)
+	return this->recvFrames();
+}
+
+template <typename STREAM>
+int TcpConnection<STREAM>::open(void *)
+{
+	const static char fname[] = "TcpConnection::open() ";
+	LOG_DBG << fname << "from client=" << m_id;
+
+	if (!this->initPeer())
 	{
-		LOG_ERR << fname << "Connection from " << m_clientHostName << " closing down";
 		return -1;
 	}
-	else if (errno == EWOULDBLOCK)
+	// reactor thread never block on a slow peer, partial write is resumed on write readiness
+	if (this->peer().enable(ACE_NONBLOCK) == -1)
 	{
-		LOG_ERR << fname << "socket buffer full: " << std::strerror(errno);
-		// return 0; // here does not support continue recieve to existing buffer
-		return -1;
+		LOG_ERR << fname << "Can't enable nonblocking with error: " << std::strerror(errno);
 	}
-	else
+	if (auto reactor = nextReactor())
 	{
-		LOG_ERR << fname << "Problems in receiving data from " << m_clientHostName << ": " << std::strerror(errno);
+		this->reactor(reactor);
+	}
+	if (this->reactor()->register_handler(this, ACE_Event_Handler::READ_MASK) == -1)
+	{
+		LOG_ERR << fname << "can't register with reactor";
 		return -1;
 	}
+	// reactor hold its own reference now, release creator reference
+	m_registered = true;
+	this->remove_reference();
+
+	LOG_INF << fname << "client <" << m_clientHostName << "> connected";
+	return 0;
 }
 
-int TcpHandler::open(void *)
+template <>
+bool TcpConnection<ACE_SSL_SOCK_Stream>::initPeer()
 {
-	const static char fname[] = "TcpHandler::open() ";
-	LOG_DBG << fname << "from client=" << m_id;
+	const static char fname[] = "TcpConnection::initPeer() ";
 
 	ACE_INET_Addr addr;
 	if (this->peer().get_remote_addr(addr) == -1)
 	{
-		return -1;
+		return false;
 	}
-	else
+	this->m_clientHostName = std::string(addr.get_host_name()) + ":" + std::to_string(addr.get_port_number());
+
+	// handshake already finished by ACE_SSL_SOCK_Acceptor
+	SSL *ssl = this->peer().ssl();
+	++m_tlsHandshakes;
+	if (SSL_session_reused(ssl))
+	{
+		++m_tlsResumed;
+	}
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+	if (BIO_get_ktls_send(SSL_get_wbio(ssl)))
+	{
+		++m_tlsKernelOffload;
+	}
+#endif
+	LOG_DBG << fname << "client <" << m_clientHostName << "> " << SSL_get_version(ssl) << " session reused: " << SSL_session_reused(ssl);
+
+	// Disable Nagle's algorithm on both sides if you're sending small, frequent messages.
+	int flag = 1;
+	if (this->peer().set_option(ACE_IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)) == -1)
+	{
+		LOG_ERR << fname << "Can't disable Nagle's algorithm with error: " << std::strerror(errno);
+	}
+	return true;
+}
+
+template <>
+bool TcpConnection<ACE_LSOCK_Stream>::initPeer()
+{
+	const static char fname[] = "TcpConnection::initPeer() ";
+
+	// socket file permission already restrict who can connect, double check peer
+	// credential so only root and the daemon user are accepted
+	struct ucred cred;
+	int credLen = sizeof(cred);
+	if (this->peer().get_option(SOL_SOCKET, SO_PEERCRED, &cred, &credLen) == -1)
 	{
-		this->m_clientHostName = addr.get_host_name();
-		// TODO: one TCP connection can not leverage parallel ACE_TP_Reactor thread pool
-		if (ACE_Reactor::instance()->register_handler(this, READ_MASK) == -1)
+		LOG_ERR << fname << "Can't get peer credential with error: " << std::strerror(errno);
+		return false;
+	}
+	if (cred.uid != 0 && cred.uid != ACE_OS::geteuid())
+	{
+		LOG_WAR << fname << "reject local client pid <" << cred.pid << "> uid <" << cred.uid << ">";
+		return false;
+	}
+	this->m_clientHostName = std::string("unix:pid=") + std::to_string(cred.pid);
+	return true;
+}
+
+void TcpHandler::handleTcpRest(size_t workerIndex)
+{
+	const static char fname[] = "TcpHandler::handleTcpRest() ";
+
+	while (QUIT_HANDLER::instance()->is_set() == 0)
+	{
+		auto request = m_requestQueue.dequeue(workerIndex);
+		if (request == nullptr)
+			break; // queue closed
+
+		const HttpRequest &message = *request;
+		LOG_DBG << fname << message.m_method << " from <"
+				<< message.m_remote_address << "> path <"
+				<< message.m_relative_uri << "> id <"
+				<< message.m_uuid << ">";
+
+		// caller already gave up, skip stale work waited too long in queue
+		if (message.expired())
 		{
-			LOG_ERR << fname << "can't register with reactor";
-			return -1;
+			LOG_WAR << fname << "Drop expired request <" << message.m_uuid << "> path <" << message.m_relative_uri << ">";
+			m_requestQueue.expired(RequestQueue::classify(message));
+			message.reply(web::http::status_codes::GatewayTimeout);
+			continue;
 		}
+
+		if (message.m_method == web::http::methods::GET)
+			RESTHANDLER::instance()->handle_get(message);
+		else if (message.m_method == web::http::methods::PUT)
+			RESTHANDLER::instance()->handle_put(message);
+		else if (message.m_method == web::http::methods::DEL)
+			RESTHANDLER::instance()->handle_delete(message);
+		else if (message.m_method == web::http::methods::POST)
+			RESTHANDLER::instance()->handle_post(message);
+		else if (message.m_method == web::http::methods::OPTIONS)
+			RESTHANDLER::instance()->handle_options(message);
+		else if (message.m_method == web::http::methods::HEAD)
+			RESTHANDLER::instance()->handle_head(message);
 		else
 		{
-			// Disable Nagle's algorithm on both sides if you're sending small, frequent messages.
-			int flag = 1;
-			if (this->peer().set_option(ACE_IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)) == -1)
-			{
-				LOG_ERR << fname << "Can't disable Nagle's algorithm with error: " << std::strerror(errno);
-			}
-			if (this->peer().disable(ACE_NONBLOCK) == -1)
-			{
-				LOG_ERR << fname << "Can't disable nonblocking with error: " << std::strerror(errno);
-			}
-			LOG_INF << fname << "client <" << m_clientHostName << ":" << addr.get_port_number() << "> connected";
+			LOG_ERR << fname << "no such method " << message.m_method
+					<< " from " << message.m_remote_address
+					<< " with path " << message.m_relative_uri;
 		}
-		return 0;
+		// TODO: check request without reply
 	}
+	LOG_WAR << fname << "Exit";
 }
 
-void TcpHandler::handleTcpRest()
+void TcpHandler::initMsgQueue(size_t workerNum)
 {
-	const static char fname[] = "TcpHandler::handleTcpRest() ";
+	m_requestQueue.init(workerNum);
+}
+
+void TcpHandler::closeMsgQueue()
+{
+	m_requestQueue.close();
+}
 
-	ACE_Message_Block *msg = nullptr;
-	while (0 == m_messageQueue.deactivated() && QUIT_HANDLER::instance()->is_set() == 0)
+const RequestQueue &TcpHandler::requestQueue()
+{
+	return m_requestQueue;
+}
+
+const std::vector<std::unique_ptr<ACE_Reactor>> &TcpHandler::initReactors(size_t reactorNum)
+{
+	const static char fname[] = "TcpHandler::initReactors() ";
+
+	for (size_t i = 0; i < reactorNum; i++)
 	{
-		if (m_messageQueue.dequeue(msg) >= -1 && msg)
+		auto reactor = std::make_unique<ACE_Reactor>(new ACE_TP_Reactor(), true);
+		if (reactor->open(ACE::max_handles()) == -1 || !reactor->initialized())
 		{
-			std::unique_ptr<HttpRequestMsg> entity(static_cast<HttpRequestMsg *>((void *)msg->rd_ptr()));
-			auto request = HttpRequest::deserialize(entity->m_data.get(), entity->m_dataSize, entity->m_tcpHanlerId);
-			msg->release();
-			msg = nullptr;
-			if (request != nullptr)
-			{
-				const HttpRequest &message = *request;
-				LOG_DBG << fname << message.m_method << " from <"
-						<< message.m_remote_address << "> path <"
-						<< message.m_relative_uri << "> id <"
-						<< message.m_uuid << "> TcpHandler <"
-						<< entity->m_tcpHanlerId << ">";
-
-				if (message.m_method == web::http::methods::GET)
-					RESTHANDLER::instance()->handle_get(message);
-				else if (message.m_method == web::http::methods::PUT)
-					RESTHANDLER::instance()->handle_put(message);
-				else if (message.m_method == web::http::methods::DEL)
-					RESTHANDLER::instance()->handle_delete(message);
-				else if (message.m_method == web::http::methods::POST)
-					RESTHANDLER::instance()->handle_post(message);
-				else if (message.m_method == web::http::methods::OPTIONS)
-					RESTHANDLER::instance()->handle_options(message);
-				else if (message.m_method == web::http::methods::HEAD)
-					RESTHANDLER::instance()->handle_head(message);
-				else
-				{
-					LOG_ERR << fname << "no such method " << message.m_method
-							<< " from " << message.m_remote_address
-							<< " with path " << message.m_relative_uri;
-				}
-				// TODO: check request without reply
-			}
-			// TODO: check request without reply
+			throw std::runtime_error(std::string("Init TCP reactor failed with error: ") + std::strerror(errno));
 		}
+		m_reactors.push_back(std::move(reactor));
 	}
-	LOG_WAR << fname << "Exit";
+	LOG_INF << fname << "created <" << m_reactors.size() << "> reactors for TCP connections";
+	return m_reactors;
 }
 
-void TcpHandler::closeMsgQueue()
+void TcpHandler::closeReactors()
 {
-	// TODO: release memory before clear
-	m_messageQueue.close();
+	for (const auto &reactor : m_reactors)
+	{
+		reactor->end_reactor_event_loop();
+	}
 }
 
 const int &TcpHandler::id()
@@ -179,88 +387,579 @@ const int &TcpHandler::id()
 	return m_id;
 }
 
-bool TcpHandler::reply(const Response &resp)
+template <typename STREAM>
+bool TcpConnection<STREAM>::reply(const Response &resp)
 {
-	const static char fname[] = "TcpHandler::reply() ";
+	const static char fname[] = "TcpConnection::reply() ";
 
-	const auto data = resp.serialize();
-	const auto buffer = data->data();
-	const auto length = data->size();
+	SendMessage msg;
+	msg.m_frame = resp.serializeFrame(m_compression, m_wireSchema);
+	LOG_DBG << fname << "enqueue response length: " << msg.m_frame->size();
 
-	LOG_DBG << fname << "send response length: " << length;
-	std::lock_guard<std::mutex> guard(m_socketLock);
-	if (this->peer().get_handle() != ACE_INVALID_HANDLE)
+	if ((resp.http_status == web::http::status_codes::OK || resp.http_status == web::http::status_codes::PartialContent) &&
+		resp.body_msg_type == web::http::mime_types::application_octetstream &&
+		resp.body.size() &&
+		(resp.request_uri == "/appmesh/file/download" || resp.request_uri == "/appmesh/file/upload"))
 	{
-		if (length == 0)
+		auto body = nlohmann::json::parse(resp.body);
+		if (body.contains(TCP_JSON_MSG_FILE))
 		{
-			this->peer().close();
-			return false;
+			auto path = body[TCP_JSON_MSG_FILE].get<std::string>();
+			if (resp.request_uri == "/appmesh/file/download")
+			{
+				msg.m_downloadFile = path;
+				if (body.contains(TCP_JSON_MSG_FILE_OFFSET))
+					msg.m_downloadOffset = body[TCP_JSON_MSG_FILE_OFFSET].get<uint64_t>();
+				if (body.contains(TCP_JSON_MSG_FILE_LENGTH))
+					msg.m_downloadLength = body[TCP_JSON_MSG_FILE_LENGTH].get<uint64_t>();
+			}
+			else
+				msg.m_uploadFile = path;
 		}
-		if (!sendBytes(length) || !sendBytes(buffer, length))
+	}
+	return enqueueSend(std::move(msg));
+}
+
+template <typename STREAM>
+bool TcpConnection<STREAM>::waitSendQueueBelow(size_t highWater, std::chrono::milliseconds timeout)
+{
+	std::unique_lock<std::mutex> lock(m_sendQueueLock);
+	m_sendQueueCond.wait_for(lock, timeout, [this, highWater]()
+							 { return m_closed || m_sendQueueBytes < highWater; });
+	return !m_closed && m_sendQueueBytes < highWater;
+}
+
+template <typename STREAM>
+bool TcpConnection<STREAM>::enqueueSend(SendMessage &&msg)
+{
+	const static char fname[] = "TcpConnection::enqueueSend() ";
+
+	bool notify = false;
+	{
+		std::lock_guard<std::mutex> guard(m_sendQueueLock);
+		if (m_closed)
 		{
-			LOG_ERR << fname << "send response failed with error: " << std::strerror(errno);
+			LOG_WAR << fname << "Socket not available, ignore message for client=" << m_id;
 			return false;
 		}
+		m_sendQueueBytes += msg.m_frame->size();
+		m_sendQueue.push_back(std::move(msg));
+		// only one pending notification for one connection
+		notify = !m_sendScheduled;
+		m_sendScheduled = true;
+	}
+	if (notify && this->reactor()->notify(this, ACE_Event_Handler::WRITE_MASK) == -1)
+	{
+		LOG_ERR << fname << "notify reactor failed with error: " << std::strerror(errno);
+		std::lock_guard<std::mutex> guard(m_sendQueueLock);
+		m_sendScheduled = false;
+		return false;
+	}
+	return true;
+}
+
+// Drain send queue in reactor thread.
+// Messages are coalesced and written without blocking, the unwritten tail is kept in
+// m_output and resumed when socket is writable. File download is sent one chunk
+// per notification so that other connections of the same reactor are not starved.
+template <typename STREAM>
+int TcpConnection<STREAM>::handle_output(ACE_HANDLE)
+{
+	const static char fname[] = "TcpConnection::handle_output() ";
+
+	if (this->peer().get_handle() == ACE_INVALID_HANDLE)
+	{
+		LOG_WAR << fname << "Socket not available for client=" << m_id;
+		return 0;
+	}
+
+	bool success = true;
+	auto result = SendResult::Done;
+	if (!m_output.m_data)
+	{
+		if (!m_downloadFile)
+			takeBatch();
+		else if (m_downloadFile->m_chunkPending == 0)
+			success = readFileChunk();
+	}
+	if (success && m_output.m_data)
+	{
+		result = flushOutput();
+		if (result == SendResult::Done)
+		{
+			const auto follow = std::move(m_output.m_follow);
+			m_output = PendingOutput();
+			startFileStream(follow);
+		}
+	}
+	// zero copy chunk data follow its header
+	if (success && result == SendResult::Done && !m_output.m_data && m_downloadFile && m_downloadFile->m_chunkPending > 0)
+	{
+		result = sendFileChunk();
+	}
+	success = success && (result != SendResult::Failed);
+	const bool blocked = (result == SendResult::WouldBlock);
+
+	if (!success)
+	{
+		LOG_ERR << fname << "send response failed with error: " << std::strerror(errno);
+		// reactor will call handle_close() and release reference
+		this->reactor()->remove_handler(this, ACE_Event_Handler::ALL_EVENTS_MASK);
+		return 0;
+	}
+
+	if (blocked)
+	{
+		// socket buffer full: wait for write readiness, m_sendScheduled stay set so enqueueSend() does not notify
+		if (!m_writeWait && this->reactor()->schedule_wakeup(this, ACE_Event_Handler::WRITE_MASK) == -1)
+		{
+			LOG_ERR << fname << "schedule write wakeup failed with error: " << std::strerror(errno);
+			this->reactor()->remove_handler(this, ACE_Event_Handler::ALL_EVENTS_MASK);
+			return 0;
+		}
+		m_writeWait = true;
+		return 0;
+	}
+	if (m_writeWait)
+	{
+		this->reactor()->cancel_wakeup(this, ACE_Event_Handler::WRITE_MASK);
+		m_writeWait = false;
+	}
+
+	bool notify = false;
+	{
+		std::lock_guard<std::mutex> guard(m_sendQueueLock);
+		notify = (m_output.m_data || m_downloadFile || !m_sendQueue.empty()) && !m_closed;
+		m_sendScheduled = notify;
+	}
+	if (notify && this->reactor()->notify(this, ACE_Event_Handler::WRITE_MASK) == -1)
+	{
+		LOG_ERR << fname << "notify reactor failed with error: " << std::strerror(errno);
+		std::lock_guard<std::mutex> guard(m_sendQueueLock);
+		m_sendScheduled = false;
+	}
+	return 0;
+}
+
+template <typename STREAM>
+bool TcpConnection<STREAM>::takeBatch()
+{
+	const static char fname[] = "TcpConnection::takeBatch() ";
 
-		if (resp.http_status == web::http::status_codes::OK &&
-			resp.body_msg_type == web::http::mime_types::application_octetstream &&
-			resp.request_uri == "/appmesh/file/download" && resp.body.size() &&
-			nlohmann::json::parse(resp.body).contains(TCP_JSON_MSG_FILE))
+	std::vector<SendMessage> batch;
+	size_t batchSize = 0;
+	{
+		std::lock_guard<std::mutex> guard(m_sendQueueLock);
+		while (!m_sendQueue.empty() && batchSize < TCP_SEND_BATCH_SIZE)
 		{
-			auto path = nlohmann::json::parse(resp.body)[TCP_JSON_MSG_FILE].get<std::string>();
-			// send file via TCP with chunks
-			auto pBuffer = make_shared_array<char>(BLOCK_CHUNK_SIZE);
-			std::ifstream file(path, std::ios::binary | std::ios::in);
-			if (file)
+			batchSize += m_sendQueue.front().m_frame->size();
+			batch.push_back(std::move(m_sendQueue.front()));
+			m_sendQueue.pop_front();
+			// file stream must follow its response frame immediately
+			if (!batch.back().m_downloadFile.empty() || !batch.back().m_uploadFile.empty())
+				break;
+		}
+		m_sendQueueBytes -= batchSize;
+	}
+	if (batch.empty())
+	{
+		return false;
+	}
+	m_sendQueueCond.notify_all();
+	if (batch.size() == 1)
+	{
+		// share frame buffer without copy
+		const auto frame = batch.front().m_frame;
+		m_output.m_data = std::shared_ptr<const char>(frame, frame->data());
+	}
+	else
+	{
+		auto buffer = std::make_shared<std::string>();
+		buffer->reserve(batchSize);
+		for (const auto &msg : batch)
+			buffer->append(msg.m_frame->data(), msg.m_frame->size());
+		m_output.m_data = std::shared_ptr<const char>(buffer, buffer->data());
+	}
+	m_output.m_size = batchSize;
+	m_output.m_offset = 0;
+	m_output.m_follow = std::move(batch.back());
+	m_output.m_follow.m_frame.reset();
+	LOG_DBG << fname << "take <" << batch.size() << "> messages with length: " << batchSize;
+	return true;
+}
+
+template <typename STREAM>
+typename TcpConnection<STREAM>::SendResult TcpConnection<STREAM>::flushOutput()
+{
+	const static char fname[] = "TcpConnection::flushOutput() ";
+
+	while (m_output.m_offset < m_output.m_size)
+	{
+		errno = 0;
+		const auto sent = sendSome(this->peer(), m_output.m_data.get() + m_output.m_offset, m_output.m_size - m_output.m_offset);
+		if (sent > 0)
+		{
+			m_output.m_offset += sent;
+		}
+		else if (sent < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		else if (sent < 0 && (errno == EWOULDBLOCK || errno == EAGAIN))
+		{
+			LOG_DBG << fname << m_clientHostName << " socket buffer full, sent <" << m_output.m_offset << "/" << m_output.m_size << ">";
+			return SendResult::WouldBlock;
+		}
+		else
+		{
+			LOG_ERR << fname << m_clientHostName << " send failed with error: " << std::strerror(errno);
+			return SendResult::Failed;
+		}
+	}
+	return SendResult::Done;
+}
+
+template <typename STREAM>
+void TcpConnection<STREAM>::startFileStream(const SendMessage &msg)
+{
+	if (!msg.m_downloadFile.empty())
+	{
+		openDownloadFile(msg);
+	}
+	else if (!msg.m_uploadFile.empty())
+	{
+		// writer thread resume socket read in reactor thread, notify hold a reference of this handler
+		m_uploadFile = std::make_unique<UploadWriter>(msg.m_uploadFile, UploadWriter::parseSyncPolicy(Configuration::instance()->getTcpUploadSync()),
+													  [this]()
+													  { this->reactor()->notify(this, ACE_Event_Handler::READ_MASK); });
+		m_uploadFile->open();
+	}
+}
+
+template <typename STREAM>
+void TcpConnection<STREAM>::outputHeader(uint32_t value)
+{
+	auto buffer = BufferPool::instance().allocate(PROTOBUF_HEADER_LENGTH);
+	*((uint32_t *)buffer.get()) = htonl(value); // host to network byte order
+	m_output = PendingOutput();
+	m_output.m_data = buffer;
+	m_output.m_size = PROTOBUF_HEADER_LENGTH;
+}
+
+template <typename STREAM>
+void TcpConnection<STREAM>::openDownloadFile(const SendMessage &msg)
+{
+	const static char fname[] = "TcpConnection::openDownloadFile() ";
+
+	ACE_HANDLE handle = ACE_OS::open(msg.m_downloadFile.c_str(), O_RDONLY);
+	ACE_stat fileStat;
+	if (handle == ACE_INVALID_HANDLE || ACE_OS::fstat(handle, &fileStat) == -1)
+	{
+		LOG_ERR << fname << "open <" << msg.m_downloadFile << "> failed with error: " << std::strerror(errno);
+		if (handle != ACE_INVALID_HANDLE)
+			ACE_OS::close(handle);
+		// send last 0 for delimiter
+		outputHeader(0);
+		return;
+	}
+	// file may changed after range was checked
+	const uint64_t fileSize = fileStat.st_size;
+	const uint64_t offset = std::min(msg.m_downloadOffset, fileSize);
+	const uint64_t length = std::min(msg.m_downloadLength, fileSize - offset);
+	m_downloadFile = std::make_unique<DownloadFile>(handle, offset, length, Configuration::instance()->getTcpFileChunkSize(), zeroCopy());
+	LOG_DBG << fname << "download <" << msg.m_downloadFile << "> offset <" << offset << "> length <" << length << "> zero copy <" << m_downloadFile->m_zeroCopy << ">";
+}
+
+template <typename STREAM>
+bool TcpConnection<STREAM>::readFileChunk()
+{
+	const static char fname[] = "TcpConnection::readFileChunk() ";
+
+	auto &file = *m_downloadFile;
+	const size_t chunkSize = std::min<uint64_t>(file.m_remaining, file.m_chunkSize);
+	if (chunkSize == 0)
+	{
+		// send last 0 for delimiter
+		m_downloadFile.reset();
+		outputHeader(0);
+		return true;
+	}
+	if (file.m_zeroCopy)
+	{
+		// chunk header from user space, data from page cache to socket in kernel by sendFileChunk()
+		outputHeader(chunkSize);
+		file.m_chunkPending = chunkSize;
+		return true;
+	}
+	// chunk header and data are sent with one write
+	auto buffer = BufferPool::instance().allocate(PROTOBUF_HEADER_LENGTH + chunkSize);
+	const auto readSize = ACE_OS::pread(file.m_handle, buffer.get() + PROTOBUF_HEADER_LENGTH, chunkSize, file.m_offset);
+	if (readSize <= 0)
+	{
+		LOG_ERR << fname << "read file failed with error: " << std::strerror(errno);
+		m_downloadFile.reset();
+		return false;
+	}
+	*((uint32_t *)buffer.get()) = htonl(readSize); // host to network byte order
+	m_output = PendingOutput();
+	m_output.m_data = buffer;
+	m_output.m_size = PROTOBUF_HEADER_LENGTH + readSize;
+	file.m_offset += readSize;
+	file.m_remaining -= readSize;
+	return true;
+}
+
+template <typename STREAM>
+typename TcpConnection<STREAM>::SendResult TcpConnection<STREAM>::sendFileChunk()
+{
+	auto &file = *m_downloadFile;
+	const auto sent = sendFile(file.m_handle, file.m_offset, file.m_chunkPending);
+	if (sent < 0)
+	{
+		m_downloadFile.reset();
+		return SendResult::Failed;
+	}
+	file.m_offset += sent;
+	file.m_remaining -= sent;
+	file.m_chunkPending -= sent;
+	// short write means socket buffer is full, resume from the recorded offset
+	return file.m_chunkPending ? SendResult::WouldBlock : SendResult::Done;
+}
+
+template <>
+bool TcpConnection<ACE_LSOCK_Stream>::zeroCopy()
+{
+	return true;
+}
+
+template <>
+bool TcpConnection<ACE_SSL_SOCK_Stream>::zeroCopy()
+{
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+	return BIO_get_ktls_send(SSL_get_wbio(this->peer().ssl()));
+#else
+	return false;
+#endif
+}
+
+template <>
+ssize_t TcpConnection<ACE_LSOCK_Stream>::sendFile(ACE_HANDLE file, off_t offset, size_t size)
+{
+	const static char fname[] = "TcpConnection::sendFile() ";
+
+	// header already promised size bytes, short file is treated as failure
+	size_t totalSent = 0;
+	while (totalSent < size)
+	{
+		off_t fileOffset = offset + totalSent;
+		const auto sent = ::sendfile(this->peer().get_handle(), file, &fileOffset, size - totalSent);
+		if (sent > 0)
+		{
+			totalSent += sent;
+		}
+		else if (sent < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		else if (sent < 0 && (errno == EWOULDBLOCK || errno == EAGAIN))
+		{
+			break;
+		}
+		else
+		{
+			LOG_ERR << fname << m_clientHostName << " sendfile failed with error: " << std::strerror(errno);
+			return -1;
+		}
+	}
+	return totalSent;
+}
+
+template <>
+ssize_t TcpConnection<ACE_SSL_SOCK_Stream>::sendFile(ACE_HANDLE file, off_t offset, size_t size)
+{
+	const static char fname[] = "TcpConnection::sendFile() ";
+
+#if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+	// kTLS: record encryption done in kernel, file pages are not copied to user space
+	size_t totalSent = 0;
+	while (totalSent < size)
+	{
+		const auto sent = SSL_sendfile(this->peer().ssl(), file, offset + totalSent, size - totalSent, 0);
+		if (sent > 0)
+		{
+			totalSent += sent;
+		}
+		else if (sent < 0 && SSL_get_error(this->peer().ssl(), sent) == SSL_ERROR_WANT_WRITE)
+		{
+			break;
+		}
+		else if (sent < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		else
+		{
+			LOG_ERR << fname << m_clientHostName << " SSL_sendfile failed with error: " << std::strerror(errno);
+			return -1;
+		}
+	}
+	return totalSent;
+#else
+	LOG_ERR << fname << "kernel TLS not supported";
+	return -1;
+#endif
+}
+
+template <typename STREAM>
+typename TcpConnection<STREAM>::RecvResult TcpConnection<STREAM>::recvFrame()
+{
+	const static char fname[] = "TcpConnection::recvFrame() ";
+
+	while (true)
+	{
+		const bool readHeader = (m_input.m_headerReceived < PROTOBUF_HEADER_LENGTH);
+		if (!readHeader && m_input.m_bodyReceived == m_input.m_bodySize)
+		{
+			return RecvResult::Done;
+		}
+		char *buffer = readHeader ? (m_input.m_header + m_input.m_headerReceived) : (m_input.m_body.get() + m_input.m_bodyReceived);
+		const size_t size = readHeader ? (PROTOBUF_HEADER_LENGTH - m_input.m_headerReceived) : (m_input.m_bodySize - m_input.m_bodyReceived);
+
+		errno = 0;
+		const auto received = recvSome(this->peer(), buffer, size);
+		if (received > 0 && readHeader)
+		{
+			m_input.m_headerReceived += received;
+			if (m_input.m_headerReceived == PROTOBUF_HEADER_LENGTH)
 			{
-				// get length of file:
-				file.seekg(0, file.end);
-				auto fileEnd = file.tellg();
-				file.seekg(0, file.beg);
-				auto currentPos = file.tellg();
-				while (currentPos < fileEnd && file.good())
+				const auto bodySize = ProtobufHelper::parseMsgHeader(m_input.m_header, m_input.m_compressed);
+				if (bodySize < 0)
 				{
-					// continue read data chunk
-					file.readsome(pBuffer.get(), BLOCK_CHUNK_SIZE);
-					auto readChunkSize = file.tellg() - currentPos;
-					currentPos = file.tellg();
-
-					// send chunk size to client
-					if (!sendBytes(readChunkSize) || !sendBytes(pBuffer.get(), readChunkSize))
-					{
-						LOG_ERR << fname << "send response failed with error: " << std::strerror(errno);
-						return false;
-					}
+					return RecvResult::Failed;
 				}
+				m_input.m_bodySize = bodySize;
+				m_input.m_body = bodySize ? BufferPool::instance().allocate(bodySize) : nullptr;
+			}
+		}
+		else if (received > 0)
+		{
+			m_input.m_bodyReceived += received;
+		}
+		else if (received == 0)
+		{
+			return RecvResult::Closed;
+		}
+		else if (errno == EINTR)
+		{
+			continue;
+		}
+		else if (errno == EWOULDBLOCK || errno == EAGAIN)
+		{
+			// partial frame is kept, resumed on next read readiness
+			return RecvResult::WouldBlock;
+		}
+		else
+		{
+			LOG_ERR << fname << "recv from " << m_clientHostName << " failed with error: " << std::strerror(errno);
+			return RecvResult::Failed;
+		}
+	}
+}
+
+template <typename STREAM>
+int TcpConnection<STREAM>::recvFrames()
+{
+	const static char fname[] = "TcpConnection::recvFrames() ";
+
+	// drain socket until it would block, TLS may have buffered several frames with one readiness
+	while (!m_readSuspended)
+	{
+		const auto result = recvFrame();
+		if (result == RecvResult::WouldBlock)
+		{
+			return 0;
+		}
+		else if (result == RecvResult::Closed)
+		{
+			LOG_ERR << fname << "Connection from " << m_clientHostName << " closing down";
+			return -1;
+		}
+		else if (result == RecvResult::Failed)
+		{
+			LOG_ERR << fname << "Problems in receiving data from " << m_clientHostName;
+			return -1;
+		}
+
+		// complete frame, reset input for the next one
+		auto data = std::move(m_input.m_body);
+		auto size = static_cast<int>(m_input.m_bodySize);
+		const auto compressed = m_input.m_compressed;
+		m_input = InputFrame();
+		if (compressed && data)
+		{
+			auto decompressed = ProtobufHelper::decompress(data.get(), size);
+			data = std::get<0>(decompressed);
+			size = std::get<1>(decompressed);
+			if (data == nullptr && m_uploadFile)
+			{
+				m_uploadFile.reset();
+				LOG_ERR << fname << "invalid file chunk from client=" << m_id;
+				return -1;
+			}
+			else if (data == nullptr)
+			{
+				LOG_WAR << fname << "ignore invalid compressed message from client=" << m_id;
+				continue;
 			}
-			// send last 0 for delimiter
-			sendBytes(0);
 		}
 
-		if (resp.http_status == web::http::status_codes::OK &&
-			resp.body_msg_type == web::http::mime_types::application_octetstream &&
-			resp.request_uri == "/appmesh/file/upload" && resp.body.size() &&
-			nlohmann::json::parse(resp.body).contains(TCP_JSON_MSG_FILE))
+		// upload file chunks follow upload response
+		if (m_uploadFile)
 		{
-			auto path = nlohmann::json::parse(resp.body)[TCP_JSON_MSG_FILE].get<std::string>();
-			std::ofstream file(path, std::ios::binary | std::ios::out | std::ios::trunc);
-			auto msg = ProtobufHelper::readMessageBlock(this->peer());
-			while (std::get<0>(msg) != nullptr)
+			if (this->recvFileChunk(data, size) == -1)
 			{
-				auto msgData = std::get<0>(msg);
-				auto msgSize = std::get<1>(msg);
-				file.write(msgData.get(), msgSize);
-				msg = ProtobufHelper::readMessageBlock(this->peer());
+				return -1;
 			}
 		}
+		else if (data)
+		{
+			this->dispatch(data.get(), size);
+		}
+		else
+		{
+			LOG_WAR << fname << "ignore empty message from client=" << m_id;
+		}
 	}
-	else
+	return 0;
+}
+
+template <typename STREAM>
+int TcpConnection<STREAM>::recvFileChunk(const std::shared_ptr<char> &data, int size)
+{
+	const static char fname[] = "TcpConnection::recvFileChunk() ";
+
+	if (data != nullptr)
 	{
-		LOG_WAR << fname << "Socket not available, ignore message: " << resp.uuid;
-		return false;
+		// keep receiving until delimiter even if file is not writable, so the stream stay in sync
+		m_uploadFile->append(data.get(), size);
+		// back pressure: stop reading socket instead of waiting for disk in reactor thread
+		if (m_uploadFile->backlogged())
+		{
+			if (this->reactor()->cancel_wakeup(this, ACE_Event_Handler::READ_MASK) == -1)
+			{
+				LOG_ERR << fname << "suspend read failed with error: " << std::strerror(errno);
+				return -1;
+			}
+			m_readSuspended = true;
+			LOG_DBG << fname << "suspend read for client=" << m_id << " until upload writer catch up";
+		}
+		return 0;
 	}
-	LOG_DBG << fname << "successfully";
-	return true;
+	// last 0 delimiter
+	const auto success = m_uploadFile->finish();
+	m_uploadFile.reset();
+	LOG_DBG << fname << "file upload finished for client=" << m_id << " with result: " << success;
+	return 0;
 }
 
 ACE_SSL_Context *TcpHandler::initTcpSSL(ACE_SSL_Context *context)
@@ -290,6 +989,34 @@ ACE_SSL_Context *TcpHandler::initTcpSSL(ACE_SSL_Context *context)
 		LOG_WAR << fname << "SSL_CTX_set_cipher_list failed: " << std::strerror(errno);
 	}
 	SSL_CTX_clear_options(context->context(), SSL_OP_ALLOW_UNSAFE_LEGACY_RENEGOTIATION);
+	// socket is non-blocking, SSL_write may accept part of the buffer and be retried from a new offset
+	SSL_CTX_set_mode(context->context(), SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+	// Session resumption: server side session cache (TLS 1.2 session id) and stateless tickets (TLS 1.2/1.3),
+	// reconnecting clients skip certificate exchange and key agreement
+	const auto sessionTimeout = Configuration::instance()->getSSLSessionTimeout();
+	SSL_CTX_set_session_cache_mode(context->context(), SSL_SESS_CACHE_SERVER);
+	SSL_CTX_sess_set_cache_size(context->context(), TCP_SSL_SESSION_CACHE_SIZE);
+	SSL_CTX_set_timeout(context->context(), sessionTimeout);
+	SSL_CTX_clear_options(context->context(), SSL_OP_NO_TICKET);
+	// required for resumption when client certificate is verified
+	if (!SSL_CTX_set_session_id_context(context->context(), (const unsigned char *)TCP_SSL_SESSION_ID_CONTEXT, std::strlen(TCP_SSL_SESSION_ID_CONTEXT)))
+	{
+		LOG_WAR << fname << "SSL_CTX_set_session_id_context failed: " << std::strerror(errno);
+	}
+	LOG_INF << fname << "TLS session resumption enabled with timeout: " << sessionTimeout;
+
+	// Kernel TLS: record encryption of established connection is done in kernel, so file
+	// chunks can be sent without copy to user space buffer, need OpenSSL 3 and kernel tls module
+	if (Configuration::instance()->getSSLKernelOffload())
+	{
+#ifdef SSL_OP_ENABLE_KTLS
+		SSL_CTX_set_options(context->context(), SSL_OP_ENABLE_KTLS);
+		LOG_INF << fname << "kernel TLS offload enabled";
+#else
+		LOG_WAR << fname << "kernel TLS offload not supported by OpenSSL " << OPENSSL_VERSION_TEXT;
+#endif
+	}
 
 	if (verifyClient && ACE_OS::access(ca.c_str(), R_OK) == 0)
 	{
@@ -303,54 +1030,59 @@ ACE_SSL_Context *TcpHandler::initTcpSSL(ACE_SSL_Context *context)
 	return context;
 }
 
-bool TcpHandler::sendBytes(const char *data, size_t length)
-{
-	const static char fname[] = "TcpHandler::sendBytes() ";
-
-	size_t totalSent = 0;
-	while (totalSent < length)
-	{
-		size_t sendSize = 0;
-		size_t sendReturn = 0;
-		errno = 0;
-		sendReturn = (size_t)this->peer().send_n((void *)(data + totalSent), (length - totalSent), 0, &sendSize);
-		LOG_DBG << fname << m_clientHostName << " total length: " << (length - totalSent) << " sent length:" << sendSize << " with result: " << std::strerror(errno);
-		if (sendReturn == 0)
-		{
-			if (EINTR == errno)
-			{
-				LOG_WAR << fname << m_clientHostName << " send response failed with warning: " << std::strerror(errno);
-			}
-			else
-			{
-				LOG_ERR << fname << m_clientHostName << " send response failed with error: " << std::strerror(errno);
-				return false;
-			}
-		}
-		totalSent += sendSize;
-	}
-	LOG_DBG << fname << m_clientHostName << " success";
-	return true;
-}
-
-bool TcpHandler::sendBytes(size_t intValue)
+TcpHandler::TlsStats TcpHandler::tlsStats()
 {
-	char headerBuff[PROTOBUF_HEADER_LENGTH];
-	// write data size to header
-	*((uint32_t *)headerBuff) = htonl(intValue); // host to network byte order
-	return sendBytes(headerBuff, PROTOBUF_HEADER_LENGTH);
+	return TlsStats{m_tlsHandshakes.load(), m_tlsResumed.load(), m_tlsKernelOffload.load()};
 }
 
 bool TcpHandler::replyTcp(int tcpHandlerId, const Response &resp)
 {
 	const static char fname[] = "TcpHandler::replyTcp() ";
 
-	ACE_GUARD_RETURN(ACE_Recursive_Thread_Mutex, locker, m_handlers.mutex(), false);
-	TcpHandler *client = NULL;
-	if (m_handlers.find(tcpHandlerId, client) == 0 && client)
+	// only hold shard lock for lookup, the reference keeps handler alive during reply
+	ACE_Event_Handler_var clientRef;
+	TcpHandler *client = nullptr;
+	m_handlers.find(tcpHandlerId, [&clientRef, &client](TcpHandler *&handler)
+					{
+						handler->eventHandler()->add_reference();
+						clientRef.reset(handler->eventHandler());
+						client = handler;
+					});
+	if (client)
 	{
 		return client->reply(resp);
 	}
 	LOG_WAR << fname << "Client " << tcpHandlerId << " not exist, can not reply response: " << resp.uuid;
 	return false;
 }
+
+bool TcpHandler::waitSendQueue(int tcpHandlerId, size_t highWater, std::chrono::milliseconds timeout)
+{
+	// reference keeps handler alive during wait, handle_close() wake up waiter
+	ACE_Event_Handler_var clientRef;
+	TcpHandler *client = nullptr;
+	m_handlers.find(tcpHandlerId, [&clientRef, &client](TcpHandler *&handler)
+					{
+						handler->eventHandler()->add_reference();
+						clientRef.reset(handler->eventHandler());
+						client = handler;
+					});
+	return client && client->waitSendQueueBelow(highWater, timeout);
+}
+
+bool TcpHandler::connected(int tcpHandlerId)
+{
+	// handler is removed from registry in handle_close()
+	return m_handlers.find(tcpHandlerId, [](TcpHandler *&) {});
+}
+
+bool TcpHandler::streaming(int tcpHandlerId)
+{
+	bool streaming = false;
+	m_handlers.find(tcpHandlerId, [&streaming](TcpHandler *&handler)
+					{ streaming = handler->m_streaming; });
+	return streaming;
+}
+
+template class TcpConnection<ACE_SSL_SOCK_Stream>;
+template class TcpConnection<ACE_LSOCK_Stream>;
@@ -1,65 +1,274 @@
 #pragma once
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <vector>
 
-#include <ace/Map_Manager.h>
-#include <ace/Recursive_Thread_Mutex.h>
+#include <ace/LSOCK_Stream.h>
+#include <ace/OS_NS_unistd.h>
 #include <ace/SSL/SSL_SOCK_Stream.h>
 #include <ace/Svc_Handler.h>
 
-#include "../../common/MessageQueue.h"
+#include "../../common/ShardedMap.h"
+#include "../../common/Utility.h"
+#include "RequestQueue.h"
+#include "UploadWriter.h"
 #include "protoc/ProtobufHelper.h"
 
 // = TITLE
 //     Receive client message from the remote clients.
 //
 // = DESCRIPTION
-//     This class demonstrates how to receive messages from remote
-//     clients using the notification mechanisms in the
-//     <ACE_Reactor>.  In addition, it also illustrates how to
-//     utilize the <ACE_Reactor> timer mechanisms, as well.
+//     TcpHandler holds the connection registry, REST worker dispatch and reactor shards,
+//     shared by all transports. TcpConnection<STREAM> is the per connection reactor handler,
+//     it is instantiated for TLS (ACE_SSL_SOCK_Stream) and for local Unix domain socket
+//     (ACE_LSOCK_Stream) which use the same framing without encryption.
 //
 //     Note: the construction function of ACE_SSL_SOCK_Stream can used to specify a ACE_SSL_Context
 //       Define a new ACE_SSL_SOCK_Stream if you want to change the global ACE_SSL_Context
 //       ACE_SSL_SOCK_Stream (ACE_SSL_Context *context = ACE_SSL_Context::instance ());
-class TcpHandler : public ACE_Svc_Handler<ACE_SSL_SOCK_Stream, ACE_NULL_SYNCH>
+//
+//     Note: TcpConnection is reference counted, the reactor and each in-flight replyTcp() hold
+//       one reference, the object is deleted when the last reference is released.
+//
+//     Note: all socket read and write happen in the owner reactor thread, worker threads
+//       only enqueue responses to the connection send queue and notify reactor to drain.
+class TcpHandler
 {
 public:
 	TcpHandler(void);
 	virtual ~TcpHandler(void);
 
-	// = Hooks for opening and closing handlers.
-	virtual int open(void *);
-
 	/// <summary>
 	/// Process TCP request
 	/// </summary>
-	static void handleTcpRest();
+	/// <param name="workerIndex">worker index of REST thread pool</param>
+	static void handleTcpRest(size_t workerIndex);
+	static void initMsgQueue(size_t workerNum);
 	static void closeMsgQueue();
+	static const RequestQueue &requestQueue();
+
+	/// <summary>
+	/// Create reactors used to shard accepted connections, each reactor is driven by one dedicated thread
+	/// </summary>
+	/// <param name="reactorNum">number of reactors</param>
+	/// <returns>created reactors</returns>
+	static const std::vector<std::unique_ptr<ACE_Reactor>> &initReactors(size_t reactorNum);
+	static void closeReactors();
+
+	static bool replyTcp(int tcpHandlerId, const Response &resp);
+	/// <summary>
+	/// Wait until queued response bytes of the connection fall below high water mark,
+	/// used by response producer to follow the speed of peer
+	/// </summary>
+	/// <returns>false when connection is closed or wait timeout</returns>
+	static bool waitSendQueue(int tcpHandlerId, size_t highWater, std::chrono::milliseconds timeout);
+	/// <summary>
+	/// Whether the TCP connection is still open
+	/// </summary>
+	static bool connected(int tcpHandlerId);
+	/// <summary>
+	/// Whether the peer accept multi-frame streamed response
+	/// </summary>
+	static bool streaming(int tcpHandlerId);
+	static ACE_SSL_Context *initTcpSSL(ACE_SSL_Context *context);
+
+	/// <summary>
+	/// Accumulated TLS handshake statistic since start
+	/// </summary>
+	struct TlsStats
+	{
+		uint64_t m_handshakes;	  // all accepted TLS handshakes
+		uint64_t m_resumed;		  // handshakes resumed from session cache or ticket
+		uint64_t m_kernelOffload; // connections with kernel TLS send offload enabled
+	};
+	static TlsStats tlsStats();
+
 	const int &id();
 
 protected:
-	// = Demultiplexing hooks.
-	virtual int handle_input(ACE_HANDLE);
-
 	/// <summary>
-	/// Reply response to Golang
+	/// Reply response to Golang, enqueue to send queue and return without wait socket write
 	/// </summary>
 	/// <param name="Response"></param>
-	bool reply(const Response &resp);
-	bool sendBytes(const char *data, size_t length);
-	bool sendBytes(size_t intValue);
+	virtual bool reply(const Response &resp) = 0;
+	/// <summary>
+	/// Block caller until send queue bytes below highWater
+	/// </summary>
+	virtual bool waitSendQueueBelow(size_t highWater, std::chrono::milliseconds timeout) = 0;
+	/// <summary>
+	/// Reactor event handler of this connection, used to hold reference
+	/// </summary>
+	virtual ACE_Event_Handler *eventHandler() = 0;
+
+	/// <summary>
+	/// Decode a received request frame in reactor thread and enqueue to REST workers
+	/// </summary>
+	void dispatch(const char *data, int dataSize);
+	/// <summary>
+	/// Reactor shard for a new connection
+	/// </summary>
+	static ACE_Reactor *nextReactor();
 
+protected:
+	const int m_id;
+	// response frame compression, wire schema and streaming negotiated by client request header
+	std::atomic_bool m_compression;
+	std::atomic<WireSchema> m_wireSchema;
+	std::atomic_bool m_streaming;
+
+	static ShardedMap<int, TcpHandler *> m_handlers;
+	static std::atomic<uint64_t> m_tlsHandshakes;
+	static std::atomic<uint64_t> m_tlsResumed;
+	static std::atomic<uint64_t> m_tlsKernelOffload;
+
+private:
+	static RequestQueue m_requestQueue;
+	static std::atomic_int m_idGenerator;
+	static std::vector<std::unique_ptr<ACE_Reactor>> m_reactors;
+	static std::atomic_size_t m_reactorIndex;
+};
+
+template <typename STREAM>
+class TcpConnection : public ACE_Svc_Handler<STREAM, ACE_NULL_SYNCH>, public TcpHandler
+{
 public:
-	static bool replyTcp(int tcpHandlerId, const Response &resp);
-	static ACE_SSL_Context *initTcpSSL(ACE_SSL_Context *context);
+	TcpConnection(void);
+	virtual ~TcpConnection(void);
+
+	// = Hooks for opening and closing handlers.
+	virtual int open(void *) override;
+
+protected:
+	// = Demultiplexing hooks.
+	virtual int handle_input(ACE_HANDLE) override;
+	virtual int handle_output(ACE_HANDLE) override;
+	virtual int handle_close(ACE_HANDLE, ACE_Reactor_Mask) override;
+
+	virtual bool reply(const Response &resp) override;
+	virtual bool waitSendQueueBelow(size_t highWater, std::chrono::milliseconds timeout) override;
+	virtual ACE_Event_Handler *eventHandler() override;
+
+private:
+	/// <summary>
+	/// Outbound message: serialized frame (header + body) and optional file stream action after frame sent
+	/// </summary>
+	struct SendMessage
+	{
+		std::shared_ptr<msgpack::sbuffer> m_frame;
+		std::string m_downloadFile;
+		uint64_t m_downloadOffset = 0;
+		uint64_t m_downloadLength = std::numeric_limits<uint64_t>::max();
+		std::string m_uploadFile;
+	};
+	/// <summary>
+	/// File byte range being streamed to client, one chunk per reactor notification
+	/// </summary>
+	struct DownloadFile
+	{
+		DownloadFile(ACE_HANDLE handle, off_t offset, uint64_t remaining, size_t chunkSize, bool zeroCopy)
+			: m_handle(handle), m_offset(offset), m_remaining(remaining), m_chunkSize(chunkSize), m_zeroCopy(zeroCopy), m_chunkPending(0) {}
+		~DownloadFile() { ACE_OS::close(m_handle); }
+		const ACE_HANDLE m_handle;
+		off_t m_offset;
+		uint64_t m_remaining;
+		const size_t m_chunkSize;
+		const bool m_zeroCopy;
+		// zero copy chunk bytes promised by the sent chunk header but not written yet
+		uint64_t m_chunkPending;
+	};
+	/// <summary>
+	/// Bytes taken from send queue but not completely written to socket yet, resumed on write readiness
+	/// </summary>
+	struct PendingOutput
+	{
+		std::shared_ptr<const char> m_data;
+		size_t m_size = 0;
+		size_t m_offset = 0;
+		// file stream action start after data is written
+		SendMessage m_follow;
+	};
+	enum class SendResult
+	{
+		Done,
+		WouldBlock,
+		Failed
+	};
+	/// <summary>
+	/// Inbound frame being reassembled, header and body arrive in any number of non-blocking reads
+	/// </summary>
+	struct InputFrame
+	{
+		char m_header[PROTOBUF_HEADER_LENGTH] = {0};
+		size_t m_headerReceived = 0;
+		std::shared_ptr<char> m_body;
+		size_t m_bodySize = 0;
+		size_t m_bodyReceived = 0;
+		bool m_compressed = false;
+	};
+	enum class RecvResult
+	{
+		Done,
+		WouldBlock,
+		Closed,
+		Failed
+	};
+	bool enqueueSend(SendMessage &&msg);
+	// move next batch of queued frames to pending output, return false when queue is empty
+	bool takeBatch();
+	// write pending output without blocking, keep written offset when socket buffer is full
+	SendResult flushOutput();
+	// start file download or upload follow the response frame
+	void startFileStream(const SendMessage &msg);
+	// set pending output to a 4 bytes length header
+	void outputHeader(uint32_t value);
+	// open file for download stream, output last 0 delimiter when file not available
+	void openDownloadFile(const SendMessage &msg);
+	// move next file chunk of current download to pending output, return false when read failed
+	bool readFileChunk();
+	// send pending zero copy chunk data without blocking
+	SendResult sendFileChunk();
+	// whether file data can be sent by kernel without copy to user space (plain socket or kTLS)
+	bool zeroCopy();
+	// send file range by sendfile until socket buffer is full, return sent bytes or -1 when failed
+	ssize_t sendFile(ACE_HANDLE file, off_t offset, size_t size);
+	// read socket without blocking until current input frame is complete, keep partial frame when no more data
+	RecvResult recvFrame();
+	// handle complete frames until socket has no more data or read is suspended
+	int recvFrames();
+	// write one received file chunk of current upload, empty chunk is the last delimiter
+	int recvFileChunk(const std::shared_ptr<char> &data, int size);
+	// transport specific peer setup and authorization after accept, set m_clientHostName
+	bool initPeer();
 
 private:
 	std::string m_clientHostName;
-	std::mutex m_socketLock;
-	const int m_id;
+	bool m_registered;
 
-	static ACE_Map_Manager<int, TcpHandler *, ACE_Recursive_Thread_Mutex> m_handlers;
-	static MessageQueue m_messageQueue;
-	static std::atomic_int m_idGenerator;
+	// send queue, accessed from worker threads and reactor thread
+	std::mutex m_sendQueueLock;
+	std::deque<SendMessage> m_sendQueue;
+	size_t m_sendQueueBytes;
+	// notified when queued bytes decrease or connection closed
+	std::condition_variable m_sendQueueCond;
+	bool m_sendScheduled;
+	bool m_closed;
+
+	// output and file stream state, only accessed from reactor thread
+	PendingOutput m_output;
+	bool m_writeWait;
+	InputFrame m_input;
+	// socket read stopped while upload writer is backlogged
+	bool m_readSuspended;
+	std::unique_ptr<DownloadFile> m_downloadFile;
+	std::unique_ptr<UploadWriter> m_uploadFile;
 };
+
+// TLS connection from remote or local clients
+typedef TcpConnection<ACE_SSL_SOCK_Stream> TlsTcpHandler;
+// Unix domain socket connection from local clients, authorized by socket file permission and SO_PEERCRED
+typedef TcpConnection<ACE_LSOCK_Stream> UnixTcpHandler;
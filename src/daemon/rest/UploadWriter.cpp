@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cstring>
+
+#include <ace/ACE.h>
+#include <ace/OS_NS_unistd.h>
+
+#include "../../common/BufferPool.h"
+#include "../../common/Utility.h"
+#include "UploadWriter.h"
+
+std::atomic<uint64_t> UploadWriter::m_activeUploads(0);
+std::atomic<uint64_t> UploadWriter::m_totalBytes(0);
+std::atomic<uint64_t> UploadWriter::m_lastBytesPerSecond(0);
+
+UploadWriter::UploadWriter(const std::string &path, UploadSyncPolicy syncPolicy, std::function<void()> onDrained)
+	: m_path(path), m_syncPolicy(syncPolicy), m_onDrained(onDrained), m_handle(ACE_INVALID_HANDLE), m_bufferSize(0),
+	  m_finished(false), m_waitDrain(false), m_failed(false), m_received(0), m_reported(0), m_startTime(std::chrono::steady_clock::now())
+{
+	++m_activeUploads;
+}
+
+UploadWriter::~UploadWriter()
+{
+	finish();
+	--m_activeUploads;
+}
+
+bool UploadWriter::open()
+{
+	const static char fname[] = "UploadWriter::open() ";
+
+	m_handle = ACE_OS::open(m_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (m_handle == ACE_INVALID_HANDLE)
+	{
+		LOG_ERR << fname << "create file <" << m_path << "> failed with error: " << std::strerror(errno);
+		m_failed = true;
+		return false;
+	}
+	m_buffer = BufferPool::instance().allocate(TCP_UPLOAD_BUFFER_SIZE);
+	m_thread = std::make_unique<std::thread>(&UploadWriter::run, this);
+	return true;
+}
+
+bool UploadWriter::append(const char *data, size_t size)
+{
+	const static char fname[] = "UploadWriter::append() ";
+
+	if (m_failed)
+		return false;
+
+	m_received += size;
+	while (size > 0)
+	{
+		const auto copySize = std::min(size, TCP_UPLOAD_BUFFER_SIZE - m_bufferSize);
+		std::memcpy(m_buffer.get() + m_bufferSize, data, copySize);
+		m_bufferSize += copySize;
+		data += copySize;
+		size -= copySize;
+		if (m_bufferSize == TCP_UPLOAD_BUFFER_SIZE)
+			flush();
+	}
+
+	if (m_received - m_reported >= TCP_UPLOAD_PROGRESS_BYTES)
+	{
+		m_reported = m_received;
+		const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+		LOG_INF << fname << "upload <" << m_path << "> received <" << m_received << "> bytes, <" << (uint64_t)(m_received / std::max(seconds, 0.001)) << "> bytes/sec";
+	}
+	return !m_failed;
+}
+
+void UploadWriter::flush()
+{
+	if (m_bufferSize == 0)
+		return;
+
+	{
+		// never wait writer here, owner check backlogged() and stop receiving instead
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_pending.push_back(Block{m_buffer, m_bufferSize});
+	}
+	m_cv.notify_all();
+	m_buffer = BufferPool::instance().allocate(TCP_UPLOAD_BUFFER_SIZE);
+	m_bufferSize = 0;
+}
+
+bool UploadWriter::backlogged()
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	if (m_failed || m_pending.size() < TCP_UPLOAD_PENDING_BUFFERS)
+		return false;
+	m_waitDrain = true;
+	return true;
+}
+
+bool UploadWriter::finish()
+{
+	const static char fname[] = "UploadWriter::finish() ";
+
+	if (m_thread == nullptr)
+		return !m_failed;
+
+	flush();
+	{
+		std::lock_guard<std::mutex> guard(m_mutex);
+		m_finished = true;
+		m_waitDrain = false;
+	}
+	m_cv.notify_all();
+	m_thread->join();
+	m_thread.reset();
+
+	if (!m_failed && m_syncPolicy == UploadSyncPolicy::Close && ACE_OS::fsync(m_handle) == -1)
+	{
+		LOG_ERR << fname << "fsync <" << m_path << "> failed with error: " << std::strerror(errno);
+		m_failed = true;
+	}
+	ACE_OS::close(m_handle);
+	m_handle = ACE_INVALID_HANDLE;
+
+	const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_startTime).count();
+	const auto bytesPerSecond = (uint64_t)(m_received / std::max(seconds, 0.001));
+	m_lastBytesPerSecond = bytesPerSecond;
+	LOG_INF << fname << "upload <" << m_path << "> finished with <" << m_received << "> bytes in <" << seconds << "> seconds, <" << bytesPerSecond << "> bytes/sec, success: " << !m_failed;
+	return !m_failed;
+}
+
+void UploadWriter::run()
+{
+	const static char fname[] = "UploadWriter::run() ";
+
+	while (true)
+	{
+		Block block;
+		bool drained = false;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cv.wait(lock, [this]
+					  { return !m_pending.empty() || m_finished; });
+			if (m_pending.empty())
+				break;
+			block = std::move(m_pending.front());
+			m_pending.pop_front();
+			drained = m_waitDrain && m_pending.size() < TCP_UPLOAD_PENDING_BUFFERS;
+			if (drained)
+				m_waitDrain = false;
+		}
+		m_cv.notify_all();
+		if (drained && m_onDrained)
+			m_onDrained();
+
+		if (m_failed)
+			continue; // drain only
+		if (ACE::write_n(m_handle, block.m_buffer.get(), block.m_size) != (ssize_t)block.m_size)
+		{
+			LOG_ERR << fname << "write <" << m_path << "> failed with error: " << std::strerror(errno);
+			m_failed = true;
+			m_cv.notify_all();
+			continue;
+		}
+		if (m_syncPolicy == UploadSyncPolicy::Buffer && ACE_OS::fsync(m_handle) == -1)
+		{
+			LOG_ERR << fname << "fsync <" << m_path << "> failed with error: " << std::strerror(errno);
+			m_failed = true;
+			m_cv.notify_all();
+			continue;
+		}
+		m_totalBytes += block.m_size;
+	}
+}
+
+UploadSyncPolicy UploadWriter::parseSyncPolicy(const std::string &policy)
+{
+	if (policy == "close")
+		return UploadSyncPolicy::Close;
+	if (policy == "buffer")
+		return UploadSyncPolicy::Buffer;
+	return UploadSyncPolicy::None;
+}
+
+UploadWriter::Stats UploadWriter::stats()
+{
+	return Stats{m_activeUploads.load(), m_totalBytes.load(), m_lastBytesPerSecond.load()};
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <ace/OS_NS_fcntl.h>
+
+/// <summary>
+/// When uploaded data is flushed to disk
+/// </summary>
+enum class UploadSyncPolicy : int
+{
+	None = 0, // leave to page cache
+	Close,	  // fsync once when upload finished
+	Buffer	  // fsync after each buffer written
+};
+
+/// <summary>
+/// Write-behind file writer for TCP file upload.
+/// Received chunks are coalesced into pooled large buffers by the reactor thread,
+/// full buffers are written by a background thread so disk latency does not block
+/// socket receive or responses of other requests owned by the same reactor.
+/// The number of pending buffers is bounded: when writer falls behind, the owner
+/// stops reading the socket and is called back to resume once the backlog drains.
+/// </summary>
+class UploadWriter
+{
+public:
+	/// <summary>
+	/// Accumulated upload statistic since start
+	/// </summary>
+	struct Stats
+	{
+		uint64_t m_activeUploads;
+		uint64_t m_totalBytes;
+		uint64_t m_lastBytesPerSecond; // throughput of last finished upload
+	};
+
+	/// <param name="onDrained">called from writer thread when backlog fall below limit after backlogged() returned true</param>
+	UploadWriter(const std::string &path, UploadSyncPolicy syncPolicy, std::function<void()> onDrained = nullptr);
+	virtual ~UploadWriter();
+
+	/// <summary>
+	/// Create file and start background writer
+	/// </summary>
+	/// <returns>false if file can not be created, later data is discarded</returns>
+	bool open();
+	/// <summary>
+	/// Append received chunk
+	/// </summary>
+	/// <returns>false if file is not writable</returns>
+	bool append(const char *data, size_t size);
+	/// <summary>
+	/// Whether pending buffers reached the limit, onDrained is called once when writer catch up
+	/// </summary>
+	bool backlogged();
+	/// <summary>
+	/// Write pending buffers, sync according to policy and close file
+	/// </summary>
+	/// <returns>false if any write failed</returns>
+	bool finish();
+
+	static UploadSyncPolicy parseSyncPolicy(const std::string &policy);
+	static Stats stats();
+
+private:
+	// hand current buffer over to background writer
+	void flush();
+	void run();
+
+private:
+	struct Block
+	{
+		std::shared_ptr<char> m_buffer;
+		size_t m_size;
+	};
+	const std::string m_path;
+	const UploadSyncPolicy m_syncPolicy;
+	const std::function<void()> m_onDrained;
+	ACE_HANDLE m_handle;
+
+	// coalescing buffer, only accessed from reactor thread
+	std::shared_ptr<char> m_buffer;
+	size_t m_bufferSize;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::deque<Block> m_pending;
+	bool m_finished;
+	bool m_waitDrain;
+	std::atomic_bool m_failed;
+	std::unique_ptr<std::thread> m_thread;
+
+	uint64_t m_received;
+	uint64_t m_reported;
+	std::chrono::steady_clock::time_point m_startTime;
+
+	static std::atomic<uint64_t> m_activeUploads;
+	static std::atomic<uint64_t> m_totalBytes;
+	static std::atomic<uint64_t> m_lastBytesPerSecond;
+};
@@ -1,14 +1,48 @@
 #include <chrono>
+#include <cstring>
 #include <errno.h>
+#include <stdexcept>
 #include <tuple>
 
 #include <msgpack.hpp>
+#include <zstd.h>
 
+#include "../../../common/BufferPool.h"
 #include "../../../common/Utility.h"
 #include "ProtobufHelper.h"
 
+namespace
+{
+	// reference string/bin data in the frame buffer instead of copy to zone,
+	// the frame buffer outlives the unpacked object during convert
+	bool referenceFrameData(msgpack::type::object_type, std::size_t, void *)
+	{
+		return true;
+	}
+
+	// unpack zone reused by the same thread, zone.clear() keeps first chunk
+	thread_local msgpack::zone unpackZone;
+
+	// positional field, missing tail field keeps default value
+	template <typename T>
+	void convertField(const msgpack::object_array &array, uint32_t index, T &field)
+	{
+		if (index < array.size)
+			array.ptr[index].convert(field);
+	}
+
+	// get V1 positional fields, throw for unsupported schema version
+	const msgpack::object_array &positionalFields(const msgpack::object &obj)
+	{
+		const auto &array = obj.via.array;
+		if (array.size == 0 || array.ptr[0].as<int>() != static_cast<int>(WireSchema::V1))
+			throw std::invalid_argument("unsupported wire schema version");
+		return array;
+	}
+}
+
 Response::Response()
-	: http_status(0)
+	: http_status(0), stream_state(static_cast<int>(StreamState::None))
 {
 }
 
@@ -16,11 +50,85 @@ Response::~Response()
 {
 }
 
-std::shared_ptr<msgpack::sbuffer> Response::serialize() const
+std::shared_ptr<msgpack::sbuffer> Response::serialize(WireSchema schema) const
 {
 	// pack
 	auto sbuf = std::make_shared<msgpack::sbuffer>();
-	msgpack::pack(*sbuf, *this);
+	pack(*sbuf, schema);
+	return sbuf;
+}
+
+void Response::pack(msgpack::sbuffer &sbuf, WireSchema schema) const
+{
+	if (schema == WireSchema::V1)
+	{
+		msgpack::packer<msgpack::sbuffer> packer(sbuf);
+		packer.pack_array(8);
+		packer.pack(static_cast<int>(WireSchema::V1));
+		packer.pack(uuid);
+		packer.pack(request_uri);
+		packer.pack(http_status);
+		packer.pack(body_msg_type);
+		packer.pack(body);
+		packer.pack(headers);
+		packer.pack(stream_state);
+	}
+	else
+	{
+		msgpack::pack(sbuf, *this);
+	}
+}
+
+void Response::convert(const msgpack::object &obj)
+{
+	if (obj.type == msgpack::type::ARRAY)
+	{
+		const auto &fields = positionalFields(obj);
+		convertField(fields, 1, uuid);
+		convertField(fields, 2, request_uri);
+		convertField(fields, 3, http_status);
+		convertField(fields, 4, body_msg_type);
+		convertField(fields, 5, body);
+		convertField(fields, 6, headers);
+		convertField(fields, 7, stream_state);
+	}
+	else
+	{
+		obj.convert(*this);
+	}
+}
+
+std::shared_ptr<msgpack::sbuffer> Response::serializeFrame(bool compress, WireSchema schema) const
+{
+	const static char fname[] = "Response::serializeFrame() ";
+
+	// reserve header, pack body and then fill header with body length
+	auto sbuf = std::make_shared<msgpack::sbuffer>();
+	const char header[PROTOBUF_HEADER_LENGTH] = {0};
+	sbuf->write(header, PROTOBUF_HEADER_LENGTH);
+	pack(*sbuf, schema);
+	const size_t bodySize = sbuf->size() - PROTOBUF_HEADER_LENGTH;
+	if (compress && bodySize > TCP_FRAME_COMPRESS_THRESHOLD)
+	{
+		// compress to pooled buffer, keep the plain frame when compress does not help
+		const auto bound = ZSTD_compressBound(bodySize);
+		auto zbuf = BufferPool::instance().allocate(bound);
+		const auto zsize = ZSTD_compress(zbuf.get(), bound, sbuf->data() + PROTOBUF_HEADER_LENGTH, bodySize, TCP_FRAME_COMPRESS_LEVEL);
+		if (ZSTD_isError(zsize))
+		{
+			LOG_WAR << fname << "compress failed with error: " << ZSTD_getErrorName(zsize);
+		}
+		else if (zsize < bodySize)
+		{
+			const uint32_t zheader = htonl(TCP_FRAME_COMPRESSED_FLAG | zsize); // host to network byte order
+			auto frame = std::make_shared<msgpack::sbuffer>(PROTOBUF_HEADER_LENGTH + zsize);
+			frame->write((const char *)&zheader, PROTOBUF_HEADER_LENGTH);
+			frame->write(zbuf.get(), zsize);
+			LOG_DBG << fname << "compressed body from " << bodySize << " to " << zsize;
+			return frame;
+		}
+	}
+	*((uint32_t *)sbuf->data()) = htonl(bodySize); // host to network byte order
 	return sbuf;
 }
 
@@ -31,9 +139,7 @@ bool Response::deserialize(const char *data, int dataSize)
 	{
 		msgpack::unpacked result;
 		msgpack::unpack(result, data, dataSize);
-		msgpack::object obj = result.get();
-		Response resp = obj.as<Response>();
-		*this = resp;
+		this->convert(result.get());
 		return true;
 	}
 	catch (const std::exception &e)
@@ -44,6 +150,7 @@ bool Response::deserialize(const char *data, int dataSize)
 }
 
 Request::Request()
+	: deadline(0)
 {
 }
 
@@ -51,62 +158,101 @@ Request::~Request()
 {
 }
 
-std::shared_ptr<msgpack::sbuffer> Request::serialize() const
+std::shared_ptr<msgpack::sbuffer> Request::serialize(WireSchema schema) const
 {
 	// pack
 	auto sbuf = std::make_shared<msgpack::sbuffer>();
-	msgpack::pack(*sbuf, *this);
+	if (schema == WireSchema::V1)
+	{
+		msgpack::packer<msgpack::sbuffer> packer(*sbuf);
+		packer.pack_array(9);
+		packer.pack(static_cast<int>(WireSchema::V1));
+		packer.pack(uuid);
+		packer.pack(request_uri);
+		packer.pack(http_method);
+		packer.pack(client_addr);
+		packer.pack(body);
+		packer.pack(headers);
+		packer.pack(querys);
+		packer.pack(deadline);
+	}
+	else
+	{
+		msgpack::pack(*sbuf, *this);
+	}
 	return sbuf;
 }
 
+void Request::convert(const msgpack::object &obj)
+{
+	if (obj.type == msgpack::type::ARRAY)
+	{
+		const auto &fields = positionalFields(obj);
+		convertField(fields, 1, uuid);
+		convertField(fields, 2, request_uri);
+		convertField(fields, 3, http_method);
+		convertField(fields, 4, client_addr);
+		convertField(fields, 5, body);
+		convertField(fields, 6, headers);
+		convertField(fields, 7, querys);
+		convertField(fields, 8, deadline);
+	}
+	else
+	{
+		obj.convert(*this);
+	}
+}
+
 bool Request::deserialize(const char *data, int dataSize)
 {
 	const static char fname[] = "Request::deserialize() ";
+	bool result = false;
 	try
 	{
-		msgpack::unpacked result;
-		msgpack::unpack(result, data, dataSize);
-		msgpack::object obj = result.get();
-		Request rest = obj.as<Request>();
-		*this = rest;
+		// convert to this object directly, avoid temporary object and copy
+		std::size_t offset = 0;
+		msgpack::object obj = msgpack::unpack(unpackZone, data, dataSize, offset, referenceFrameData);
+		this->convert(obj);
 		// this->body = Utility::htmlEntitiesDecode(this->body);
-		return true;
+		result = true;
 	}
 	catch (const std::exception &e)
 	{
 		LOG_ERR << fname << "failed with error :" << e.what();
 	}
-	return false;
+	unpackZone.clear();
+	return result;
 }
 
-const std::tuple<std::shared_ptr<char>, int> ProtobufHelper::readMessageBlock(const ACE_SSL_SOCK_Stream &socket)
+const std::tuple<std::shared_ptr<char>, int> ProtobufHelper::decompress(const char *data, size_t dataSize)
 {
-	const static char fname[] = "ProtobufHelper::readMessageBlock() ";
-	LOG_DBG << fname << "entered";
+	const static char fname[] = "ProtobufHelper::decompress() ";
 
-	ssize_t recvReturn = 0;
-	const auto bodySize = readMsgHeader(socket, recvReturn);
-	if (bodySize <= 0)
+	const auto contentSize = ZSTD_getFrameContentSize(data, dataSize);
+	if (contentSize == ZSTD_CONTENTSIZE_ERROR || contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize == 0 || contentSize > MAX_TCP_BLOCK_SIZE)
+	{
+		LOG_ERR << fname << "invalid compressed frame with content size: " << contentSize;
+		return std::make_tuple(nullptr, 0);
+	}
+	auto buffer = BufferPool::instance().allocate(contentSize);
+	const auto size = ZSTD_decompress(buffer.get(), contentSize, data, dataSize);
+	if (ZSTD_isError(size))
 	{
-		LOG_ERR << fname << "parse header length with error :" << std::strerror(errno);
-		return std::make_tuple(nullptr, recvReturn);
+		LOG_ERR << fname << "decompress failed with error: " << ZSTD_getErrorName(size);
+		return std::make_tuple(nullptr, 0);
 	}
-	return readBytes(socket, bodySize, recvReturn);
+	return std::make_tuple(buffer, static_cast<int>(size));
 }
 
-int ProtobufHelper::readMsgHeader(const ACE_SSL_SOCK_Stream &socket, ssize_t &recvReturn)
+int ProtobufHelper::parseMsgHeader(const char *header, bool &compressed)
 {
-	const static char fname[] = "ProtobufHelper::readMsgHeader() ";
-	// read header socket data (4 bytes)
-	auto result = readBytes(socket, PROTOBUF_HEADER_LENGTH, recvReturn);
-	auto data = std::get<0>(result);
-	if (recvReturn <= 0)
-	{
-		LOG_ERR << fname << "read header length failed with error :" << std::strerror(errno);
-		return -1;
-	}
+	const static char fname[] = "ProtobufHelper::parseMsgHeader() ";
 	// parse header data (get body length). network to host byte order
-	const auto bodySize = ntohl(*((int *)(data.get()))); // host to network byte order
+	uint32_t headerValue = 0;
+	std::memcpy(&headerValue, header, PROTOBUF_HEADER_LENGTH);
+	headerValue = ntohl(headerValue);
+	compressed = (headerValue & TCP_FRAME_COMPRESSED_FLAG);
+	const auto bodySize = (headerValue & ~TCP_FRAME_COMPRESSED_FLAG);
 	LOG_DBG << fname << "read length : " << bodySize << " from header";
 	if (bodySize > MAX_TCP_BLOCK_SIZE)
 	{
@@ -115,32 +261,3 @@ int ProtobufHelper::readMsgHeader(const ACE_SSL_SOCK_Stream &socket, ssize_t &re
 	}
 	return bodySize;
 }
-
-const std::tuple<std::shared_ptr<char>, int> ProtobufHelper::readBytes(const ACE_SSL_SOCK_Stream &socket, size_t bodySize, ssize_t &recvReturn)
-{
-	const static char fname[] = "ProtobufHelper::readBytes() ";
-
-	// read socket data with given length
-	const auto bufferSize = bodySize;
-	auto bodyBuffer = make_shared_array<char>(bufferSize);
-	// https://www.demo2s.com/c/c-if-errno-eintr-fiag.html
-	// https://programmerall.com/article/5562684780/#:~:text=When%20a%20certain%20signal%20is%20caught%2C%20the%20system,system%20calls%20that%20may%20block%20the%20process%20forever.
-	errno = 0;
-	size_t totalRecieved = 0;
-	recvReturn = socket.recv_n(bodyBuffer.get(), bufferSize, 0, &totalRecieved);
-	while (totalRecieved < bufferSize && errno == EINTR)
-	{
-		size_t transfered = 0;
-		recvReturn = socket.recv_n(bodyBuffer.get() + totalRecieved, bufferSize - totalRecieved, 0, &transfered);
-		totalRecieved += transfered;
-	}
-	if (bufferSize == totalRecieved)
-		recvReturn = totalRecieved;
-	if (socket.get_handle() != ACE_INVALID_HANDLE && recvReturn <= 0)
-	{
-		LOG_ERR << fname << "read body socket data failed with error: " << std::strerror(errno);
-		return std::make_tuple(nullptr, recvReturn);
-	}
-	LOG_DBG << fname << "read message block data with length: " << bufferSize;
-	return std::make_tuple(bodyBuffer, recvReturn);
-}
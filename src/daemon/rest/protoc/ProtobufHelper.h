@@ -1,17 +1,54 @@
 #pragma once
 #include <tuple>
 
+#include <ace/LSOCK_Stream.h>
 #include <ace/SSL/SSL_SOCK_Stream.h>
 #include <msgpack.hpp>
 
+/// <summary>
+/// Wire schema of Request and Response body.
+/// Map: msgpack map with field names, compatible with all clients.
+/// V1: msgpack array, first element is schema version and fields follow in fixed order,
+///     new fields are only appended so that a decoder ignores unknown tail and defaults missing tail.
+/// Decoder detect schema from the msgpack type, encoder use V1 only after peer announced it
+/// with HTTP_HEADER_KEY_wire_schema.
+/// </summary>
+enum class WireSchema : int
+{
+	Map = 0,
+	V1 = 1
+};
+
+/// <summary>
+/// Response stream state, a streamed response is a sequence of frames with the same uuid.
+/// None: complete response in one frame.
+/// Chunk: one ordered body chunk, status and headers are carried by the first chunk.
+/// End: end of stream marker, body is the last (can be empty) chunk.
+/// Server only stream to a peer announced it with HTTP_HEADER_KEY_response_stream.
+/// </summary>
+enum class StreamState : int
+{
+	None = 0,
+	Chunk = 1,
+	End = 2
+};
+
 class Response
 {
 public:
 	Response();
 	virtual ~Response();
-	std::shared_ptr<msgpack::sbuffer> serialize() const;
+	std::shared_ptr<msgpack::sbuffer> serialize(WireSchema schema = WireSchema::Map) const;
+	/// @brief Serialize with 4 bytes (network order) length header ahead, so header and body can be sent with one write
+	/// @param compress compress body with zstd when it is larger than TCP_FRAME_COMPRESS_THRESHOLD, the header is flagged with TCP_FRAME_COMPRESSED_FLAG
+	/// @param schema wire schema of body
+	std::shared_ptr<msgpack::sbuffer> serializeFrame(bool compress = false, WireSchema schema = WireSchema::Map) const;
 	bool deserialize(const char *data, int dataSize);
 
+private:
+	void pack(msgpack::sbuffer &sbuf, WireSchema schema) const;
+	void convert(const msgpack::object &obj);
+
 public:
 	std::string uuid;
 	std::string request_uri;
@@ -19,8 +56,10 @@ public:
 	std::string body_msg_type;
 	std::string body;
 	std::map<std::string, std::string> headers;
+	int stream_state; // StreamState
 
-	MSGPACK_DEFINE_MAP(uuid, request_uri, http_status, body_msg_type, body, headers);
+	// field order of V1 schema is the same
+	MSGPACK_DEFINE_MAP(uuid, request_uri, http_status, body_msg_type, body, headers, stream_state);
 };
 
 class Request
@@ -28,9 +67,12 @@ class Request
 public:
 	Request();
 	virtual ~Request();
-	std::shared_ptr<msgpack::sbuffer> serialize() const;
+	std::shared_ptr<msgpack::sbuffer> serialize(WireSchema schema = WireSchema::Map) const;
 	bool deserialize(const char *data, int dataSize);
 
+private:
+	void convert(const msgpack::object &obj);
+
 public:
 	std::string uuid;
 	std::string request_uri;
@@ -39,8 +81,10 @@ public:
 	std::string body;
 	std::map<std::string, std::string> headers;
 	std::map<std::string, std::string> querys;
+	int64_t deadline; // absolute deadline in epoch milliseconds, 0 means no deadline
 
-	MSGPACK_DEFINE_MAP(uuid, request_uri, http_method, http_method, client_addr, body, headers, querys);
+	// field order of V1 schema is the same
+	MSGPACK_DEFINE_MAP(uuid, request_uri, http_method, client_addr, body, headers, querys, deadline);
 };
 
 /// <summary>
@@ -52,23 +96,16 @@ public:
 	ProtobufHelper();
 	virtual ~ProtobufHelper();
 
-	/// @brief Read a message block from socket (include header and body).
-	/// @param socket ACE_SSL_SOCK_Stream used to receive data
-	/// @return char *: The complete data buffer according to a Protocbuf message
-	/// @return int: the message data size
-	static const std::tuple<std::shared_ptr<char>, int> readMessageBlock(const ACE_SSL_SOCK_Stream &socket);
-
-	/// @brief Read 4 bytes int (network order) for below message size
-	/// @param socket ACE_SSL_SOCK_Stream used to receive data
-	/// @param recvReturn
-	/// @return int value for the header, less than 1 means read failed
-	static int readMsgHeader(const ACE_SSL_SOCK_Stream &socket, ssize_t &recvReturn);
+	/// @brief Parse 4 bytes int (network order) frame header
+	/// @param header PROTOBUF_HEADER_LENGTH bytes received from socket
+	/// @param compressed output whether the following body is compressed
+	/// @return body size, less than 0 means the size exceeds MAX_TCP_BLOCK_SIZE
+	static int parseMsgHeader(const char *header, bool &compressed);
 
-	/// @brief Read message from socket
-	/// @param socket ACE_SSL_SOCK_Stream used to receive data
-	/// @param bodySize message size used to read from socket
-	/// @param recvReturn socket return code
-	/// @return char *: message data
-	/// @return int: the message data size
-	static const std::tuple<std::shared_ptr<char>, int> readBytes(const ACE_SSL_SOCK_Stream &socket, size_t bodySize, ssize_t &recvReturn);
+	/// @brief Decompress a zstd compressed message body
+	/// @param data compressed data
+	/// @param dataSize compressed data size
+	/// @return char *: decompressed data, nullptr when failed
+	/// @return int: decompressed data size
+	static const std::tuple<std::shared_ptr<char>, int> decompress(const char *data, size_t dataSize);
 };
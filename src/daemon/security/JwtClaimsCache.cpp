@@ -0,0 +1,128 @@
+#include <cryptopp/sha.h>
+
+#include "../../common/Utility.h"
+#include "JwtClaimsCache.h"
+
+JwtClaimsCache::JwtClaimsCache()
+	: m_capacity(MAX_JWT_CLAIMS_CACHE_SIZE), m_generation(0)
+{
+}
+
+JwtClaimsCache::~JwtClaimsCache()
+{
+}
+
+bool JwtClaimsCache::get(const std::string &token, JwtClaims &claims)
+{
+	const auto key = digest(token);
+	std::lock_guard<std::mutex> guard(m_mutex);
+	const auto iter = m_index.find(key);
+	if (iter == m_index.end())
+	{
+		return false;
+	}
+	if (iter->second->second.m_expiry <= std::chrono::system_clock::now())
+	{
+		// let caller verify again and report expiry
+		m_lru.erase(iter->second);
+		m_index.erase(iter);
+		return false;
+	}
+	m_lru.splice(m_lru.begin(), m_lru, iter->second);
+	claims = iter->second->second;
+	return true;
+}
+
+void JwtClaimsCache::put(const std::string &token, const JwtClaims &claims, uint64_t generation)
+{
+	const auto key = digest(token);
+	std::lock_guard<std::mutex> guard(m_mutex);
+	if (generation != m_generation)
+	{
+		// invalidated during verification, token or user state may be stale
+		return;
+	}
+	const auto iter = m_index.find(key);
+	if (iter != m_index.end())
+	{
+		iter->second->second = claims;
+		m_lru.splice(m_lru.begin(), m_lru, iter->second);
+		return;
+	}
+	if (m_lru.size() >= m_capacity)
+	{
+		m_index.erase(m_lru.back().first);
+		m_lru.pop_back();
+	}
+	m_lru.emplace_front(key, claims);
+	m_index[key] = m_lru.begin();
+}
+
+uint64_t JwtClaimsCache::generation() const
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return m_generation;
+}
+
+void JwtClaimsCache::remove(const std::string &token)
+{
+	const auto key = digest(token);
+	std::lock_guard<std::mutex> guard(m_mutex);
+	++m_generation;
+	const auto iter = m_index.find(key);
+	if (iter != m_index.end())
+	{
+		m_lru.erase(iter->second);
+		m_index.erase(iter);
+	}
+}
+
+void JwtClaimsCache::removeUser(const std::string &userName)
+{
+	const static char fname[] = "JwtClaimsCache::removeUser() ";
+
+	std::lock_guard<std::mutex> guard(m_mutex);
+	++m_generation;
+	size_t removed = 0;
+	for (auto iter = m_lru.begin(); iter != m_lru.end();)
+	{
+		if (iter->second.m_userName == userName)
+		{
+			m_index.erase(iter->first);
+			iter = m_lru.erase(iter);
+			++removed;
+		}
+		else
+		{
+			++iter;
+		}
+	}
+	if (removed)
+	{
+		LOG_DBG << fname << "removed <" << removed << "> cached tokens of user <" << userName << ">";
+	}
+}
+
+void JwtClaimsCache::clear()
+{
+	const static char fname[] = "JwtClaimsCache::clear() ";
+
+	std::lock_guard<std::mutex> guard(m_mutex);
+	++m_generation;
+	m_index.clear();
+	m_lru.clear();
+	LOG_DBG << fname << "all cached tokens removed";
+}
+
+size_t JwtClaimsCache::size() const
+{
+	std::lock_guard<std::mutex> guard(m_mutex);
+	return m_lru.size();
+}
+
+std::string JwtClaimsCache::digest(const std::string &token)
+{
+	std::string result(CryptoPP::SHA256::DIGESTSIZE, '\0');
+	CryptoPP::SHA256().CalculateDigest(reinterpret_cast<CryptoPP::byte *>(&result[0]), reinterpret_cast<const CryptoPP::byte *>(token.data()), token.size());
+	return result;
+}
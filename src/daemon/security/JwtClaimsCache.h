@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <ace/Null_Mutex.h>
+#include <ace/Singleton.h>
+
+/// <summary>
+/// Claims of a verified JWT token
+/// </summary>
+struct JwtClaims
+{
+	std::string m_userName;
+	std::string m_userGroup;
+	std::chrono::system_clock::time_point m_expiry;
+};
+
+/// <summary>
+/// Bounded LRU cache of verified JWT claims keyed by SHA-256 digest of token,
+/// avoid decode and HS256 verify for repeated requests with the same token.
+/// Entries are invalidated when token is blacklisted, user is locked, deleted or
+/// changed password, and all entries are dropped when JWT salt or security changed.
+/// Every invalidation advances generation, a put carrying an older generation is dropped,
+/// so a token verified before the invalidation is never cached after it.
+/// </summary>
+class JwtClaimsCache
+{
+public:
+	JwtClaimsCache();
+	virtual ~JwtClaimsCache();
+
+	/// <summary>
+	/// Get claims of a verified token
+	/// </summary>
+	/// <returns>false when not cached or expired</returns>
+	bool get(const std::string &token, JwtClaims &claims);
+	/// <summary>
+	/// Cache claims of a verified token
+	/// </summary>
+	/// <param name="generation">generation() read before token verification started</param>
+	void put(const std::string &token, const JwtClaims &claims, uint64_t generation);
+	uint64_t generation() const;
+
+	void remove(const std::string &token);
+	void removeUser(const std::string &userName);
+	void clear();
+	size_t size() const;
+
+private:
+	static std::string digest(const std::string &token);
+
+private:
+	typedef std::list<std::pair<std::string, JwtClaims>> LruList;
+	mutable std::mutex m_mutex;
+	// most recently used at front
+	LruList m_lru;
+	std::unordered_map<std::string, LruList::iterator> m_index;
+	const size_t m_capacity;
+	uint64_t m_generation;
+};
+
+typedef ACE_Singleton<JwtClaimsCache, ACE_Null_Mutex> JWT_CLAIMS_CACHE;
@@ -6,10 +6,12 @@
 #include "../../common/Utility.h"
 #include "../Configuration.h"
 #include "./ldapplugin/LdapImpl.h"
+#include "JwtClaimsCache.h"
 #include "Security.h"
 
 std::shared_ptr<Security> Security::m_instance = nullptr;
 std::recursive_mutex Security::m_mutex;
+std::shared_ptr<const SecuritySnapshot> Security::m_snapshot = nullptr;
 Security::Security(std::shared_ptr<JsonSecurity> jsonSecurity)
     : m_securityConfig(jsonSecurity)
 {
@@ -50,6 +52,40 @@ void Security::instance(std::shared_ptr<Security> instance)
 {
     std::lock_guard<std::recursive_mutex> guard(m_mutex);
     m_instance = instance;
+    std::atomic_store(&m_snapshot, std::shared_ptr<const SecuritySnapshot>(instance ? instance->buildSnapshot() : nullptr));
+    // users may be removed or locked by new security
+    JWT_CLAIMS_CACHE::instance()->clear();
+}
+
+std::shared_ptr<const SecuritySnapshot> Security::snapshot()
+{
+    return std::atomic_load(&m_snapshot);
+}
+
+std::shared_ptr<SecuritySnapshot> Security::buildSnapshot()
+{
+    auto snapshot = std::make_shared<SecuritySnapshot>(false);
+    for (const auto &user : m_securityConfig->m_users->getUsers())
+    {
+        for (const auto &role : user.second->getRoles())
+        {
+            snapshot->grant(user.first, role->getPermissions());
+        }
+    }
+    return snapshot;
+}
+
+void Security::publishSnapshot()
+{
+    const static char fname[] = "Security::publishSnapshot() ";
+
+    std::lock_guard<std::recursive_mutex> guard(m_mutex);
+    if (m_instance.get() == this)
+    {
+        const auto snapshot = buildSnapshot();
+        LOG_DBG << fname << "subjects: " << snapshot->subjectCount() << " permissions: " << snapshot->permissionCount();
+        std::atomic_store(&m_snapshot, std::shared_ptr<const SecuritySnapshot>(snapshot));
+    }
 }
 
 bool Security::encryptKey()
@@ -186,22 +222,27 @@ nlohmann::json Security::getRolesJson() const
 
 std::shared_ptr<User> Security::addUser(const std::string &userName, const nlohmann::json &userJson)
 {
-    return m_securityConfig->m_users->addUser(userName, userJson, m_securityConfig->m_roles);
+    auto user = m_securityConfig->m_users->addUser(userName, userJson, m_securityConfig->m_roles);
+    publishSnapshot();
+    return user;
 }
 
 void Security::delUser(const std::string &name)
 {
     m_securityConfig->m_users->delUser(name);
+    publishSnapshot();
 }
 
 void Security::addRole(const nlohmann::json &obj, std::string name)
 {
     m_securityConfig->m_roles->addRole(obj, name);
+    publishSnapshot();
 }
 
 void Security::delRole(const std::string &name)
 {
     m_securityConfig->m_roles->delRole(name);
+    publishSnapshot();
 }
 
 std::set<std::string> Security::getAllUserGroups() const
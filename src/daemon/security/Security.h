@@ -7,6 +7,7 @@
 
 #include <nlohmann/json.hpp>
 
+#include "SecuritySnapshot.h"
 #include "User.h"
 
 //////////////////////////////////////////////////////////////////////////
@@ -26,6 +27,10 @@ public:
     static void init(const std::string &interface);
     static std::shared_ptr<Security> instance();
     static void instance(std::shared_ptr<Security> instance);
+    /// <summary>
+    /// Authorization snapshot of current security, read without Security lock
+    /// </summary>
+    static std::shared_ptr<const SecuritySnapshot> snapshot();
 
 public:
     virtual bool verifyUserKey(const std::string &userName, const std::string &userKey);
@@ -45,8 +50,19 @@ public:
     virtual std::set<std::string> getUserPermissions(const std::string &userName, const std::string &userGroup);
     virtual std::set<std::string> getAllPermissions();
 
+protected:
+    /// <summary>
+    /// Build permission snapshot from current users and roles
+    /// </summary>
+    virtual std::shared_ptr<SecuritySnapshot> buildSnapshot();
+    /// <summary>
+    /// Rebuild and publish snapshot after users or roles changed, only for the current security
+    /// </summary>
+    void publishSnapshot();
+
 private:
     std::shared_ptr<JsonSecurity> m_securityConfig;
     static std::shared_ptr<Security> m_instance;
+    static std::shared_ptr<const SecuritySnapshot> m_snapshot;
     static std::recursive_mutex m_mutex;
 };
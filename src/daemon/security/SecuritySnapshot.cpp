@@ -0,0 +1,53 @@
+#include "SecuritySnapshot.h"
+#include "../../common/Utility.h"
+
+SecuritySnapshot::SecuritySnapshot(bool keyByGroup)
+	: m_keyByGroup(keyByGroup)
+{
+}
+
+SecuritySnapshot::~SecuritySnapshot()
+{
+}
+
+void SecuritySnapshot::grant(const std::string &subject, const std::set<std::string> &permissions)
+{
+	const static char fname[] = "SecuritySnapshot::grant() ";
+
+	auto &bits = m_subjects[subject];
+	for (const auto &permission : permissions)
+	{
+		auto id = m_permissionIds.find(permission);
+		if (id == m_permissionIds.end())
+		{
+			if (m_permissionIds.size() >= MAX_PERMISSION_NUM)
+			{
+				LOG_ERR << fname << "permission number exceed " << MAX_PERMISSION_NUM << ", ignore permission " << permission;
+				continue;
+			}
+			id = m_permissionIds.emplace(permission, m_permissionIds.size()).first;
+		}
+		bits.set(id->second);
+	}
+}
+
+bool SecuritySnapshot::hasPermission(const std::string &userName, const std::string &userGroup, const std::string &permission) const
+{
+	const auto id = m_permissionIds.find(permission);
+	if (id == m_permissionIds.end())
+	{
+		return false;
+	}
+	const auto subject = m_subjects.find(m_keyByGroup ? userGroup : userName);
+	return subject != m_subjects.end() && subject->second.test(id->second);
+}
+
+size_t SecuritySnapshot::permissionCount() const
+{
+	return m_permissionIds.size();
+}
+
+size_t SecuritySnapshot::subjectCount() const
+{
+	return m_subjects.size();
+}
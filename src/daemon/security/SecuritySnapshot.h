@@ -0,0 +1,44 @@
+#pragma once
+
+#include <bitset>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+constexpr size_t MAX_PERMISSION_NUM = 256;
+typedef std::bitset<MAX_PERMISSION_NUM> PermissionBits;
+
+/// <summary>
+/// Immutable authorization state built from Security users and roles.
+/// Permission names are interned to bit index once when snapshot is built, each
+/// subject (user name, or group name for LDAP) carries a precomputed permission bitset.
+/// A published snapshot is never changed, a security change builds and swaps a new one,
+/// so permission check reads it without lock and without allocation.
+/// </summary>
+class SecuritySnapshot
+{
+public:
+	/// <param name="keyByGroup">subjects are user groups (LDAP) instead of user names</param>
+	explicit SecuritySnapshot(bool keyByGroup);
+	virtual ~SecuritySnapshot();
+
+	/// <summary>
+	/// Grant permissions to subject, only used before snapshot is published
+	/// </summary>
+	void grant(const std::string &subject, const std::set<std::string> &permissions);
+
+	/// <summary>
+	/// Authorization hot path
+	/// </summary>
+	/// <returns>false for unknown user, group or permission</returns>
+	bool hasPermission(const std::string &userName, const std::string &userGroup, const std::string &permission) const;
+
+	size_t permissionCount() const;
+	size_t subjectCount() const;
+
+private:
+	const bool m_keyByGroup;
+	std::unordered_map<std::string, size_t> m_permissionIds;
+	std::unordered_map<std::string, PermissionBits> m_subjects;
+};
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "../../common/Utility.h"
+#include "JwtClaimsCache.h"
 #include "TokenBlacklist.h"
 
 constexpr int MAX_BLACK_LIST_SIZE = 10240;
@@ -31,6 +32,7 @@ void TokenBlacklist::addToken(const std::string &token, const std::chrono::syste
     }
     // m_tokenSet.emplace(token, expiryTime);
     m_tokenSet[token] = expiryTime;
+    JWT_CLAIMS_CACHE::instance()->remove(token);
     LOG_INF << fname << "token black list size: " << m_tokenSet.size();
 }
 
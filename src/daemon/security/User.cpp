@@ -5,6 +5,7 @@
 
 #include "../../common/Utility.h"
 #include "../Configuration.h"
+#include "JwtClaimsCache.h"
 #include "Security.h"
 #include "User.h"
 
@@ -118,6 +119,7 @@ void Users::delUser(const std::string &name)
 	std::lock_guard<std::recursive_mutex> guard(m_mutex);
 	getUser(name);
 	m_users.erase(name);
+	JWT_CLAIMS_CACHE::instance()->removeUser(name);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -192,6 +194,7 @@ std::shared_ptr<User> User::FromJson(const std::string &userName, const nlohmann
 void User::lock()
 {
 	this->m_locked = true;
+	JWT_CLAIMS_CACHE::instance()->removeUser(getName());
 }
 
 void User::unlock()
@@ -211,6 +214,8 @@ void User::updateUser(std::shared_ptr<User> user)
 	this->m_locked = user->m_locked;
 	this->m_enableMfa = user->m_enableMfa;
 	this->m_email = user->m_email;
+	if (this->m_locked)
+		JWT_CLAIMS_CACHE::instance()->removeUser(m_name);
 }
 
 void User::updateKey(const std::string &passwd)
@@ -224,6 +229,7 @@ void User::updateKey(const std::string &passwd)
 	{
 		m_key = passwd;
 	}
+	JWT_CLAIMS_CACHE::instance()->removeUser(m_name);
 }
 
 void User::totpActive(bool active)
@@ -83,6 +83,20 @@ std::set<std::string> LdapImpl::getUserPermissions(const std::string &userName,
     return permissionSet;
 }
 
+std::shared_ptr<SecuritySnapshot> LdapImpl::buildSnapshot()
+{
+    // LDAP permission is granted by group roles
+    auto snapshot = std::make_shared<SecuritySnapshot>(true);
+    for (const auto &group : m_ldap->m_groups->getGroups())
+    {
+        for (const auto &role : group.second->m_roles)
+        {
+            snapshot->grant(group.first, role->getPermissions());
+        }
+    }
+    return snapshot;
+}
+
 std::shared_ptr<Ldap::Server> LdapImpl::connect()
 {
     const static char fname[] = "LdapImpl::connect() ";
@@ -138,6 +152,7 @@ void LdapImpl::syncGroupUsers()
     {
         LOG_WAR << fname << ex.what();
     }
+    publishSnapshot();
 
     if (m_syncTimerId == INVALID_TIMER_ID && m_ldap->m_syncSeconds > 0)
     {
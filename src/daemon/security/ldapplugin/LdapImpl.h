@@ -53,6 +53,9 @@ public:
     virtual std::set<std::string> getUserPermissions(const std::string &userName, const std::string &userGroup) override;
     virtual std::set<std::string> getAllPermissions() override;
 
+protected:
+    virtual std::shared_ptr<SecuritySnapshot> buildSnapshot() override;
+
 private:
     std::shared_ptr<Ldap::Server> connect();
 
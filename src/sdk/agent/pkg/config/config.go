@@ -26,6 +26,7 @@ type (
 		RestListenAddress            string `yaml:"RestListenAddress"`
 		RestListenPort               int    `yaml:"RestListenPort"`
 		RestTcpPort                  int    `yaml:"RestTcpPort"`
+		RestUnixSocket               string `yaml:"RestUnixSocket"`
 		PrometheusExporterListenPort int    `yaml:"PrometheusExporterListenPort"`
 
 		SSL SSLConfig `yaml:"SSL"`
@@ -16,6 +16,7 @@ import (
 	"strings"
 	"sync"
 	"syscall"
+	"time"
 
 	"github.com/buaazp/fasthttprouter"
 	"github.com/laoshanxi/app-mesh/src/sdk/agent/pkg/config"
@@ -25,17 +26,26 @@ import (
 )
 
 const (
-	REST_PATH_UPLOAD            = "/appmesh/file/upload"
-	REST_PATH_DOWNLOAD          = "/appmesh/file/download"
-	REST_PATH_FILE              = "/appmesh/file/"
-	HTTP_USER_AGENT_HEADER_NAME = "User-Agent"
-	HTTP_USER_AGENT             = "appmeshsdk"
+	REST_PATH_UPLOAD                   = "/appmesh/file/upload"
+	REST_PATH_DOWNLOAD                 = "/appmesh/file/download"
+	REST_PATH_FILE                     = "/appmesh/file/"
+	HTTP_USER_AGENT_HEADER_NAME        = "User-Agent"
+	HTTP_USER_AGENT                    = "appmeshsdk"
+	HTTP_REQUEST_TIMEOUT_HEADER_NAME   = "X-Request-Timeout"
+	HTTP_FRAME_COMPRESSION_HEADER_NAME = "X-Frame-Compression"
+	HTTP_FRAME_COMPRESSION_ZSTD        = "zstd"
+	HTTP_WIRE_SCHEMA_HEADER_NAME       = "X-Wire-Schema"
+	HTTP_RESPONSE_STREAM_HEADER_NAME   = "X-Response-Stream"
+	RESPONSE_STREAM_CHANNEL_SIZE       = 16               // chunks buffered between socket reader and HTTP writer
+	RESPONSE_STREAM_SEND_TIMEOUT       = 30 * time.Second // abandon a stream when a chunk is not passed on in time
 )
 
 var (
 	tcpConnect  net.Conn   // tcp connection to the server
 	socketMutex sync.Mutex // tcp connection lock
-	requestMap  sync.Map   // request map cache for asyncrized response
+	requestMap  sync.Map   // request map cache for asyncrized response, value is *responseStream
+
+	tlsSessionCache = tls.NewLRUClientSessionCache(8) // TLS session cache for resumption
 )
 
 // https://www.jianshu.com/p/dce19fb167f4
@@ -65,10 +75,18 @@ func connectServer(tcpAddr string) (net.Conn, error) {
 
 		// verify client
 		Certificates: []tls.Certificate{clientCA},
+
+		// resume TLS session when reconnect to server
+		ClientSessionCache: tlsSessionCache,
 	}
 	return tls.Dial("tcp", tcpAddr, conf)
 }
 
+// connect to local Unix domain socket of App Mesh, same framing as TCP without TLS
+func connectUnixServer(socketPath string) (net.Conn, error) {
+	return net.Dial("unix", socketPath)
+}
+
 func readMsgLoop() {
 	for {
 		// read response from server
@@ -77,17 +95,60 @@ func readMsgLoop() {
 			log.Fatalf("Failed read response: %v", err)
 		}
 
-		// forward to channel and release map
-		if t, ok := requestMap.LoadAndDelete(response.Uuid); !ok {
-			log.Fatalf("Not found request ID <%s> for Response", response.Uuid)
+		// forward to channel, release map unless more chunks of a stream follow
+		var t interface{}
+		var ok bool
+		if response.StreamState == STREAM_STATE_CHUNK {
+			t, ok = requestMap.Load(response.Uuid)
 		} else {
-			// notify
-			ch, _ := t.(chan *Response)
-			ch <- response
+			t, ok = requestMap.LoadAndDelete(response.Uuid)
+		}
+		if !ok {
+			// request already timed out and removed
+			log.Printf("Not found request ID <%s> for Response", response.Uuid)
+			continue
+		}
+		// closed channel tells the stream writer to abort the client connection
+		stream, _ := t.(*responseStream)
+		if !stream.send(response) {
+			requestMap.Delete(response.Uuid)
+			close(stream.ch)
+			log.Printf("Abandon stream response <%s> for slow or gone client", response.Uuid)
 		}
 	}
 }
 
+// responseStream pass responses of one request from socket reader to HTTP handler
+type responseStream struct {
+	ch   chan *Response
+	done chan struct{} // closed when HTTP handler stop receiving
+}
+
+func newResponseStream() *responseStream {
+	// buffered so reader never blocks on a single response and stream chunks are read ahead of HTTP write
+	return &responseStream{ch: make(chan *Response, RESPONSE_STREAM_CHANNEL_SIZE), done: make(chan struct{})}
+}
+
+// send wait for a slow stream reader instead of dropping a chunk, responses of all requests
+// share the reader loop so the wait is bounded, return false when reader is gone or timed out
+func (s *responseStream) send(response *Response) bool {
+	select {
+	case s.ch <- response:
+		return true
+	default:
+	}
+	timer := time.NewTimer(RESPONSE_STREAM_SEND_TIMEOUT)
+	defer timer.Stop()
+	select {
+	case s.ch <- response:
+		return true
+	case <-s.done:
+		return false
+	case <-timer.C:
+		return false
+	}
+}
+
 // Disable Nagle's algorithm on both sides if you're sending small, frequent messages.
 func setNoDelay(conn net.Conn) {
 	if tcpConn, ok := conn.(*net.TCPConn); ok {
@@ -104,11 +165,20 @@ func setNoDelay(conn net.Conn) {
 func ListenRest() {
 	listenAddr := config.ConfigData.REST.RestListenAddress + ":" + strconv.Itoa(config.ConfigData.REST.RestListenPort)
 	connectAddr := config.ConfigData.REST.RestListenAddress + ":" + strconv.Itoa(config.ConfigData.REST.RestTcpPort)
-	// connect to TCP rest server
-	conn, err := connectServer(strings.Replace(connectAddr, "0.0.0.0", "127.0.0.1", 1))
-	if err != nil {
-		log.Fatalf("Failed to connected to TCP server <%s> with error: %v", connectAddr, err)
-		os.Exit(-1)
+	// prefer local Unix domain socket, fallback to TCP rest server
+	var conn net.Conn
+	var err error
+	if socketPath := config.ConfigData.REST.RestUnixSocket; socketPath != "" && utils.IsFileExist(socketPath) {
+		if conn, err = connectUnixServer(socketPath); err != nil {
+			log.Printf("Failed to connected to Unix socket <%s> with error: %v, fallback to TCP", socketPath, err)
+		}
+	}
+	if conn == nil {
+		conn, err = connectServer(strings.Replace(connectAddr, "0.0.0.0", "127.0.0.1", 1))
+		if err != nil {
+			log.Fatalf("Failed to connected to TCP server <%s> with error: %v", connectAddr, err)
+			os.Exit(-1)
+		}
 	}
 	tcpConnect = conn
 	setNoDelay(tcpConnect)
@@ -285,8 +355,8 @@ func handleAppmeshRest(ctx *fasthttp.RequestCtx) {
 	ctx.Logger().Printf("Requesting: %s with msg length: %d", request.Uuid, len(bodyData))
 
 	// create a chan for accept Response
-	ch := make(chan *Response)
-	requestMap.Store(request.Uuid, ch)
+	stream := newResponseStream()
+	requestMap.Store(request.Uuid, stream)
 
 	var sendErr error
 	// send header and body to app mesh server
@@ -299,9 +369,26 @@ func handleAppmeshRest(ctx *fasthttp.RequestCtx) {
 	}
 	if sendErr == nil {
 		// wait chan to get response
-		protocResponse := <-ch
-		// reply to client
-		convertResponseToHttp(ctx, protocResponse)
+		var timeoutCh <-chan time.Time
+		if request.Deadline > 0 {
+			timer := time.NewTimer(time.Until(time.UnixMilli(request.Deadline)))
+			defer timer.Stop()
+			timeoutCh = timer.C
+		}
+		select {
+		case protocResponse := <-stream.ch:
+			// reply to client
+			if protocResponse.StreamState == STREAM_STATE_CHUNK {
+				convertStreamResponseToHttp(ctx, protocResponse, stream)
+			} else {
+				convertResponseToHttp(ctx, protocResponse)
+			}
+		case <-timeoutCh:
+			requestMap.Delete(request.Uuid)
+			close(stream.done)
+			ctx.Logger().Printf("Request %s timed out", request.Uuid)
+			ctx.SetStatusCode(fasthttp.StatusGatewayTimeout)
+		}
 	} else {
 		ctx.Logger().Printf("Failed to send request to server with error:: %v", sendErr)
 		log.Fatal(sendErr)
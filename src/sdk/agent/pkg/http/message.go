@@ -1,19 +1,42 @@
 package http
 
 import (
+	"bufio"
+	"bytes"
 	"encoding/binary"
+	"fmt"
 	"html"
+	"log"
 	"net"
+	"strconv"
 	"strings"
+	"sync/atomic"
+	"time"
 
+	"github.com/klauspost/compress/zstd"
 	"github.com/rs/xid"
 	"github.com/valyala/fasthttp"
 	"github.com/vmihailenco/msgpack/v5"
+	"github.com/vmihailenco/msgpack/v5/msgpcode"
 )
 
 const (
 	TCP_CHUNK_READ_BLOCK_SIZE = 2048
 	PROTOBUF_HEADER_LENGTH    = 4
+	TCP_FRAME_COMPRESSED_FLAG = 0x80000000 // highest bit of length header marks zstd compressed body
+	WIRE_SCHEMA_V1            = 1          // positional (msgpack array) schema, first element is version
+
+	// Response stream state, a streamed response is chunk frames with the same uuid and an end frame
+	STREAM_STATE_NONE  = 0 // complete response in one frame
+	STREAM_STATE_CHUNK = 1 // one body chunk, the first chunk carry status and headers
+	STREAM_STATE_END   = 2 // end of stream, body is the last chunk
+)
+
+var (
+	// zstd decoder is safe for concurrent DecodeAll
+	frameDecoder, _ = zstd.NewReader(nil)
+	// server answered with V1 schema, send V1 requests from now on
+	wireSchemaV1 atomic.Bool
 )
 
 type ResponseMessage struct {
@@ -27,6 +50,7 @@ type Response struct {
 	BodyMsgType string            `msg:"body_msg_type" msgpack:"body_msg_type"`
 	Body        string            `msg:"body" msgpack:"body"`
 	Headers     map[string]string `msg:"headers" msgpack:"headers"`
+	StreamState int               `msg:"stream_state" msgpack:"stream_state"`
 }
 
 type Request struct {
@@ -37,6 +61,7 @@ type Request struct {
 	Body          string            `msg:"body" msgpack:"body"`
 	Headers       map[string]string `msg:"headers" msgpack:"headers"`
 	Querys        map[string]string `msg:"querys" msgpack:"querys"`
+	Deadline      int64             `msg:"deadline" msgpack:"deadline,omitempty"` // absolute deadline in epoch milliseconds
 }
 
 func blockRead(conn net.Conn, msgLength uint32) ([]byte, error) {
@@ -92,15 +117,73 @@ func (r *Response) readResponse(conn net.Conn) error {
 		return err
 	}
 	// read body
-	bodyBuf, err := blockRead(conn, binary.BigEndian.Uint32(headerBuf))
+	header := binary.BigEndian.Uint32(headerBuf)
+	bodyBuf, err := blockRead(conn, header&^TCP_FRAME_COMPRESSED_FLAG)
+	if err != nil {
+		return err
+	}
+	if header&TCP_FRAME_COMPRESSED_FLAG != 0 {
+		if bodyBuf, err = frameDecoder.DecodeAll(bodyBuf, nil); err != nil {
+			return err
+		}
+	}
+	return r.unmarshal(bodyBuf)
+}
+
+// unmarshal detect wire schema by msgpack type: map for field names, array for V1 positional fields
+func (r *Response) unmarshal(data []byte) error {
+	if len(data) == 0 || !(msgpcode.IsFixedArray(data[0]) || data[0] == msgpcode.Array16 || data[0] == msgpcode.Array32) {
+		return msgpack.Unmarshal(data, r)
+	}
+	dec := msgpack.NewDecoder(bytes.NewReader(data))
+	length, err := dec.DecodeArrayLen()
 	if err != nil {
 		return err
 	}
-	return msgpack.Unmarshal(bodyBuf, r)
+	if version, err := dec.DecodeInt(); err != nil || version != WIRE_SCHEMA_V1 {
+		return fmt.Errorf("unsupported wire schema version %d: %v", version, err)
+	}
+	// missing tail fields keep zero value, unknown tail fields are skipped
+	fields := []interface{}{&r.Uuid, &r.RequestUri, &r.HttpStatus, &r.BodyMsgType, &r.Body, &r.Headers, &r.StreamState}
+	for i := 1; i < length; i++ {
+		if i <= len(fields) {
+			err = dec.Decode(fields[i-1])
+		} else {
+			err = dec.Skip()
+		}
+		if err != nil {
+			return err
+		}
+	}
+	wireSchemaV1.Store(true)
+	return nil
 }
 
 func (r *Request) serialize() ([]byte, error) {
-	return msgpack.Marshal(*r)
+	if !wireSchemaV1.Load() {
+		return msgpack.Marshal(*r)
+	}
+	// V1 positional fields, same order as Request struct
+	var buf bytes.Buffer
+	enc := msgpack.NewEncoder(&buf)
+	err := enc.EncodeArrayLen(9)
+	if err == nil {
+		err = enc.EncodeInt(WIRE_SCHEMA_V1)
+	}
+	for _, field := range []string{r.Uuid, r.RequestUri, r.HttpMethod, r.ClientAddress, r.Body} {
+		if err == nil {
+			err = enc.EncodeString(field)
+		}
+	}
+	for _, field := range []map[string]string{r.Headers, r.Querys} {
+		if err == nil {
+			err = enc.Encode(field)
+		}
+	}
+	if err == nil {
+		err = enc.EncodeInt(r.Deadline)
+	}
+	return buf.Bytes(), err
 }
 
 func convertHttpRequestData(req *fasthttp.Request) *Request {
@@ -117,10 +200,20 @@ func convertHttpRequestData(req *fasthttp.Request) *Request {
 		data.Headers[string(key)] = string(value)
 	})
 	data.Headers[HTTP_USER_AGENT_HEADER_NAME] = HTTP_USER_AGENT
+	// accept compressed response frame for this connection
+	data.Headers[HTTP_FRAME_COMPRESSION_HEADER_NAME] = HTTP_FRAME_COMPRESSION_ZSTD
+	// announce V1 wire schema support, server replies with V1 after this
+	data.Headers[HTTP_WIRE_SCHEMA_HEADER_NAME] = strconv.Itoa(WIRE_SCHEMA_V1)
+	// accept multi-frame streamed response, forwarded as HTTP chunked transfer
+	data.Headers[HTTP_RESPONSE_STREAM_HEADER_NAME] = "1"
 	data.Querys = make(map[string]string)
 	req.URI().QueryArgs().VisitAll(func(key, value []byte) {
 		data.Querys[string(key)] = string(value)
 	})
+	// convert relative timeout to absolute deadline, so time waited in agent and server queue is counted
+	if timeout := requestTimeout(req); timeout > 0 {
+		data.Deadline = time.Now().Add(timeout).UnixMilli()
+	}
 
 	// do not read body for file upload
 	if !(req.Header.IsPost() && string(req.URI().Path()) == REST_PATH_UPLOAD) {
@@ -129,6 +222,61 @@ func convertHttpRequestData(req *fasthttp.Request) *Request {
 	return data
 }
 
+// requestTimeout get timeout from X-Request-Timeout header (seconds), zero means no timeout
+func requestTimeout(req *fasthttp.Request) time.Duration {
+	if value := req.Header.Peek(HTTP_REQUEST_TIMEOUT_HEADER_NAME); len(value) > 0 {
+		if seconds, err := strconv.ParseFloat(string(value), 64); err == nil && seconds > 0 {
+			return time.Duration(seconds * float64(time.Second))
+		}
+	}
+	return 0
+}
+
+// convertStreamResponseToHttp reply status and headers of the first chunk and forward
+// following chunks with HTTP chunked transfer until end of stream, an abandoned stream
+// aborts the client connection so the truncated body is not taken as complete
+func convertStreamResponseToHttp(ctx *fasthttp.RequestCtx, first *Response, stream *responseStream) {
+	for k, v := range first.Headers {
+		ctx.Response.Header.Set(k, v)
+	}
+	ctx.Response.Header.Set(HTTP_USER_AGENT_HEADER_NAME, HTTP_USER_AGENT)
+	ctx.Response.SetStatusCode(int(first.HttpStatus))
+	ctx.SetContentType(first.BodyMsgType)
+	conn := ctx.Conn()
+	ctx.SetBodyStreamWriter(func(w *bufio.Writer) {
+		// release map entry and socket reader when stream finished or client gone
+		defer close(stream.done)
+		defer requestMap.Delete(first.Uuid)
+		data := first
+		for {
+			if _, err := w.WriteString(data.Body); err != nil {
+				return
+			}
+			// flush each chunk so client see data immediately
+			if err := w.Flush(); err != nil {
+				return
+			}
+			if data.StreamState != STREAM_STATE_CHUNK {
+				log.Printf("REST stream Finished  %s", first.Uuid)
+				return
+			}
+			var ok bool
+			select {
+			case data, ok = <-stream.ch:
+				if !ok {
+					log.Printf("REST stream %s abandoned for slow client", first.Uuid)
+					conn.Close()
+					return
+				}
+			case <-time.After(RESPONSE_STREAM_SEND_TIMEOUT):
+				log.Printf("REST stream %s timed out waiting chunk", first.Uuid)
+				conn.Close()
+				return
+			}
+		}
+	})
+}
+
 func convertResponseToHttp(ctx *fasthttp.RequestCtx, data *Response) {
 	// headers
 	for k, v := range data.Headers {
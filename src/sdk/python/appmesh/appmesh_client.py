@@ -627,6 +627,31 @@ class AppMeshClient(metaclass=abc.ABCMeta):
             apps.append(App(app))
         return apps
 
+    def app_watch(self, revision: int = 0, timeout: int = 30) -> dict:
+        """Wait for application changes after a revision (long poll)
+
+        Args:
+            revision (int, optional): last seen revision returned by previous watch, 0 means get all applications.
+            timeout (int, optional): max seconds to wait when nothing changed.
+
+        Returns:
+            dict: "revision" to use for next watch, "reset" True when "applications" is the full list,
+                "applications" added or changed App objects, "removed" names of removed applications.
+
+        Exception:
+            failed request
+        """
+        resp = self._request_http(
+            AppMeshClient.Method.GET,
+            path="/appmesh/applications/watch",
+            query={"revision": str(revision), "timeout": str(timeout)},
+        )
+        if resp.status_code != HTTPStatus.OK:
+            raise Exception(resp.text)
+        result = resp.json()
+        result["applications"] = [App(app) for app in result["applications"]]
+        return result
+
     def app_output(self, app_name: str, stdout_position: int = 0, stdout_index: int = 0, stdout_maxsize: int = 10240, process_uuid: str = "", timeout: int = 0) -> AppOutput:
         """Get application stdout/stderr
 
@@ -1138,21 +1163,25 @@ class AppMeshClient(metaclass=abc.ABCMeta):
     ########################################
     # File management
     ########################################
-    def file_download(self, file_path: str, local_file: str) -> bool:
+    def file_download(self, file_path: str, local_file: str, resume: bool = False) -> bool:
         """Copy a remote file to local, the local file will have the same permission as the remote file
 
         Args:
             file_path (str): the remote file path.
             local_file (str): the local file path to be downloaded.
+            resume (bool): continue an interrupted download from the size of existing local file.
 
         Returns:
             bool: success or failure.
         """
-        resp = self._request_http(AppMeshClient.Method.GET, path="/appmesh/file/download", header={"File-Path": file_path})
-        if resp.status_code != HTTPStatus.OK:
+        header = {"File-Path": file_path}
+        if resume and os.path.exists(local_file) and os.path.getsize(local_file) > 0:
+            header["Range"] = f"bytes={os.path.getsize(local_file)}-"
+        resp = self._request_http(AppMeshClient.Method.GET, path="/appmesh/file/download", header=header)
+        if resp.status_code not in (HTTPStatus.OK, HTTPStatus.PARTIAL_CONTENT):
             raise Exception(resp.text)
 
-        with open(local_file, "wb") as fp:
+        with open(local_file, "ab" if resp.status_code == HTTPStatus.PARTIAL_CONTENT else "wb") as fp:
             for chunk in resp.iter_content(chunk_size=512):
                 if chunk:
                     fp.write(chunk)
@@ -1548,19 +1577,23 @@ class AppMeshClientTCP(AppMeshClient):
     ########################################
     # File management
     ########################################
-    def file_download(self, file_path: str, local_file: str) -> bool:
+    def file_download(self, file_path: str, local_file: str, resume: bool = False) -> bool:
         """Copy a remote file to local, the local file will have the same permission as the remote file
 
         Args:
             file_path (str): the remote file path.
             local_file (str): the local file path to be downloaded.
+            resume (bool): continue an interrupted download from the size of existing local file.
 
         Returns:
             bool: success or failure.
         """
-        resp = self._request_http(AppMeshClient.Method.GET, path="/appmesh/file/download", header={"File-Path": file_path})
-        if resp.status_code == HTTPStatus.OK:
-            with open(local_file, "wb") as fp:
+        header = {"File-Path": file_path}
+        if resume and os.path.exists(local_file) and os.path.getsize(local_file) > 0:
+            header["Range"] = f"bytes={os.path.getsize(local_file)}-"
+        resp = self._request_http(AppMeshClient.Method.GET, path="/appmesh/file/download", header=header)
+        if resp.status_code in (HTTPStatus.OK, HTTPStatus.PARTIAL_CONTENT):
+            with open(local_file, "ab" if resp.status_code == HTTPStatus.PARTIAL_CONTENT else "wb") as fp:
                 chunk_data = bytes()
                 chunk_size = int.from_bytes(self.__recvall(TCP_MESSAGE_HEADER_LENGTH), "big", signed=False)
                 while chunk_size > 0:
@@ -1608,7 +1641,7 @@ class AppMeshClientTCP(AppMeshClient):
             # https://stackoverflow.com/questions/22567306/python-requests-file-upload
             resp = self._request_http(AppMeshClient.Method.POST, path="/appmesh/file/upload", header=header)
             if resp.status_code == HTTPStatus.OK:
-                chunk_size = 1024 * 4  # 131072 bytes, default max ssl buffer size
+                chunk_size = 1024 * 128  # server coalesces chunks into large write-behind buffers
                 chunk_data = fp.read(chunk_size)
                 while chunk_data:
                     self.__socket_client.sendall(len(chunk_data).to_bytes(TCP_MESSAGE_HEADER_LENGTH, "big", signed=False))
@@ -0,0 +1,362 @@
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
+#include "../../src/common/Utility.h"
+#include "../../src/daemon/Configuration.h"
+#include "../../src/daemon/application/AppRegistry.h"
+#include "../../src/daemon/application/AppSupervisor.h"
+#include "../../src/daemon/application/Application.h"
+#include <ace/Init_ACE.h>
+#include <atomic>
+#include <boost/smart_ptr/make_shared.hpp>
+#include <catch.hpp>
+#include <chrono>
+#include <future>
+#include <iostream>
+#include <log4cpp/Appender.hh>
+#include <log4cpp/Category.hh>
+#include <log4cpp/OstreamAppender.hh>
+#include <log4cpp/PatternLayout.hh>
+#include <log4cpp/Priority.hh>
+#include <map>
+#include <memory>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+void init()
+{
+	static bool initialized = false;
+	if (!initialized)
+	{
+		initialized = true;
+		ACE::init();
+		using namespace log4cpp;
+		auto consoleLayout = new PatternLayout();
+		consoleLayout->setConversionPattern("%d [%t] %p %c: %m%n");
+		auto consoleAppender = new OstreamAppender("console", &std::cout);
+		consoleAppender->setLayout(consoleLayout);
+
+		Category &root = Category::getRoot();
+		root.addAppender(consoleAppender);
+
+		// Log level
+		Utility::setLogLevel("DEBUG");
+
+		LOG_INF << "Logging process ID:" << getpid();
+	}
+}
+
+TEST_CASE("AppSupervisor earlier schedule wins", "[AppSupervisor]")
+{
+	init();
+
+	std::map<std::string, AppSupervisor::TimePoint> evaluated;
+	AppSupervisor supervisor([&evaluated](const std::string &appName)
+							 {
+								 evaluated[appName] = std::chrono::system_clock::now();
+								 return AppSupervisor::TimePoint::max(); });
+
+	const auto start = std::chrono::system_clock::now();
+	// earlier schedule replaces a later one
+	supervisor.schedule("early", start + std::chrono::seconds(10));
+	supervisor.schedule("early", start + std::chrono::milliseconds(10));
+	// later schedule does not postpone an earlier one
+	supervisor.schedule("late", start + std::chrono::milliseconds(10));
+	supervisor.schedule("late", start + std::chrono::seconds(10));
+	// idle application is never scheduled
+	supervisor.schedule("idle", AppSupervisor::TimePoint::max());
+	REQUIRE(supervisor.scheduledCount() == 2);
+
+	REQUIRE(supervisor.run(start + std::chrono::milliseconds(500)) == 2);
+	REQUIRE(evaluated.size() == 2);
+	REQUIRE(evaluated["early"] < start + std::chrono::seconds(1));
+	REQUIRE(evaluated["late"] < start + std::chrono::seconds(1));
+	REQUIRE(supervisor.scheduledCount() == 0);
+}
+
+TEST_CASE("AppSupervisor notify during pass", "[AppSupervisor]")
+{
+	init();
+
+	std::atomic<int> evaluations(0);
+	std::unique_ptr<AppSupervisor> supervisor;
+	supervisor.reset(new AppSupervisor([&](const std::string &appName)
+									   {
+										   // state transition event while application is being evaluated
+										   if (++evaluations == 1)
+											   supervisor->notify(appName);
+										   return AppSupervisor::TimePoint::max(); }));
+
+	supervisor->notify("app");
+	// event is not lost by the evaluation that was running when it arrived
+	REQUIRE(supervisor->run(std::chrono::system_clock::now() + std::chrono::milliseconds(200)) == 2);
+	REQUIRE(evaluations == 2);
+	REQUIRE(supervisor->scheduledCount() == 0);
+
+}
+
+TEST_CASE("AppSupervisor shard isolation", "[AppSupervisor]")
+{
+	init();
+
+	const int appNum = 64;
+	std::vector<std::atomic<int>> running(appNum);
+	std::vector<std::atomic<int>> evaluations(appNum);
+	std::atomic<int> overlaps(0);
+	for (int i = 0; i < appNum; i++)
+	{
+		running[i] = 0;
+		evaluations[i] = 0;
+	}
+
+	AppSupervisor supervisor([&](const std::string &appName)
+							 {
+								 const auto index = std::stoi(appName);
+								 if (running[index]++ != 0)
+									 ++overlaps;
+								 std::this_thread::sleep_for(std::chrono::microseconds(100));
+								 --running[index];
+								 ++evaluations[index];
+								 // due again at once
+								 return std::chrono::system_clock::now(); },
+							 4);
+
+	for (int i = 0; i < appNum; i++)
+		supervisor.notify(std::to_string(i));
+	// events from another thread while passes are running
+	std::atomic<bool> stop(false);
+	std::thread notifier([&]()
+						 {
+							 for (int i = 0; !stop; i = (i + 1) % appNum)
+							 {
+								 supervisor.notify(std::to_string(i));
+								 std::this_thread::sleep_for(std::chrono::microseconds(50));
+							 } });
+
+	supervisor.run(std::chrono::system_clock::now() + std::chrono::milliseconds(500));
+	stop = true;
+	notifier.join();
+
+	// one application is never evaluated by two shards at the same time
+	REQUIRE(overlaps == 0);
+	for (int i = 0; i < appNum; i++)
+		REQUIRE(evaluations[i] > 1);
+}
+
+TEST_CASE("AppSupervisor slow application", "[AppSupervisor]")
+{
+	init();
+
+	// two applications on different shards
+	const std::string slowApp = "slow";
+	std::string fastApp;
+	for (int i = 0; fastApp.empty(); i++)
+	{
+		const auto name = "fast" + std::to_string(i);
+		if (std::hash<std::string>()(name) % 2 != std::hash<std::string>()(slowApp) % 2)
+			fastApp = name;
+	}
+
+	std::atomic<bool> slowStarted(false);
+	std::atomic<AppSupervisor::TimePoint> fastEvaluated(AppSupervisor::TimePoint::max());
+	AppSupervisor supervisor([&](const std::string &appName)
+							 {
+								 if (appName == slowApp)
+								 {
+									 slowStarted = true;
+									 std::this_thread::sleep_for(std::chrono::seconds(1));
+								 }
+								 else
+								 {
+									 fastEvaluated = std::chrono::system_clock::now();
+								 }
+								 return AppSupervisor::TimePoint::max(); },
+							 2);
+
+	supervisor.notify(slowApp);
+	AppSupervisor::TimePoint notified;
+	std::thread notifier([&]()
+						 {
+							 while (!slowStarted)
+								 std::this_thread::sleep_for(std::chrono::milliseconds(1));
+							 notified = std::chrono::system_clock::now();
+							 supervisor.notify(fastApp); });
+
+	supervisor.run(std::chrono::system_clock::now() + std::chrono::milliseconds(1500));
+	notifier.join();
+
+	// evaluated while the slow evaluation of the other shard is still running
+	REQUIRE(fastEvaluated.load() != AppSupervisor::TimePoint::max());
+	REQUIRE(fastEvaluated.load() - notified < std::chrono::milliseconds(500));
+}
+
+class NamedApp : public Application
+{
+public:
+	explicit NamedApp(const std::string &name)
+	{
+		m_name = name;
+	}
+};
+
+std::vector<std::string> appNames(const std::shared_ptr<const AppSnapshot> &snapshot)
+{
+	std::vector<std::string> names;
+	for (const auto &app : *snapshot)
+		names.push_back(app->getName());
+	return names;
+}
+
+TEST_CASE("AppRegistry replace and remove", "[AppRegistry]")
+{
+	init();
+
+	AppRegistry registry;
+	for (const auto &name : {"a", "b", "c", "d"})
+		REQUIRE(registry.add(std::make_shared<NamedApp>(name)));
+	REQUIRE_FALSE(registry.add(std::make_shared<NamedApp>("b")));
+	const auto before = registry.snapshot();
+
+	// replaced application keeps its position
+	const auto oldB = before->find(std::string("b"));
+	const auto newB = std::make_shared<NamedApp>("b");
+	REQUIRE(registry.replace(newB) == oldB);
+	auto snapshot = registry.snapshot();
+	REQUIRE(appNames(snapshot) == std::vector<std::string>({"a", "b", "c", "d"}));
+	REQUIRE(snapshot->find(std::string("b")) == newB);
+	REQUIRE(snapshot->find(newB.get()) == newB);
+	REQUIRE(snapshot->find(oldB.get()) == nullptr);
+	REQUIRE(snapshot->version() == before->version() + 1);
+
+	// indexes after removed position are rebuilt
+	const auto c = snapshot->find(std::string("c"));
+	const auto d = snapshot->find(std::string("d"));
+	REQUIRE(registry.remove("b") == newB);
+	REQUIRE(registry.remove("b") == nullptr);
+	snapshot = registry.snapshot();
+	REQUIRE(appNames(snapshot) == std::vector<std::string>({"a", "c", "d"}));
+	REQUIRE(snapshot->find(std::string("b")) == nullptr);
+	REQUIRE(snapshot->find(std::string("c")) == c);
+	REQUIRE(snapshot->find(std::string("d")) == d);
+	REQUIRE(snapshot->find(d.get()) == d);
+
+	// published snapshot is never changed
+	REQUIRE(appNames(before) == std::vector<std::string>({"a", "b", "c", "d"}));
+	REQUIRE(before->find(std::string("b")) == oldB);
+}
+
+TEST_CASE("AppRegistry bulk add", "[AppRegistry]")
+{
+	init();
+
+	AppRegistry registry;
+	REQUIRE(registry.add(std::make_shared<NamedApp>("a")));
+	const auto version = registry.snapshot()->version();
+
+	const auto dupExist = std::make_shared<NamedApp>("a");
+	const auto dupBatch = std::make_shared<NamedApp>("b");
+	const auto rejected = registry.add(std::vector<std::shared_ptr<Application>>{std::make_shared<NamedApp>("b"), dupExist, std::make_shared<NamedApp>("c"), dupBatch});
+	REQUIRE(rejected.size() == 2);
+	REQUIRE(rejected[0] == dupExist);
+	REQUIRE(rejected[1] == dupBatch);
+
+	// one publish for the whole batch
+	const auto snapshot = registry.snapshot();
+	REQUIRE(snapshot->version() == version + 1);
+	REQUIRE(appNames(snapshot) == std::vector<std::string>({"a", "b", "c"}));
+	REQUIRE(snapshot->find(dupBatch.get()) == nullptr);
+
+	// nothing registered, nothing published
+	REQUIRE(registry.add(std::vector<std::shared_ptr<Application>>{dupExist}).size() == 1);
+	REQUIRE(registry.snapshot()->version() == version + 1);
+}
+
+TEST_CASE("Application attached process exit", "[Application]")
+{
+	init();
+	Configuration::instance(std::make_shared<Configuration>());
+
+	auto app = std::make_shared<Application>();
+	nlohmann::json json;
+	json[JSON_KEY_APP_name] = std::string("attached");
+	json[JSON_KEY_APP_command] = std::string("sleep 60");
+	Application::FromJson(app, json);
+
+	// pid not spawned by process manager, same as a pid recovered after restart
+	const auto pid = fork();
+	if (pid == 0)
+	{
+		usleep(200 * 1000);
+		_exit(0);
+	}
+	std::thread reaper([pid]()
+					   { waitpid(pid, nullptr, 0); });
+
+	REQUIRE(app->attach(pid));
+	REQUIRE(app->getpid() == pid);
+	// exit is not notified, so evaluation is polled
+	const auto now = std::chrono::system_clock::now();
+	REQUIRE(app->nextEvaluation(now) <= now + std::chrono::seconds(Configuration::instance()->getScheduleInterval()));
+
+	reaper.join();
+	app->execute();
+	REQUIRE(app->getpid() != pid);
+}
+
+class RuntimeApp : public Application
+{
+public:
+	explicit RuntimeApp(const std::string &name) { m_name = name; }
+
+	// runtime state change the same way as spawn
+	void start(pid_t pid)
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_appMutex);
+		m_pid = pid;
+		m_procStartTime = boost::make_shared<std::chrono::system_clock::time_point>(std::chrono::system_clock::now());
+		publishRuntime();
+	}
+
+	std::recursive_mutex &appMutex() { return m_appMutex; }
+};
+
+TEST_CASE("Application runtime snapshot", "[Application]")
+{
+	init();
+	Configuration::instance(std::make_shared<Configuration>());
+
+	auto app = std::make_shared<RuntimeApp>("runtime");
+	app->start(100);
+	const auto first = app->getRuntime();
+	const auto revision = app->getRevision();
+	REQUIRE(first->m_pid == 100);
+	REQUIRE(first->m_procStartTime != nullptr);
+
+	// state change publish a new snapshot and revision, published snapshot is never changed
+	app->start(200);
+	REQUIRE(app->getRuntime()->m_pid == 200);
+	REQUIRE(app->getRevision() > revision);
+	REQUIRE(first->m_pid == 100);
+
+	// readers do not wait for a writer holding application lock
+	std::promise<void> locked;
+	std::atomic<bool> release(false);
+	std::thread writer([&]()
+					   {
+						   std::lock_guard<std::recursive_mutex> guard(app->appMutex());
+						   locked.set_value();
+						   const auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+						   while (!release && std::chrono::steady_clock::now() < timeout)
+							   std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+	locked.get_future().wait();
+	const auto start = std::chrono::steady_clock::now();
+	const auto runtime = app->getRuntime();
+	const auto json = app->AsJson(true, nullptr, false);
+	const auto elapsed = std::chrono::steady_clock::now() - start;
+	release = true;
+	writer.join();
+	REQUIRE(elapsed < std::chrono::seconds(1));
+	REQUIRE(runtime->m_pid == 200);
+	REQUIRE(json.count(JSON_KEY_APP_last_start) > 0);
+}
@@ -0,0 +1,816 @@
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
+#include "../../src/common/MessageQueue.h"
+#include "../../src/common/ShardedMap.h"
+#include "../../src/common/Utility.h"
+#include "../../src/daemon/Configuration.h"
+#include "../../src/daemon/application/AppRegistry.h"
+#include "../../src/daemon/application/AppSupervisor.h"
+#include "../../src/daemon/application/Application.h"
+#include "../../src/daemon/rest/HttpRequest.h"
+#include "../../src/daemon/rest/RequestQueue.h"
+#include "../../src/daemon/rest/RestHandler.h"
+#include "../../src/daemon/rest/TcpServer.h"
+#include <ace/Init_ACE.h>
+#include <ace/Map_Manager.h>
+#include <ace/OS.h>
+#include <ace/Recursive_Thread_Mutex.h>
+#include <algorithm>
+#include <atomic>
+#include <boost/regex.hpp>
+#include <boost/smart_ptr/make_shared.hpp>
+#include <catch.hpp>
+#include <chrono>
+#include <ctime>
+#include <iostream>
+#include <log4cpp/Appender.hh>
+#include <log4cpp/Category.hh>
+#include <log4cpp/OstreamAppender.hh>
+#include <log4cpp/PatternLayout.hh>
+#include <log4cpp/Priority.hh>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+void init()
+{
+	static bool initialized = false;
+	if (!initialized)
+	{
+		initialized = true;
+		ACE::init();
+		using namespace log4cpp;
+		auto consoleLayout = new PatternLayout();
+		consoleLayout->setConversionPattern("%d [%t] %p %c: %m%n");
+		auto consoleAppender = new OstreamAppender("console", &std::cout);
+		consoleAppender->setLayout(consoleLayout);
+
+		Category &root = Category::getRoot();
+		root.addAppender(consoleAppender);
+
+		// benchmark should not be impacted by debug log
+		Utility::setLogLevel("INFO");
+
+		LOG_INF << "Logging process ID:" << getpid();
+	}
+}
+
+// elapsed microseconds since start
+static long long elapsedUs(const std::chrono::steady_clock::time_point &start)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// TcpHandler::replyTcp() registry
+//////////////////////////////////////////////////////////////////////////
+// registered and reference counted the same way as TcpConnection, reply() simulate the
+// socket write, file download reply hold the socket for a long time
+class BenchConnection : public ACE_Event_Handler, public TcpHandler
+{
+public:
+	explicit BenchConnection(std::atomic_int &deleted) : m_deleted(deleted)
+	{
+		this->reference_counting_policy().value(ACE_Event_Handler::Reference_Counting_Policy::ENABLED);
+		m_handlers.insert(m_id, this);
+	}
+	virtual ~BenchConnection() { ++m_deleted; }
+
+	// same as TcpConnection::handle_close(): unregister and release creator reference
+	void close()
+	{
+		m_handlers.erase(m_id);
+		this->remove_reference();
+	}
+	// used by previous implementation which call reply() under the global map lock
+	bool replyLocked(const Response &resp) { return reply(resp); }
+
+protected:
+	virtual bool reply(const Response &resp) override
+	{
+		std::lock_guard<std::mutex> guard(m_socketLock);
+		if (resp.request_uri == "/appmesh/file/download")
+			std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		return true;
+	}
+	virtual bool waitSendQueueBelow(size_t, std::chrono::milliseconds) override { return true; }
+	virtual ACE_Event_Handler *eventHandler() override { return this; }
+
+private:
+	std::mutex m_socketLock;
+	std::atomic_int &m_deleted;
+};
+
+TEST_CASE("TcpHandler reply registry", "[benchmark]")
+{
+	init();
+
+	const int connectionNum = 64;
+	const int replyThreadNum = 4;
+	const int repliesPerThread = 2000;
+
+	Response smallReply;
+	smallReply.request_uri = "/appmesh/applications";
+	Response largeReply;
+	largeReply.request_uri = "/appmesh/file/download";
+
+	std::atomic_int deleted(0);
+	std::vector<BenchConnection *> connections;
+	for (int i = 0; i < connectionNum; i++)
+		connections.push_back(new BenchConnection(deleted));
+
+	// run one large download on connection 0 and concurrent small replies on other connections,
+	// return max small reply latency in microseconds
+	std::atomic_int failed(0);
+	auto runBench = [&](const std::function<bool(int, const Response &)> &replyTcp)
+	{
+		std::atomic_llong maxLatency(0);
+		std::thread download([&]()
+							 { failed += !replyTcp(connections[0]->id(), largeReply); });
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		std::vector<std::thread> workers;
+		for (int t = 0; t < replyThreadNum; t++)
+		{
+			workers.emplace_back([&, t]()
+								 {
+									 for (int i = 0; i < repliesPerThread; i++)
+									 {
+										 auto start = std::chrono::steady_clock::now();
+										 failed += !replyTcp(connections[1 + (t * repliesPerThread + i) % (connectionNum - 1)]->id(), smallReply);
+										 auto latency = elapsedUs(start);
+										 auto current = maxLatency.load();
+										 while (latency > current && !maxLatency.compare_exchange_weak(current, latency))
+											 ;
+									 }
+								 });
+		}
+		for (auto &w : workers)
+			w.join();
+		download.join();
+		return maxLatency.load();
+	};
+
+	// previous implementation: global map lock held during reply
+	ACE_Map_Manager<int, BenchConnection *, ACE_Recursive_Thread_Mutex> globalLockMap;
+	for (auto connection : connections)
+		globalLockMap.bind(connection->id(), connection);
+	auto globalLockLatency = runBench([&globalLockMap](int id, const Response &resp)
+									  {
+										  ACE_GUARD_RETURN(ACE_Recursive_Thread_Mutex, locker, globalLockMap.mutex(), false);
+										  BenchConnection *client = nullptr;
+										  return globalLockMap.find(id, client) == 0 && client && client->replyLocked(resp);
+									  });
+
+	// TcpHandler::replyTcp(): short sharded lookup with reference, reply outside lock
+	auto shardedLatency = runBench(&TcpHandler::replyTcp);
+
+	std::cout << "small reply max latency during download, global lock: " << globalLockLatency << "us, sharded registry: " << shardedLatency << "us" << std::endl;
+	REQUIRE(failed == 0);
+
+	// in-flight reply hold a reference, connection closed by reactor is deleted after reply return
+	auto closing = connections[0];
+	std::thread download([&]()
+						 { failed += !TcpHandler::replyTcp(closing->id(), largeReply); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	closing->close();
+	REQUIRE_FALSE(TcpHandler::connected(closing->id()));
+	REQUIRE_FALSE(TcpHandler::replyTcp(closing->id(), smallReply));
+	REQUIRE(deleted == 0);
+	download.join();
+	REQUIRE(deleted == 1);
+	REQUIRE(failed == 0);
+
+	for (int i = 1; i < connectionNum; i++)
+		connections[i]->close();
+	REQUIRE(deleted == connectionNum);
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// TcpHandler::handleTcpRest() dispatcher
+//////////////////////////////////////////////////////////////////////////
+TEST_CASE("REST request dispatcher", "[benchmark]")
+{
+	init();
+
+	const int totalMessages = 1000000;
+	const int producerNum = 2; // reactor threads
+	const std::vector<int> workerNums = {1, 4, 16, 64};
+
+	Request req;
+	req.http_method = web::http::methods::GET;
+	req.request_uri = "/appmesh/applications";
+	// both queues carry the same decoded request reference, ACE_Message_Queue need an extra
+	// heap holder for it inside ACE_Message_Block
+	const auto request = std::make_shared<HttpRequest>(std::move(req), 0);
+
+	for (const auto workerNum : workerNums)
+	{
+		// previous implementation: ACE_Message_Queue shared by all workers
+		double oldSeconds = 0;
+		{
+			MessageQueue queue;
+			std::atomic_int consumed(0);
+			auto start = std::chrono::steady_clock::now();
+			std::vector<std::thread> workers;
+			for (int i = 0; i < workerNum; i++)
+			{
+				workers.emplace_back([&]()
+									 {
+										 ACE_Message_Block *msg = nullptr;
+										 while (queue.dequeue(msg) >= 0 && msg)
+										 {
+											 std::unique_ptr<std::shared_ptr<HttpRequest>> entity(reinterpret_cast<std::shared_ptr<HttpRequest> *>(msg->rd_ptr()));
+											 msg->release();
+											 if (++consumed == totalMessages)
+												 queue.deactivate();
+										 }
+									 });
+			}
+			std::vector<std::thread> producers;
+			for (int p = 0; p < producerNum; p++)
+			{
+				producers.emplace_back([&]()
+									   {
+										   for (int i = 0; i < totalMessages / producerNum; i++)
+											   queue.enqueue(new ACE_Message_Block((const char *)(new std::shared_ptr<HttpRequest>(request))));
+									   });
+			}
+			for (auto &t : producers)
+				t.join();
+			for (auto &t : workers)
+				t.join();
+			oldSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			REQUIRE(consumed == totalMessages);
+		}
+
+		// work stealing queue
+		double newSeconds = 0;
+		{
+			RequestQueue queue(std::array<size_t, REQUEST_LANE_NUM>{{totalMessages, totalMessages, totalMessages, totalMessages}});
+			queue.init(workerNum);
+			std::atomic_int consumed(0);
+			auto start = std::chrono::steady_clock::now();
+			std::vector<std::thread> workers;
+			for (int i = 0; i < workerNum; i++)
+			{
+				workers.emplace_back([&, i]()
+									 {
+										 while (queue.dequeue(i))
+										 {
+											 if (++consumed == totalMessages)
+												 queue.close();
+										 }
+									 });
+			}
+			std::vector<std::thread> producers;
+			for (int p = 0; p < producerNum; p++)
+			{
+				producers.emplace_back([&]()
+									   {
+										   for (int i = 0; i < totalMessages / producerNum; i++)
+											   queue.enqueue(request);
+									   });
+			}
+			for (auto &t : producers)
+				t.join();
+			for (auto &t : workers)
+				t.join();
+			newSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			REQUIRE(consumed == totalMessages);
+		}
+
+		std::cout << "dispatch " << totalMessages << " messages with " << workerNum << " workers, ACE_Message_Queue: "
+				  << oldSeconds << "s, work stealing: " << newSeconds << "s" << std::endl;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Request / Response wire schema
+//////////////////////////////////////////////////////////////////////////
+TEST_CASE("Wire schema serializer", "[benchmark]")
+{
+	init();
+
+	const int iterations = 200000;
+	const std::string token = "Bearer " + std::string(320, 'x'); // typical JWT length
+
+	// realistic request mix: list apps, view output, run app, health check
+	std::vector<Request> requests(4);
+	requests[0].http_method = web::http::methods::GET;
+	requests[0].request_uri = "/appmesh/applications";
+	requests[1].http_method = web::http::methods::GET;
+	requests[1].request_uri = "/appmesh/app/myapp/output";
+	requests[1].querys = {{HTTP_QUERY_KEY_stdout_position, "1024"}, {HTTP_QUERY_KEY_stdout_index, "0"}};
+	requests[2].http_method = web::http::methods::POST;
+	requests[2].request_uri = "/appmesh/app/syncrun";
+	requests[2].body = R"({"command":"ping github.com -c 3","shell":true,"working_dir":"/tmp"})";
+	requests[2].querys = {{HTTP_QUERY_KEY_timeout, "10"}};
+	requests[3].http_method = web::http::methods::GET;
+	requests[3].request_uri = "/appmesh/app/myapp/health";
+	for (auto &req : requests)
+	{
+		req.uuid = "cn8q3s5t0lh2rh3p4ab0";
+		req.client_addr = "127.0.0.1:6058";
+		req.headers = {{"Authorization", token}, {"User-Agent", HTTP_USER_AGENT_APPMESH_GO}, {"Accept", "*/*"}, {HTTP_HEADER_KEY_wire_schema, "1"}};
+	}
+
+	std::vector<Response> responses(2);
+	responses[0].uuid = requests[0].uuid;
+	responses[0].request_uri = requests[0].request_uri;
+	responses[0].http_status = web::http::status_codes::OK;
+	responses[0].body_msg_type = "application/json";
+	responses[0].body = R"([{"name":"ping","status":1,"pid":1234,"return":0,"health":0,"owner":"mesh"}])";
+	responses[1].uuid = requests[1].uuid;
+	responses[1].request_uri = requests[1].request_uri;
+	responses[1].http_status = web::http::status_codes::OK;
+	responses[1].body_msg_type = "text/plain";
+	responses[1].body = "64 bytes from 140.82.114.4: icmp_seq=1 ttl=50 time=10.1 ms";
+	responses[1].headers = {{HTTP_HEADER_KEY_output_pos, "2048"}, {HTTP_HEADER_KEY_exit_code, "0"}};
+
+	for (const auto schema : {WireSchema::Map, WireSchema::V1})
+	{
+		size_t requestBytes = 0;
+		size_t responseBytes = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			const auto &source = requests[i % requests.size()];
+			auto data = source.serialize(schema);
+			Request decoded;
+			REQUIRE(decoded.deserialize(data->data(), data->size()));
+			requestBytes += data->size();
+		}
+		const auto requestUs = elapsedUs(start);
+
+		start = std::chrono::steady_clock::now();
+		for (int i = 0; i < iterations; i++)
+		{
+			const auto &source = responses[i % responses.size()];
+			auto data = source.serialize(schema);
+			Response decoded;
+			REQUIRE(decoded.deserialize(data->data(), data->size()));
+			responseBytes += data->size();
+		}
+		const auto responseUs = elapsedUs(start);
+
+		// round trip keeps all fields
+		auto data = requests[2].serialize(schema);
+		Request decoded;
+		REQUIRE(decoded.deserialize(data->data(), data->size()));
+		REQUIRE(decoded.http_method == requests[2].http_method);
+		REQUIRE(decoded.body == requests[2].body);
+		REQUIRE(decoded.querys == requests[2].querys);
+		REQUIRE(decoded.headers == requests[2].headers);
+
+		std::cout << (schema == WireSchema::V1 ? "positional V1" : "map") << " schema, request: "
+				  << requestBytes / iterations << " bytes " << requestUs * 1000 / iterations << " ns, response: "
+				  << responseBytes / iterations << " bytes " << responseUs * 1000 / iterations << " ns" << std::endl;
+	}
+
+	// V1 never larger than map
+	for (const auto &req : requests)
+		REQUIRE(req.serialize(WireSchema::V1)->size() < req.serialize(WireSchema::Map)->size());
+	for (const auto &resp : responses)
+		REQUIRE(resp.serialize(WireSchema::V1)->size() < resp.serialize(WireSchema::Map)->size());
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// RestBase::handleRest() routing
+//////////////////////////////////////////////////////////////////////////
+class RouteTable : public RestHandler
+{
+public:
+	const std::vector<std::pair<std::string, const RestRouter *>> routers() const
+	{
+		return {{web::http::methods::GET, &m_restGetFunctions},
+				{web::http::methods::PUT, &m_restPutFunctions},
+				{web::http::methods::POST, &m_restPstFunctions},
+				{web::http::methods::DEL, &m_restDelFunctions}};
+	}
+};
+
+TEST_CASE("REST router", "[benchmark]")
+{
+	init();
+	Configuration::instance(std::make_shared<Configuration>());
+
+	const int iterations = 20;
+	const RouteTable routeTable;
+
+	// one request path per route registered in RestHandler, parameters filled with sample value
+	std::vector<std::pair<const RestRouter *, std::string>> paths;
+	// previous implementation: pattern in regex form, regex constructed per route until match
+	std::map<const RestRouter *, std::map<std::string, bool>> regexRoutes;
+	for (const auto &router : routeTable.routers())
+	{
+		for (const auto &pattern : router.second->patterns())
+		{
+			paths.emplace_back(router.second, boost::regex_replace(pattern, boost::regex(R"(\{[^}]+\})"), "myapp"));
+			regexRoutes[router.second][boost::regex_replace(pattern, boost::regex(R"(\{[^}]+\})"), R"(([^/\*]+))")] = true;
+		}
+	}
+	REQUIRE(paths.size() > 40);
+
+	size_t matched = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; i++)
+	{
+		for (const auto &path : paths)
+		{
+			for (const auto &kvp : regexRoutes[path.first])
+			{
+				if (path.second == kvp.first || boost::regex_match(path.second, boost::regex(kvp.first)))
+				{
+					matched++;
+					break;
+				}
+			}
+		}
+	}
+	const auto regexNs = elapsedUs(start) * 1000 / (iterations * paths.size());
+	REQUIRE(matched == iterations * paths.size());
+
+	matched = 0;
+	const int treeIterations = iterations * 1000;
+	PathParams params;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < treeIterations; i++)
+	{
+		for (const auto &path : paths)
+		{
+			params.clear();
+			if (path.first->match(path.second, params))
+				matched++;
+		}
+	}
+	const auto treeNs = elapsedUs(start) * 1000 / (treeIterations * paths.size());
+	REQUIRE(matched == treeIterations * paths.size());
+
+	// static route has precedence over parameter, parameter is captured
+	for (const auto &router : routeTable.routers())
+	{
+		if (router.first != web::http::methods::GET)
+			continue;
+		params.clear();
+		REQUIRE(router.second->match("/appmesh/user/self", params) != nullptr);
+		REQUIRE(params.empty());
+		REQUIRE(router.second->match("/appmesh/app/myapp/output", params) != nullptr);
+		REQUIRE(params.size() == 1);
+		REQUIRE(params[0].second == "myapp");
+		REQUIRE(router.second->match("/appmesh/app/my*app/output", params) == nullptr);
+	}
+
+	std::cout << "route " << paths.size() << " paths, regex per route: " << regexNs << " ns/request, radix tree: " << treeNs << " ns/request" << std::endl;
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// main loop application evaluation: polling vs AppSupervisor
+//////////////////////////////////////////////////////////////////////////
+TEST_CASE("Application supervisor", "[benchmark]")
+{
+	init();
+
+	const size_t appCount = 10000;
+	const size_t busyCount = 100; // applications need periodic evaluation (daily limit, metrics)
+	const auto tick = std::chrono::milliseconds(100);
+	const auto duration = std::chrono::seconds(2);
+
+	std::vector<std::string> names;
+	std::unordered_map<std::string, size_t> indexes;
+	for (size_t i = 0; i < appCount; i++)
+	{
+		names.push_back("app-" + std::to_string(i));
+		indexes[names.back()] = i;
+	}
+
+	for (const bool eventDriven : {false, true})
+	{
+		std::vector<std::atomic<long long>> notifyTime(appCount); // steady clock microseconds, 0 for none
+		std::atomic<size_t> evaluations(0);
+		std::atomic<long long> latencyUs(0);
+		std::atomic<size_t> latencyCount(0);
+		const auto epoch = std::chrono::steady_clock::now();
+
+		auto evaluator = [&](const std::string &appName) -> AppSupervisor::TimePoint
+		{
+			const auto index = indexes.find(appName)->second;
+			evaluations++;
+			const auto notified = notifyTime[index].exchange(0);
+			if (notified)
+			{
+				latencyUs += elapsedUs(epoch) - notified;
+				latencyCount++;
+			}
+			return index < busyCount ? std::chrono::system_clock::now() + tick : AppSupervisor::TimePoint::max();
+		};
+		AppSupervisor supervisor(evaluator);
+
+		// state transition events (process exit) on idle applications
+		std::atomic<bool> stop(false);
+		std::thread injector([&]()
+							 {
+								 size_t i = 0;
+								 while (!stop)
+								 {
+									 const auto &appName = names[busyCount + (i++ * 7919) % (appCount - busyCount)];
+									 notifyTime[indexes.find(appName)->second] = std::max(1LL, elapsedUs(epoch));
+									 if (eventDriven)
+										 supervisor.notify(appName);
+									 std::this_thread::sleep_for(std::chrono::milliseconds(1));
+								 } });
+
+		const auto cpuStart = std::clock();
+		const auto start = std::chrono::steady_clock::now();
+		if (eventDriven)
+		{
+			for (const auto &appName : names)
+				supervisor.notify(appName);
+			supervisor.run(std::chrono::system_clock::now() + duration);
+		}
+		else
+		{
+			while (std::chrono::steady_clock::now() - start < duration)
+			{
+				const auto next = std::chrono::steady_clock::now() + tick;
+				for (const auto &appName : names)
+					evaluator(appName);
+				std::this_thread::sleep_until(next);
+			}
+		}
+		const auto cpuMs = (std::clock() - cpuStart) * 1000 / CLOCKS_PER_SEC;
+		stop = true;
+		injector.join();
+
+		REQUIRE(latencyCount > 0);
+		if (eventDriven)
+		{
+			// idle applications are not scheduled, only busy ones stay in deadline heap
+			REQUIRE(supervisor.scheduledCount() <= busyCount + 1);
+			REQUIRE(evaluations < appCount * (duration / tick));
+		}
+
+		std::cout << (eventDriven ? "event driven supervisor" : "polling loop") << ", " << appCount << " apps: "
+				  << evaluations << " evaluations, " << cpuMs << " ms CPU, event latency "
+				  << latencyUs / latencyCount << " us" << std::endl;
+	}
+}
+
+TEST_CASE("Application supervisor shards", "[benchmark]")
+{
+	init();
+
+	const size_t appCount = 400;
+	const auto executeCost = std::chrono::microseconds(200); // process spawn, cgroup write
+	const auto stragglerCost = std::chrono::milliseconds(50); // docker CLI
+
+	for (const size_t workers : {1, 4})
+	{
+		std::atomic<size_t> evaluations(0);
+		std::mutex appMutex;
+		std::map<std::string, int> inFlight; // per application concurrent evaluation, must never exceed 1
+		bool serialized = true;
+		AppSupervisor supervisor(
+			[&](const std::string &appName) -> AppSupervisor::TimePoint
+			{
+				{
+					std::lock_guard<std::mutex> guard(appMutex);
+					serialized = serialized && ++inFlight[appName] == 1;
+				}
+				std::this_thread::sleep_for(appName == "app-0" ? std::chrono::microseconds(stragglerCost) : executeCost);
+				evaluations++;
+				{
+					std::lock_guard<std::mutex> guard(appMutex);
+					inFlight[appName]--;
+				}
+				return AppSupervisor::TimePoint::max();
+			},
+			workers);
+
+		const int passes = 5;
+		auto start = std::chrono::steady_clock::now();
+		for (int pass = 0; pass < passes; pass++)
+		{
+			for (size_t i = 0; i < appCount; i++)
+				supervisor.notify("app-" + std::to_string(i));
+			// all applications are due, run one pass and return
+			supervisor.run(std::chrono::system_clock::now());
+		}
+		const auto passUs = elapsedUs(start) / passes;
+
+		REQUIRE(evaluations == appCount * passes);
+		REQUIRE(serialized);
+		REQUIRE(supervisor.scheduledCount() == 0);
+
+		std::cout << "application supervisor " << workers << " shards, " << appCount << " apps with one straggler: "
+				  << passUs / 1000 << " ms/pass" << std::endl;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Application runtime read under spawn contention
+//////////////////////////////////////////////////////////////////////////
+class ContendedApplication : public Application
+{
+public:
+	explicit ContendedApplication(const std::string &name) { m_name = name; }
+
+	// state change holding application lock as long as fork + YAML write
+	void spawnLike(const std::chrono::microseconds &cost)
+	{
+		std::lock_guard<std::recursive_mutex> guard(m_appMutex);
+		m_pid = m_pid.load() + 1;
+		m_procStartTime = boost::make_shared<std::chrono::system_clock::time_point>(std::chrono::system_clock::now());
+		std::this_thread::sleep_for(cost);
+		publishRuntime();
+	}
+
+	std::recursive_mutex &appMutex() { return m_appMutex; }
+};
+
+TEST_CASE("Application runtime snapshot", "[benchmark]")
+{
+	init();
+
+	const int readerNum = 4;
+	const auto spawnCost = std::chrono::microseconds(2000);
+	const auto duration = std::chrono::milliseconds(1000);
+
+	for (const bool lockFree : {false, true})
+	{
+		auto app = std::make_shared<ContendedApplication>("contended");
+		app->spawnLike(std::chrono::microseconds(0));
+
+		std::atomic<bool> stop(false);
+		std::atomic<size_t> spawns(0);
+		std::atomic<size_t> incomplete(0);
+		std::thread writer([&]()
+						   {
+							   while (!stop)
+							   {
+								   app->spawnLike(spawnCost);
+								   spawns++;
+							   } });
+
+		std::vector<std::vector<long long>> latencies(readerNum);
+		std::vector<std::thread> readers;
+		for (int r = 0; r < readerNum; r++)
+		{
+			readers.emplace_back([&, r]()
+								 {
+									 const auto end = std::chrono::steady_clock::now() + duration;
+									 while (std::chrono::steady_clock::now() < end)
+									 {
+										 const auto start = std::chrono::steady_clock::now();
+										 nlohmann::json json;
+										 if (lockFree)
+										 {
+											 json = app->AsJson(true, nullptr, false);
+										 }
+										 else
+										 {
+											 // previous read path: AsJson under application lock
+											 std::lock_guard<std::recursive_mutex> guard(app->appMutex());
+											 json = app->AsJson(true, nullptr, false);
+										 }
+										 latencies[r].push_back(elapsedUs(start));
+										 if (json.find(JSON_KEY_APP_last_start) == json.end())
+											 incomplete++;
+									 } });
+		}
+		for (auto &reader : readers)
+			reader.join();
+		stop = true;
+		writer.join();
+
+		std::vector<long long> all;
+		for (const auto &latency : latencies)
+			all.insert(all.end(), latency.begin(), latency.end());
+		std::sort(all.begin(), all.end());
+		REQUIRE(all.size() > 0);
+		REQUIRE(spawns > 0);
+		REQUIRE(incomplete == 0);
+
+		std::cout << (lockFree ? "lock free snapshot" : "locked") << " read, " << readerNum << " readers with "
+				  << spawns << " spawns: " << all.size() << " reads, p50 " << all[all.size() / 2] << " us, p99 "
+				  << all[all.size() * 99 / 100] << " us, max " << all.back() << " us" << std::endl;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+/// Configuration application registry
+//////////////////////////////////////////////////////////////////////////
+TEST_CASE("Application registry", "[benchmark]")
+{
+	init();
+
+	for (const size_t appCount : {100, 1000, 10000})
+	{
+		// previous registry: ACE_Map_Manager with linear search, getApps() copies under map lock
+		ACE_Map_Manager<std::string, std::shared_ptr<Application>, ACE_Recursive_Thread_Mutex> mapManager;
+		AppRegistry registry;
+		std::vector<std::shared_ptr<Application>> apps;
+		for (size_t i = 0; i < appCount; i++)
+		{
+			apps.push_back(std::make_shared<ContendedApplication>("app-" + std::to_string(i)));
+			mapManager.bind(apps.back()->getName(), apps.back());
+			REQUIRE(registry.add(apps.back()));
+		}
+		REQUIRE_FALSE(registry.add(apps.front()));
+		REQUIRE(registry.snapshot()->size() == appCount);
+
+		// linear search cost grows with application number
+		const size_t lookups = 20000000 / appCount;
+		size_t found = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < lookups; i++)
+		{
+			std::shared_ptr<Application> app;
+			if (mapManager.find(apps[(i * 7919) % appCount]->getName(), app) == 0 && app)
+				found++;
+		}
+		const auto mapNameNs = elapsedUs(start) * 1000 / lookups;
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < lookups; i++)
+		{
+			const void *address = apps[(i * 7919) % appCount].get();
+			ACE_Guard<ACE_Recursive_Thread_Mutex> guard(mapManager.mutex());
+			for (const auto &entry : mapManager)
+			{
+				if (address == entry.int_id_.get())
+				{
+					found++;
+					break;
+				}
+			}
+		}
+		const auto mapAddressNs = elapsedUs(start) * 1000 / lookups;
+
+		const size_t iterations = 2000;
+		size_t visited = 0;
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++)
+		{
+			std::vector<std::shared_ptr<Application>> copy;
+			copy.reserve(mapManager.current_size());
+			ACE_Guard<ACE_Recursive_Thread_Mutex> guard(mapManager.mutex());
+			for (const auto &entry : mapManager)
+				copy.push_back(entry.int_id_);
+			visited += copy.size();
+		}
+		const auto mapIterateUs = elapsedUs(start) / iterations;
+		REQUIRE(found == 2 * lookups);
+		REQUIRE(visited == iterations * appCount);
+
+		found = 0;
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < lookups; i++)
+		{
+			if (registry.snapshot()->find(apps[(i * 7919) % appCount]->getName()))
+				found++;
+		}
+		const auto registryNameNs = elapsedUs(start) * 1000 / lookups;
+
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < lookups; i++)
+		{
+			if (registry.snapshot()->find(static_cast<const void *>(apps[(i * 7919) % appCount].get())))
+				found++;
+		}
+		const auto registryAddressNs = elapsedUs(start) * 1000 / lookups;
+
+		visited = 0;
+		start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < iterations; i++)
+		{
+			const auto snapshot = registry.snapshot();
+			for (const auto &app : *snapshot)
+				visited += app ? 1 : 0;
+		}
+		const auto registryIterateUs = elapsedUs(start) / iterations;
+		REQUIRE(found == 2 * lookups);
+		REQUIRE(visited == iterations * appCount);
+
+		// replace keeps position, remove and snapshot isolation
+		const auto before = registry.snapshot();
+		auto replacement = std::make_shared<ContendedApplication>("app-0");
+		REQUIRE(registry.replace(replacement) == apps[0]);
+		REQUIRE(registry.remove("app-1") == apps[1]);
+		REQUIRE(registry.remove("app-1") == nullptr);
+		const auto after = registry.snapshot();
+		REQUIRE(after->version() > before->version());
+		REQUIRE(*after->begin() == replacement);
+		REQUIRE(after->find(apps[0].get()) == nullptr);
+		REQUIRE(after->find(std::string("app-1")) == nullptr);
+		REQUIRE(before->find(std::string("app-1")) == apps[1]);
+		REQUIRE(before->size() == appCount);
+		REQUIRE(after->size() == appCount - 1);
+
+		std::cout << "application registry " << appCount << " apps, name lookup: map " << mapNameNs << " ns, hash " << registryNameNs
+				  << " ns; address lookup: map " << mapAddressNs << " ns, hash " << registryAddressNs
+				  << " ns; iteration: map copy " << mapIterateUs << " us, snapshot " << registryIterateUs << " us" << std::endl;
+	}
+}
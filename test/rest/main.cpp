@@ -0,0 +1,451 @@
+#define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
+#include "../../src/common/Utility.h"
+#include "../../src/daemon/rest/HttpRequest.h"
+#include "../../src/daemon/rest/RequestQueue.h"
+#include "../../src/daemon/rest/RestHandler.h"
+#include "../../src/daemon/rest/RestRouter.h"
+#include "../../src/daemon/rest/TcpServer.h"
+#include "../../src/daemon/rest/protoc/ProtobufHelper.h"
+#include <ace/Init_ACE.h>
+#include <atomic>
+#include <catch.hpp>
+#include <chrono>
+#include <iostream>
+#include <log4cpp/Appender.hh>
+#include <log4cpp/Category.hh>
+#include <log4cpp/OstreamAppender.hh>
+#include <log4cpp/PatternLayout.hh>
+#include <log4cpp/Priority.hh>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+void init()
+{
+	static bool initialized = false;
+	if (!initialized)
+	{
+		initialized = true;
+		ACE::init();
+		using namespace log4cpp;
+		auto consoleLayout = new PatternLayout();
+		consoleLayout->setConversionPattern("%d [%t] %p %c: %m%n");
+		auto consoleAppender = new OstreamAppender("console", &std::cout);
+		consoleAppender->setLayout(consoleLayout);
+
+		Category &root = Category::getRoot();
+		root.addAppender(consoleAppender);
+
+		// Log level
+		Utility::setLogLevel("DEBUG");
+
+		LOG_INF << "Logging process ID:" << getpid();
+	}
+}
+
+std::shared_ptr<HttpRequest> makeRequest(const std::string &method, const std::string &path)
+{
+	Request req;
+	req.http_method = method;
+	req.request_uri = path;
+	return std::make_shared<HttpRequest>(std::move(req), 0);
+}
+
+TEST_CASE("RequestQueue classify", "[RequestQueue]")
+{
+	init();
+
+	REQUIRE(RequestQueue::classify(*makeRequest(web::http::methods::OPTIONS, "/appmesh/applications")) == RequestLane::Health);
+	REQUIRE(RequestQueue::classify(*makeRequest(web::http::methods::HEAD, "/appmesh/applications")) == RequestLane::Health);
+	REQUIRE(RequestQueue::classify(*makeRequest(web::http::methods::GET, "/appmesh/metrics")) == RequestLane::Health);
+	REQUIRE(RequestQueue::classify(*makeRequest(web::http::methods::GET, "/appmesh/app/ping/health")) == RequestLane::Health);
+	REQUIRE(RequestQueue::classify(*makeRequest(web::http::methods::POST, "/appmesh/app/run")) == RequestLane::LongRunning);
+	REQUIRE(RequestQueue::classify(*makeRequest(web::http::methods::POST, "/appmesh/app/syncrun")) == RequestLane::LongRunning);
+	REQUIRE(RequestQueue::classify(*makeRequest(web::http::methods::GET, "/appmesh/file/download")) == RequestLane::LongRunning);
+	REQUIRE(RequestQueue::classify(*makeRequest(web::http::methods::GET, "/appmesh/applications")) == RequestLane::Read);
+	REQUIRE(RequestQueue::classify(*makeRequest(web::http::methods::GET, "/appmesh/app/ping")) == RequestLane::Read);
+	REQUIRE(RequestQueue::classify(*makeRequest(web::http::methods::PUT, "/appmesh/app/ping")) == RequestLane::Mutation);
+	REQUIRE(RequestQueue::classify(*makeRequest(web::http::methods::DEL, "/appmesh/app/ping")) == RequestLane::Mutation);
+}
+
+TEST_CASE("RequestQueue lane capacity", "[RequestQueue]")
+{
+	init();
+
+	// health, read, mutation, long running
+	RequestQueue queue(std::array<size_t, REQUEST_LANE_NUM>{{1, 2, 1, 1}});
+	queue.init(1);
+
+	REQUIRE(queue.enqueue(makeRequest(web::http::methods::GET, "/appmesh/applications")));
+	REQUIRE(queue.enqueue(makeRequest(web::http::methods::GET, "/appmesh/applications")));
+	// read lane full, other lanes are not impacted
+	REQUIRE_FALSE(queue.enqueue(makeRequest(web::http::methods::GET, "/appmesh/applications")));
+	REQUIRE(queue.enqueue(makeRequest(web::http::methods::PUT, "/appmesh/app/ping")));
+	REQUIRE_FALSE(queue.enqueue(makeRequest(web::http::methods::PUT, "/appmesh/app/ping")));
+
+	auto stats = queue.stats(RequestLane::Read);
+	REQUIRE(stats.m_depth == 2);
+	REQUIRE(stats.m_rejected == 1);
+	REQUIRE(queue.stats(RequestLane::Mutation).m_rejected == 1);
+	REQUIRE(queue.stats(RequestLane::Health).m_rejected == 0);
+
+	// dequeue release capacity
+	REQUIRE(queue.dequeue(0) != nullptr);
+	REQUIRE(queue.enqueue(makeRequest(web::http::methods::GET, "/appmesh/applications")));
+
+	// closed queue reject all
+	queue.close();
+	REQUIRE_FALSE(queue.enqueue(makeRequest(web::http::methods::OPTIONS, "/appmesh/applications")));
+	REQUIRE(queue.dequeue(0) == nullptr);
+}
+
+TEST_CASE("RequestQueue lane priority", "[RequestQueue]")
+{
+	init();
+
+	RequestQueue queue(std::array<size_t, REQUEST_LANE_NUM>{{8, 8, 8, 8}});
+	queue.init(1);
+
+	auto mutation = makeRequest(web::http::methods::PUT, "/appmesh/app/ping");
+	auto health = makeRequest(web::http::methods::OPTIONS, "/appmesh/applications");
+	REQUIRE(queue.enqueue(mutation));
+	REQUIRE(queue.enqueue(health));
+	// higher priority lane first, regardless of enqueue order
+	REQUIRE(queue.dequeue(0) == health);
+	REQUIRE(queue.dequeue(0) == mutation);
+}
+
+TEST_CASE("RequestQueue work stealing", "[RequestQueue]")
+{
+	init();
+
+	const int requestNum = 64;
+	RequestQueue queue(std::array<size_t, REQUEST_LANE_NUM>{{requestNum, requestNum, requestNum, requestNum}});
+	queue.init(4);
+
+	// no worker is sleeping, requests are distributed to all workers round robin
+	for (int i = 0; i < requestNum; i++)
+		REQUIRE(queue.enqueue(makeRequest(web::http::methods::GET, "/appmesh/applications")));
+
+	// one worker drain all requests by stealing from the others
+	for (int i = 0; i < requestNum; i++)
+		REQUIRE(queue.dequeue(0) != nullptr);
+	REQUIRE(queue.stats(RequestLane::Read).m_depth == 0);
+	REQUIRE(queue.stats(RequestLane::Read).m_dequeued == requestNum);
+
+	// sleeping worker is woken for new request
+	std::shared_ptr<HttpRequest> received;
+	std::thread worker([&queue, &received]()
+					   { received = queue.dequeue(3); });
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	auto request = makeRequest(web::http::methods::GET, "/appmesh/applications");
+	REQUIRE(queue.enqueue(request));
+	worker.join();
+	REQUIRE(received == request);
+	queue.close();
+}
+
+TEST_CASE("RestRouter static precedence", "[RestRouter]")
+{
+	init();
+
+	std::string hit;
+	RestRouter router;
+	router.add("/appmesh/user/{name}", [&hit](const HttpRequest &)
+			   { hit = "param"; });
+	router.add("/appmesh/user/self", [&hit](const HttpRequest &)
+			   { hit = "static"; });
+	auto request = makeRequest(web::http::methods::GET, "/appmesh/user/self");
+
+	PathParams params;
+	auto handler = router.match("/appmesh/user/self", params);
+	REQUIRE(handler != nullptr);
+	(*handler)(*request);
+	REQUIRE(hit == "static");
+	REQUIRE(params.empty());
+
+	// static prefix of a parameter value still matches the parameter
+	handler = router.match("/appmesh/user/selfish", params);
+	REQUIRE(handler != nullptr);
+	(*handler)(*request);
+	REQUIRE(hit == "param");
+	REQUIRE(params.size() == 1);
+	REQUIRE(params[0].first == "name");
+	REQUIRE(params[0].second == "selfish");
+
+	// parameter does not match empty segment, '*' or more than one segment
+	params.clear();
+	REQUIRE(router.match("/appmesh/user/", params) == nullptr);
+	REQUIRE(router.match("/appmesh/user/a*", params) == nullptr);
+	REQUIRE(router.match("/appmesh/user/admin/x", params) == nullptr);
+	REQUIRE(params.empty());
+
+	// re-add replaces handler without duplicating pattern
+	router.add("/appmesh/user/self", [&hit](const HttpRequest &)
+			   { hit = "replaced"; });
+	REQUIRE(router.patterns().size() == 2);
+	handler = router.match("/appmesh/user/self", params);
+	REQUIRE(handler != nullptr);
+	(*handler)(*request);
+	REQUIRE(hit == "replaced");
+}
+
+TEST_CASE("RestRouter int parameter", "[RestRouter]")
+{
+	init();
+
+	RestRouter router;
+	router.add("/appmesh/item/{id:int}", [](const HttpRequest &) {});
+
+	PathParams params;
+	REQUIRE(router.match("/appmesh/item/123", params) != nullptr);
+	REQUIRE(params.size() == 1);
+	REQUIRE(params[0].first == "id");
+	REQUIRE(params[0].second == "123");
+
+	params.clear();
+	REQUIRE(router.match("/appmesh/item/12a", params) == nullptr);
+	REQUIRE(router.match("/appmesh/item/-1", params) == nullptr);
+	REQUIRE(router.match("/appmesh/item/", params) == nullptr);
+	REQUIRE(params.empty());
+
+	// same position with different parameter name or type conflicts
+	REQUIRE_THROWS_AS(router.add("/appmesh/item/{name}", [](const HttpRequest &) {}), std::invalid_argument);
+	REQUIRE_THROWS_AS(router.add("/appmesh/item/{key:int}/x", [](const HttpRequest &) {}), std::invalid_argument);
+	// same parameter is shared
+	REQUIRE_NOTHROW(router.add("/appmesh/item/{id:int}/detail", [](const HttpRequest &) {}));
+
+	// invalid patterns
+	REQUIRE_THROWS_AS(router.add("/appmesh/x/{id:float}", [](const HttpRequest &) {}), std::invalid_argument);
+	REQUIRE_THROWS_AS(router.add("/appmesh/x/{}", [](const HttpRequest &) {}), std::invalid_argument);
+	REQUIRE_THROWS_AS(router.add("/appmesh/x/{id", [](const HttpRequest &) {}), std::invalid_argument);
+	REQUIRE_THROWS_AS(router.add("/appmesh/x/a{id}", [](const HttpRequest &) {}), std::invalid_argument);
+	REQUIRE_THROWS_AS(router.add("/appmesh/x/{id}a", [](const HttpRequest &) {}), std::invalid_argument);
+	REQUIRE(router.patterns().size() == 2);
+}
+
+TEST_CASE("RestRouter backtracking", "[RestRouter]")
+{
+	init();
+
+	std::string hit;
+	RestRouter router;
+	router.add("/appmesh/app/{name}/output", [&hit](const HttpRequest &)
+			   { hit = "output"; });
+	router.add("/appmesh/app/run", [&hit](const HttpRequest &)
+			   { hit = "run"; });
+	router.add("/appmesh/app/run/{id:int}", [&hit](const HttpRequest &)
+			   { hit = "run id"; });
+	auto request = makeRequest(web::http::methods::GET, "/appmesh/app/run/output");
+
+	// static edge "run" matches first, then fails on "/output" and falls back to {name}
+	PathParams params;
+	auto handler = router.match("/appmesh/app/run/output", params);
+	REQUIRE(handler != nullptr);
+	(*handler)(*request);
+	REQUIRE(hit == "output");
+	REQUIRE(params.size() == 1);
+	REQUIRE(params[0].first == "name");
+	REQUIRE(params[0].second == "run");
+
+	// parameters captured by failed branch are dropped
+	params.clear();
+	handler = router.match("/appmesh/app/run/12", params);
+	REQUIRE(handler != nullptr);
+	(*handler)(*request);
+	REQUIRE(hit == "run id");
+	REQUIRE(params.size() == 1);
+	REQUIRE(params[0].first == "id");
+	REQUIRE(params[0].second == "12");
+
+	params.clear();
+	REQUIRE(router.match("/appmesh/app/run/output/x", params) == nullptr);
+	REQUIRE(router.match("/appmesh/app/run/12/output", params) == nullptr);
+	REQUIRE(params.empty());
+}
+
+TEST_CASE("RestHandler matchETag", "[RestHandler]")
+{
+	init();
+
+	const std::string etag = "\"00000000000000ab\"";
+	REQUIRE(RestHandler::matchETag(etag, etag));
+	REQUIRE(RestHandler::matchETag("*", etag));
+	REQUIRE(RestHandler::matchETag("\"0000000000000001\", " + etag, etag));
+	REQUIRE(RestHandler::matchETag(" W/" + etag + " ", etag));
+	// substring or unquoted tag does not match
+	REQUIRE_FALSE(RestHandler::matchETag("\"00000000000000ab0\"", etag));
+	REQUIRE_FALSE(RestHandler::matchETag("00000000000000ab", etag));
+	REQUIRE_FALSE(RestHandler::matchETag("\"0000000000000001\"", etag));
+	REQUIRE_FALSE(RestHandler::matchETag("", etag));
+}
+
+// registered and reference counted the same way as TcpConnection, reply blocks until released
+class TestConnection : public ACE_Event_Handler, public TcpHandler
+{
+public:
+	explicit TestConnection(std::atomic_int &deleted) : m_replying(false), m_release(false), m_deleted(deleted)
+	{
+		this->reference_counting_policy().value(ACE_Event_Handler::Reference_Counting_Policy::ENABLED);
+		m_handlers.insert(m_id, this);
+	}
+	virtual ~TestConnection() { ++m_deleted; }
+
+	// same as TcpConnection::handle_close(): unregister and release creator reference
+	void close()
+	{
+		m_handlers.erase(m_id);
+		this->remove_reference();
+	}
+
+	std::atomic_bool m_replying;
+	std::atomic_bool m_release;
+
+protected:
+	virtual bool reply(const Response &) override
+	{
+		m_replying = true;
+		while (!m_release)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		return true;
+	}
+	virtual bool waitSendQueueBelow(size_t, std::chrono::milliseconds) override { return true; }
+	virtual ACE_Event_Handler *eventHandler() override { return this; }
+
+private:
+	std::atomic_int &m_deleted;
+};
+
+TEST_CASE("TcpHandler reply registry", "[TcpHandler]")
+{
+	init();
+
+	std::atomic_int deleted(0);
+	auto busy = new TestConnection(deleted);
+	const auto busyId = busy->id();
+	REQUIRE(TcpHandler::connected(busyId));
+
+	std::atomic_bool replied(false);
+	std::thread replier([&]()
+						{ replied = TcpHandler::replyTcp(busyId, Response()); });
+	while (!busy->m_replying)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	// in-flight reply does not block reply to other connections
+	auto idle = new TestConnection(deleted);
+	idle->m_release = true;
+	REQUIRE(TcpHandler::replyTcp(idle->id(), Response()));
+
+	// closed connection is not found, in-flight reply keeps it alive until return
+	busy->close();
+	REQUIRE_FALSE(TcpHandler::connected(busyId));
+	REQUIRE_FALSE(TcpHandler::replyTcp(busyId, Response()));
+	REQUIRE(deleted == 0);
+	busy->m_release = true;
+	replier.join();
+	REQUIRE(replied);
+	REQUIRE(deleted == 1);
+
+	idle->close();
+	REQUIRE(deleted == 2);
+}
+
+TEST_CASE("Wire schema round trip", "[WireSchema]")
+{
+	init();
+
+	Response resp;
+	resp.uuid = "uuid";
+	resp.request_uri = "/appmesh/applications";
+	resp.http_status = 200;
+	resp.body_msg_type = "application/json";
+	resp.body = std::string("{}\0bin", 6);
+	resp.headers["key"] = "value";
+	resp.stream_state = static_cast<int>(StreamState::Chunk);
+	for (const auto schema : {WireSchema::Map, WireSchema::V1})
+	{
+		const auto buffer = resp.serialize(schema);
+		Response decoded;
+		REQUIRE(decoded.deserialize(buffer->data(), static_cast<int>(buffer->size())));
+		REQUIRE(decoded.uuid == resp.uuid);
+		REQUIRE(decoded.request_uri == resp.request_uri);
+		REQUIRE(decoded.http_status == resp.http_status);
+		REQUIRE(decoded.body_msg_type == resp.body_msg_type);
+		REQUIRE(decoded.body == resp.body);
+		REQUIRE(decoded.headers == resp.headers);
+		REQUIRE(decoded.stream_state == resp.stream_state);
+	}
+
+	Request req;
+	req.uuid = "uuid";
+	req.request_uri = "/appmesh/app/myapp";
+	req.http_method = "GET";
+	req.client_addr = "127.0.0.1";
+	req.body = "body";
+	req.headers["key"] = "value";
+	req.querys["query"] = "1";
+	req.deadline = 1700000000000;
+	for (const auto schema : {WireSchema::Map, WireSchema::V1})
+	{
+		const auto buffer = req.serialize(schema);
+		Request decoded;
+		REQUIRE(decoded.deserialize(buffer->data(), static_cast<int>(buffer->size())));
+		REQUIRE(decoded.uuid == req.uuid);
+		REQUIRE(decoded.request_uri == req.request_uri);
+		REQUIRE(decoded.http_method == req.http_method);
+		REQUIRE(decoded.client_addr == req.client_addr);
+		REQUIRE(decoded.body == req.body);
+		REQUIRE(decoded.headers == req.headers);
+		REQUIRE(decoded.querys == req.querys);
+		REQUIRE(decoded.deadline == req.deadline);
+	}
+}
+
+TEST_CASE("Wire schema V1 compatibility", "[WireSchema]")
+{
+	init();
+
+	// older peer: missing tail fields keep default value
+	msgpack::sbuffer shortBuffer;
+	msgpack::packer<msgpack::sbuffer> shortPacker(shortBuffer);
+	shortPacker.pack_array(4);
+	shortPacker.pack(static_cast<int>(WireSchema::V1));
+	shortPacker.pack(std::string("uuid"));
+	shortPacker.pack(std::string("/appmesh/applications"));
+	shortPacker.pack(std::string("GET"));
+	Request shortReq;
+	REQUIRE(shortReq.deserialize(shortBuffer.data(), static_cast<int>(shortBuffer.size())));
+	REQUIRE(shortReq.uuid == "uuid");
+	REQUIRE(shortReq.http_method == "GET");
+	REQUIRE(shortReq.body.empty());
+	REQUIRE(shortReq.deadline == 0);
+
+	// newer peer: unknown tail fields are ignored
+	msgpack::sbuffer longBuffer;
+	msgpack::packer<msgpack::sbuffer> longPacker(longBuffer);
+	longPacker.pack_array(9);
+	longPacker.pack(static_cast<int>(WireSchema::V1));
+	longPacker.pack(std::string("uuid"));
+	longPacker.pack(std::string("/appmesh/applications"));
+	longPacker.pack(200);
+	longPacker.pack(std::string("text/plain"));
+	longPacker.pack(std::string("body"));
+	longPacker.pack(std::map<std::string, std::string>());
+	longPacker.pack(static_cast<int>(StreamState::End));
+	longPacker.pack(std::string("future field"));
+	Response longResp;
+	REQUIRE(longResp.deserialize(longBuffer.data(), static_cast<int>(longBuffer.size())));
+	REQUIRE(longResp.body == "body");
+	REQUIRE(longResp.stream_state == static_cast<int>(StreamState::End));
+
+	// unknown schema version is rejected
+	msgpack::sbuffer versionBuffer;
+	msgpack::packer<msgpack::sbuffer> versionPacker(versionBuffer);
+	versionPacker.pack_array(2);
+	versionPacker.pack(static_cast<int>(WireSchema::V1) + 1);
+	versionPacker.pack(std::string("uuid"));
+	Request versionReq;
+	REQUIRE_FALSE(versionReq.deserialize(versionBuffer.data(), static_cast<int>(versionBuffer.size())));
+}
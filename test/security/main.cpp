@@ -1,7 +1,10 @@
 #define CATCH_CONFIG_MAIN // This tells Catch to provide a main() - only do this in one cpp file
 #include "../../src/common/DateTime.h"
 #include "../../src/common/Utility.h"
+#include "../../src/daemon/security/JwtClaimsCache.h"
 #include "../../src/daemon/security/Security.h"
+#include "../../src/daemon/security/SecuritySnapshot.h"
+#include "../../src/daemon/security/TokenBlacklist.h"
 #include <ace/Init_ACE.h>
 #include <ace/OS.h>
 #include <catch.hpp>
@@ -73,3 +76,183 @@ TEST_CASE("ldapcpp Test", "[security]")
         }
     }
 }
+
+JwtClaims makeClaims(const std::string &userName, std::chrono::seconds ttl = std::chrono::seconds(3600))
+{
+    JwtClaims claims;
+    claims.m_userName = userName;
+    claims.m_userGroup = "admin";
+    claims.m_expiry = std::chrono::system_clock::now() + ttl;
+    return claims;
+}
+
+std::shared_ptr<Security> makeSecurity()
+{
+    nlohmann::json user;
+    user[JSON_KEY_USER_key] = "password";
+    nlohmann::json jsonSecurity;
+    jsonSecurity[JSON_KEY_SECURITY_EncryptKey] = false;
+    jsonSecurity[JSON_KEY_Roles] = nlohmann::json::object();
+    jsonSecurity[JSON_KEY_JWT_Users]["alice"] = user;
+    jsonSecurity[JSON_KEY_JWT_Users]["bob"] = user;
+    return Security::FromJson(jsonSecurity);
+}
+
+TEST_CASE("JwtClaimsCache LRU eviction", "[JwtClaimsCache]")
+{
+    auto cache = JWT_CLAIMS_CACHE::instance();
+    cache->clear();
+
+    for (size_t i = 0; i < MAX_JWT_CLAIMS_CACHE_SIZE; i++)
+        cache->put("token" + std::to_string(i), makeClaims("alice"), cache->generation());
+    REQUIRE(cache->size() == MAX_JWT_CLAIMS_CACHE_SIZE);
+
+    // touch oldest entry, next least recently used entry is evicted
+    JwtClaims claims;
+    REQUIRE(cache->get("token0", claims));
+    cache->put("overflow", makeClaims("bob"), cache->generation());
+    REQUIRE(cache->size() == MAX_JWT_CLAIMS_CACHE_SIZE);
+    REQUIRE(cache->get("token0", claims));
+    REQUIRE_FALSE(cache->get("token1", claims));
+    REQUIRE(cache->get("overflow", claims));
+    REQUIRE(claims.m_userName == "bob");
+
+    // put existing token update claims without growth
+    cache->put("token0", makeClaims("bob"), cache->generation());
+    REQUIRE(cache->size() == MAX_JWT_CLAIMS_CACHE_SIZE);
+    REQUIRE(cache->get("token0", claims));
+    REQUIRE(claims.m_userName == "bob");
+    cache->clear();
+    REQUIRE(cache->size() == 0);
+}
+
+TEST_CASE("JwtClaimsCache expiry", "[JwtClaimsCache]")
+{
+    auto cache = JWT_CLAIMS_CACHE::instance();
+    cache->clear();
+
+    cache->put("expired", makeClaims("alice", std::chrono::seconds(-1)), cache->generation());
+    cache->put("valid", makeClaims("alice"), cache->generation());
+    REQUIRE(cache->size() == 2);
+
+    // expired entry is removed on access
+    JwtClaims claims;
+    REQUIRE_FALSE(cache->get("expired", claims));
+    REQUIRE(cache->size() == 1);
+    REQUIRE(cache->get("valid", claims));
+    REQUIRE(claims.m_userName == "alice");
+    REQUIRE(claims.m_userGroup == "admin");
+    cache->clear();
+}
+
+TEST_CASE("JwtClaimsCache invalidation", "[JwtClaimsCache]")
+{
+    auto cache = JWT_CLAIMS_CACHE::instance();
+    Security::instance(makeSecurity());
+    REQUIRE(cache->size() == 0);
+    cache->put("alice1", makeClaims("alice"), cache->generation());
+    cache->put("alice2", makeClaims("alice"), cache->generation());
+    cache->put("bob1", makeClaims("bob"), cache->generation());
+    REQUIRE(cache->size() == 3);
+
+    JwtClaims claims;
+    SECTION("blacklist")
+    {
+        TOKEN_BLACK_LIST::instance()->addToken("alice1", std::chrono::system_clock::now() + std::chrono::seconds(3600));
+        REQUIRE_FALSE(cache->get("alice1", claims));
+        REQUIRE(cache->get("alice2", claims));
+        REQUIRE(cache->get("bob1", claims));
+    }
+
+    SECTION("lock")
+    {
+        Security::instance()->getUserInfo("alice")->lock();
+        REQUIRE_FALSE(cache->get("alice1", claims));
+        REQUIRE_FALSE(cache->get("alice2", claims));
+        REQUIRE(cache->get("bob1", claims));
+        Security::instance()->getUserInfo("alice")->unlock();
+    }
+
+    SECTION("key update")
+    {
+        Security::instance()->changeUserPasswd("alice", "new password");
+        REQUIRE_FALSE(cache->get("alice1", claims));
+        REQUIRE_FALSE(cache->get("alice2", claims));
+        REQUIRE(cache->get("bob1", claims));
+    }
+
+    SECTION("user delete")
+    {
+        Security::instance()->delUser("bob");
+        REQUIRE(cache->get("alice1", claims));
+        REQUIRE_FALSE(cache->get("bob1", claims));
+    }
+
+    SECTION("security replace")
+    {
+        Security::instance(makeSecurity());
+        REQUIRE(cache->size() == 0);
+    }
+
+    SECTION("stale put")
+    {
+        // token verified before invalidation is not cached after it
+        const auto generation = cache->generation();
+        Security::instance()->getUserInfo("bob")->lock();
+        cache->put("bob2", makeClaims("bob"), generation);
+        REQUIRE_FALSE(cache->get("bob2", claims));
+        cache->put("bob2", makeClaims("bob"), cache->generation());
+        REQUIRE(cache->get("bob2", claims));
+        Security::instance()->getUserInfo("bob")->unlock();
+    }
+    cache->clear();
+}
+
+TEST_CASE("SecuritySnapshot user permission", "[SecuritySnapshot]")
+{
+    SecuritySnapshot snapshot(false);
+    snapshot.grant("alice", {"app-view", "app-reg"});
+    snapshot.grant("bob", {"app-view"});
+    REQUIRE(snapshot.subjectCount() == 2);
+    REQUIRE(snapshot.permissionCount() == 2);
+
+    // keyed by user name, group is ignored
+    REQUIRE(snapshot.hasPermission("alice", "any", "app-reg"));
+    REQUIRE(snapshot.hasPermission("bob", "", "app-view"));
+    REQUIRE_FALSE(snapshot.hasPermission("bob", "alice", "app-reg"));
+    REQUIRE_FALSE(snapshot.hasPermission("carol", "", "app-view"));
+    REQUIRE_FALSE(snapshot.hasPermission("alice", "", "app-delete"));
+}
+
+TEST_CASE("SecuritySnapshot LDAP group permission", "[SecuritySnapshot]")
+{
+    SecuritySnapshot snapshot(true);
+    snapshot.grant("admin", {"app-view", "app-reg"});
+    snapshot.grant("user", {"app-view"});
+
+    // keyed by user group, user name is ignored
+    REQUIRE(snapshot.hasPermission("alice", "admin", "app-reg"));
+    REQUIRE(snapshot.hasPermission("bob", "user", "app-view"));
+    REQUIRE_FALSE(snapshot.hasPermission("bob", "user", "app-reg"));
+    REQUIRE_FALSE(snapshot.hasPermission("admin", "user", "app-reg"));
+    REQUIRE_FALSE(snapshot.hasPermission("alice", "", "app-view"));
+}
+
+TEST_CASE("SecuritySnapshot permission cap", "[SecuritySnapshot]")
+{
+    SecuritySnapshot snapshot(false);
+    std::set<std::string> permissions;
+    for (size_t i = 0; i < MAX_PERMISSION_NUM; i++)
+        permissions.insert("permission-" + std::to_string(i));
+    snapshot.grant("alice", permissions);
+    REQUIRE(snapshot.permissionCount() == MAX_PERMISSION_NUM);
+
+    // permissions beyond the cap are ignored, interned ones are still granted
+    snapshot.grant("bob", {"overflow", "permission-0"});
+    REQUIRE(snapshot.permissionCount() == MAX_PERMISSION_NUM);
+    REQUIRE_FALSE(snapshot.hasPermission("bob", "", "overflow"));
+    REQUIRE(snapshot.hasPermission("bob", "", "permission-0"));
+    REQUIRE_FALSE(snapshot.hasPermission("bob", "", "permission-1"));
+    for (const auto &permission : permissions)
+        REQUIRE(snapshot.hasPermission("alice", "", permission));
+}